@@ -0,0 +1,89 @@
+/* Audio Pacing Test
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*------------------------------------------------------------------.
+| A machine paced by the audio output follows the clock of the      |
+| device, so the player must resample at the nominal ratio: any     |
+| other ratio changes the speed of the emulation and the pitch by   |
+| as much. This runs the resampler of the player on a simulated     |
+| device and a simulated machine that produces a frame whenever 2   |
+| or fewer are queued (the pacing of MachineWindow), and measures   |
+| the ratio and the frame rate after the controller has settled.    |
+|                                                                   |
+| With the rate control on, the controller steers towards its own   |
+| target fill, which the pacing keeps it from reaching, and the     |
+| ratio ends at the 0.5% limit; the result is printed for the       |
+| record. With it off, as MachineWindow sets it for a machine paced |
+| by the player, the ratio must be the nominal one and the machine  |
+| must run at 50 frames per second of the device.                   |
+'------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define private public
+#include "ALSAAudioOutputPlayer.hpp"
+#undef private
+
+#define PACING		2
+#define PERIOD_SIZE	441
+#define SETTLE_SECONDS	120
+#define MEASURE_SECONDS 600
+
+
+static Zeta::Boolean simulate(Zeta::UInt rate, Zeta::Boolean rate_control)
+	{
+	ALSAAudioOutputPlayer player;
+	Zeta::RingBuffer *buffer = player.buffer();
+	Zeta::Int16 output[PERIOD_SIZE];
+	Zeta::UInt64 period, periods = 0, frames = 0, settle = Zeta::UInt64(SETTLE_SECONDS) * rate / PERIOD_SIZE;
+	Zeta::UInt64 total = settle + Zeta::UInt64(MEASURE_SECONDS) * rate / PERIOD_SIZE;
+	double nominal = 44100.0 / rate, fps;
+
+	player._rate = rate;
+	player._ratio = nominal;
+	player.set_rate_control(rate_control);
+
+	for (period = 0; period < total; period++)
+		{
+		while (buffer->fill_count <= PACING)
+			{
+			buffer->try_produce();
+			if (period >= settle) frames++;
+			}
+
+		player.fill(output, PERIOD_SIZE);
+		if (period >= settle) periods++;
+		}
+
+	fps = frames / (double(periods) * PERIOD_SIZE / rate);
+
+	printf(	"%u Hz, rate control %-3s: ratio %.6f (nominal %.6f), %.3f frames/s\n",
+		rate, rate_control ? "on" : "off", player._ratio, nominal, fps);
+
+	return rate_control || (fabs(player._ratio - nominal) < 1e-9 && fabs(fps - 50.0) < 0.005);
+	}
+
+
+int main()
+	{
+	Zeta::Boolean ok = TRUE;
+
+	simulate(44100, TRUE);
+	simulate(48000, TRUE);
+	ok &= simulate(44100, FALSE);
+	ok &= simulate(48000, FALSE);
+
+	puts(ok ? "OK" : "FAILED");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+
+/* test.cpp EOF */
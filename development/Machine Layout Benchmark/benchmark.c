@@ -0,0 +1,196 @@
+/* Machine Layout Benchmark
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*-------------------------------------------------------------------.
+| Machine frames per second of many instances of a model run round-  |
+| robin, one frame each in turn, as separate windows would, with two |
+| ways of allocating them:                                           |
+|                                                                    |
+| pool       As Machine::create: the context and the memory in one   |
+|            block of the machine pool, the context aligned to       |
+|            ZX_SPECTRUM_ALIGNMENT and the memory right after it.    |
+| scattered  The context and the memory in separate blocks of the C  |
+|            heap, the context at the 16-byte alignment malloc       |
+|            guarantees; instance after instance it falls at every   |
+|            offset of a cache line, so its hot fields can straddle  |
+|            one more line.                                          |
+|                                                                    |
+| Every instance boots the ROM of the model up to its menu or the    |
+| BASIC editor. Both layouts must end in the same state; a hash of   |
+| the CPUs and the video output is printed to check it.              |
+'-------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ZX Spectrum.h"
+#include "MachineABI.h"
+#include "MachinePool.h"
+
+#define FRAME_COUNT   50
+#define VIDEO_SIZE    (352 * 296)
+#define AUDIO_SIZE    882
+
+static zuint const models[] = {2, 4}; /* ZX Spectrum 48K (Issue 3), ZX Spectrum + 128K */
+static zuint const counts[] = {1, 16, 64, 256};
+
+static char const *rom_directory;
+static zuint8 roms[4][16384];
+static zuint32 *video_output;
+static zint16 *audio_output;
+
+
+static zboolean load_roms(MachineABI *abi)
+	{
+	char path[1024];
+	zuint index;
+	FILE *file;
+
+	for (index = 0; index < abi->rom_count; index++)
+		{
+		snprintf(path, sizeof(path), "%s/%s.rom", rom_directory, abi->roms[index].file_name);
+
+		if ((file = fopen(path, "rb")) == NULL || fread(roms[index], 1, 16384, file) != 16384)
+			{
+			fprintf(stderr, "Cannot read the ROM: %s\n", path);
+			return FALSE;
+			}
+
+		fclose(file);
+		}
+
+	return TRUE;
+	}
+
+
+static ZXSpectrum *create(MachineABI *abi, zboolean pool, zuint index)
+	{
+	zsize context_size = (abi->context_size + ZX_SPECTRUM_ALIGNMENT - 1) & ~(zsize)(ZX_SPECTRUM_ALIGNMENT - 1);
+	ZXSpectrum *machine;
+	zuint8 *memory;
+	zuint rom;
+
+	if (pool)
+		{
+		machine = machine_pool_allocate(context_size + abi->memory_size, MACHINE_POOL_CURRENT_NODE);
+		memory	= (zuint8 *)machine + context_size;
+		}
+
+	else	{
+		machine = (ZXSpectrum *)((zuint8 *)calloc(1, abi->context_size + 64) + (index % 4) * 16);
+		memory	= calloc(1, abi->memory_size);
+		}
+
+	machine->memory = memory;
+
+	for (rom = 0; rom < abi->rom_count; rom++)
+		memcpy(memory + abi->roms[rom].base_address, roms[rom], abi->roms[rom].size);
+
+	abi->initialize(machine);
+	machine->video_output_buffer = video_output + VIDEO_SIZE * index;
+	machine->audio_output_buffer = audio_output + AUDIO_SIZE * index;
+	abi->power(machine, TRUE);
+	return machine;
+	}
+
+
+static void destroy(ZXSpectrum *machine, zboolean pool, zuint index)
+	{
+	if (pool) machine_pool_free(machine);
+
+	else	{
+		free(machine->memory);
+		free((zuint8 *)machine - (index % 4) * 16);
+		}
+	}
+
+
+static zuint64 hash(zuint64 value, void const *data, zsize size)
+	{
+	zuint8 const *bytes = data;
+
+	while (size--) value = (value ^ *bytes++) * Z_UINT64(1099511628211);
+	return value;
+	}
+
+
+static double seconds(void)
+	{
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+	}
+
+
+static double run(MachineABI *abi, zuint count, zboolean pool, zuint64 *state_hash)
+	{
+	ZXSpectrum **machines = malloc(count * sizeof(ZXSpectrum *));
+	double start;
+	zuint frame, index;
+
+	for (index = 0; index < count; index++) machines[index] = create(abi, pool, index);
+	start = seconds();
+
+	for (frame = 0; frame < FRAME_COUNT; frame++)
+		for (index = 0; index < count; index++)
+			abi->run_1_frame(machines[index]);
+
+	start = seconds() - start;
+	*state_hash = Z_UINT64(14695981039346656037);
+
+	for (index = 0; index < count; index++)
+		{
+		*state_hash = hash(*state_hash, &machines[index]->cpu.state, sizeof(ZZ80State));
+		*state_hash = hash(*state_hash, video_output + VIDEO_SIZE * index, VIDEO_SIZE * sizeof(zuint32));
+		destroy(machines[index], pool, index);
+		}
+
+	free(machines);
+	return (double)count * FRAME_COUNT / start;
+	}
+
+
+int main(int argc, char **argv)
+	{
+	zuint model, count;
+	zuint64 pool_hash, scattered_hash;
+	double pool_speed, scattered_speed;
+	MachineABI *abi;
+
+	rom_directory = argc > 1 ? argv[1] : "../../resources/common/ROMs";
+	video_output  = calloc(counts[3] * VIDEO_SIZE, sizeof(zuint32));
+	audio_output  = calloc(counts[3] * AUDIO_SIZE, sizeof(zint16));
+	printf("%u frames per instance, in machine frames per second:\n", FRAME_COUNT);
+
+	for (model = 0; model < sizeof(models) / sizeof(*models); model++)
+		{
+		abi = &machine_abi_table[models[model]];
+		if (!load_roms(abi)) return EXIT_FAILURE;
+
+		for (count = 0; count < sizeof(counts) / sizeof(*counts); count++)
+			{
+			scattered_speed = run(abi, counts[count], FALSE, &scattered_hash);
+			pool_speed	= run(abi, counts[count], TRUE,	 &pool_hash);
+
+			printf(	"%-25s x%-3u  scattered %7.0f  pool %7.0f  (%+.1f%%)%s\n",
+				abi->model_name, counts[count], scattered_speed, pool_speed,
+				100.0 * (pool_speed / scattered_speed - 1.0),
+				pool_hash == scattered_hash ? "" : "  STATES DIFFER");
+			}
+		}
+
+	free(video_output);
+	free(audio_output);
+	return EXIT_SUCCESS;
+	}
+
+
+/* benchmark.c EOF */
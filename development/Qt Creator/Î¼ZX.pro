@@ -5,7 +5,7 @@
 #-------------------------------------------------
 
 QMAKE_CXXFLAGS += -DCPU_Z80_USE_LOCAL_HEADER
-QMAKE_CFLAGS   += -DCPU_Z80_USE_LOCAL_HEADER
+QMAKE_CFLAGS   += -DCPU_Z80_USE_LOCAL_HEADER -DZX_SPECTRUM_USE_SPECIALIZED_CPU
 INCLUDEPATH += /usr/local/include \
 		/usr/local/include/C++
 
@@ -36,6 +36,7 @@ INCLUDEPATH += \
 
 include($$P_SOURCES/common/common.pri)
 include($$P_SOURCES/common/emulators/emulators.pri)
+include($$P_SOURCES/common/codecs/codecs.pri)
 include($$P_SOURCES/Linux/Linux.pri)
 include($$P_SOURCES/Qt/Qt.pri)
 include($$P_RESOURCES/Qt/UI/UI.pri)
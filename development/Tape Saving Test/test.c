@@ -0,0 +1,265 @@
+/* Tape Saving Test
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*------------------------------------------------------------------.
+| Saves blocks through the SA-BYTES trap of a ZX Spectrum 48K with  |
+| the real ROM, and checks the TAP file and the state in which the  |
+| ROM returns to the caller. A small program in RAM calls SA-BYTES  |
+| as SAVE does, with the header and then the data, and stops in a   |
+| loop; the routine is entered with the interrupts disabled and the |
+| border in a colour other than that of BORDCR.                     |
+|                                                                   |
+| The data block is larger than the chunks in which the trap passes |
+| it on. Two more runs check that a write error clears the carry    |
+| and that SPACE held down ends the save with the BREAK report.     |
+'------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ZX Spectrum.h"
+#include "MachineABI.h"
+#include "codecs/tape/TAP.h"
+
+#define MODEL	       2 /* ZX Spectrum 48K (Issue 3) */
+#define PROGRAM	       0x8000
+#define PROGRAM_END    (PROGRAM + 12)
+#define BREAK_LOOP     0x8020
+#define HEADER	       0x9000
+#define DATA	       0xA000
+#define DATA_SIZE      1000
+#define STACK	       0xFF00
+#define ERROR_STACK    0xFE00
+#define BORDCR	       0x5C48
+#define ERR_NR	       0x5C3A
+#define ERR_SP	       0x5C3D
+#define TAP_PATH       "build/test.tap"
+
+static MachineABI *abi = &machine_abi_table[MODEL];
+static ZXSpectrum *machine;
+static zuint8 *memory;
+static zuint8 rom[16384];
+static zuint32 video_output[352 * 296];
+static zint16 audio_output[882];
+static zuint failures = 0;
+
+
+static void check(zboolean condition, char const *what)
+	{
+	if (!condition)
+		{
+		printf("FAILED: %s\n", what);
+		failures++;
+		}
+	}
+
+
+static zboolean save_tap_block(void *tap, zsize block_size, zsize offset, zuint8 const *data, zsize data_size)
+	{
+	return	(offset || tap_writer_begin_block((TAPWriter *)tap, block_size)) &&
+		tap_writer_write((TAPWriter *)tap, data, data_size);
+	}
+
+
+static zboolean discard_block(void *context, zsize block_size, zsize offset, zuint8 const *data, zsize data_size)
+	{
+	(void)context; (void)block_size; (void)offset; (void)data; (void)data_size;
+	return TRUE;
+	}
+
+
+static zboolean fail_to_save(void *context, zsize block_size, zsize offset, zuint8 const *data, zsize data_size)
+	{
+	(void)context; (void)block_size; (void)offset; (void)data; (void)data_size;
+	return FALSE;
+	}
+
+
+static void set_up(void)
+	{
+	Z80 *cpu;
+
+	memset(machine, 0, abi->context_size);
+	memset(memory, 0, abi->memory_size);
+	memcpy(memory, rom, sizeof(rom));
+	machine->memory = memory;
+	abi->initialize(machine);
+	machine->video_output_buffer = video_output;
+	machine->audio_output_buffer = audio_output;
+	abi->power(machine, TRUE);
+
+	cpu = &machine->cpu;
+	cpu->state.Z_Z80_STATE_MEMBER_PC = PROGRAM;
+	cpu->state.Z_Z80_STATE_MEMBER_SP = STACK;
+	cpu->state.Z_Z80_STATE_MEMBER_IY = ERR_NR;
+	cpu->state.Z_Z80_STATE_MEMBER_IFF1 = cpu->state.Z_Z80_STATE_MEMBER_IFF2 = 0;
+	cpu->state.Z_Z80_STATE_MEMBER_IM = 1;
+	machine->port_fe = 0;
+
+	/*---------------------------------------------------------------.
+	| BORDCR selects a cyan border; ERR_SP points to the address the |
+	| error reports return to.                                       |
+	'---------------------------------------------------------------*/
+	memory[BORDCR]	       = 5 << 3;
+	memory[ERR_NR]	       = 0xFF;
+	memory[ERR_SP]	       = (zuint8)ERROR_STACK;
+	memory[ERR_SP + 1]     = ERROR_STACK >> 8;
+	memory[ERROR_STACK]    = (zuint8)BREAK_LOOP;
+	memory[ERROR_STACK + 1] = BREAK_LOOP >> 8;
+	}
+
+
+static void put_program(zuint16 address, zuint8 flag, zuint16 data, zuint16 size)
+	{
+	zuint8 program[] = {
+		0x3E, flag,				/* LD A,flag	*/
+		0xDD, 0x21, (zuint8)data, data >> 8,	/* LD IX,data	*/
+		0x11, (zuint8)size, size >> 8,		/* LD DE,size	*/
+		0xCD, 0xC2, 0x04			/* CALL SA-BYTES */
+	};
+
+	memcpy(memory + address, program, sizeof(program));
+	}
+
+
+static void run(void)
+	{
+	zuint frame;
+
+	memory[PROGRAM_END] = memory[BREAK_LOOP] = 0x18; /* JR $ */
+	memory[PROGRAM_END + 1] = memory[BREAK_LOOP + 1] = 0xFE;
+
+	for (frame = 0; frame < 2; frame++) abi->run_1_frame(machine);
+	}
+
+
+static void check_exit(zuint16 data, zuint16 size, zuint8 flags)
+	{
+	Z80 *cpu = &machine->cpu;
+
+	check(cpu->state.Z_Z80_STATE_MEMBER_PC == PROGRAM_END, "returns to the caller");
+	check(cpu->state.Z_Z80_STATE_MEMBER_SP == STACK, "leaves the stack balanced");
+	check(cpu->state.Z_Z80_STATE_MEMBER_DE == 0xFFFF, "DE = FFFFh");
+	check(cpu->state.Z_Z80_STATE_MEMBER_IX == (zuint16)(data + size + 1), "IX = start + length + 1");
+	check(cpu->state.Z_Z80_STATE_MEMBER_A == 0 && cpu->state.Z_Z80_STATE_MEMBER_B == 0, "A = B = 0");
+	check(cpu->state.Z_Z80_STATE_MEMBER_F == flags, "flags of the end of SA-BYTES");
+	check(cpu->state.Z_Z80_STATE_MEMBER_IFF1 && cpu->state.Z_Z80_STATE_MEMBER_IFF2, "interrupts enabled");
+	check((machine->port_fe & 7) == 5, "border restored from BORDCR");
+	}
+
+
+static zuint8 checksum(zuint8 flag, zuint8 const *data, zsize size)
+	{
+	while (size) flag ^= data[--size];
+	return flag;
+	}
+
+
+static void check_tap(zuint8 const *header, zuint8 const *data)
+	{
+	static zuint8 tap[2 + 19 + 2 + DATA_SIZE + 2 + 1];
+	FILE *file = fopen(TAP_PATH, "rb");
+	zsize size = file != NULL ? fread(tap, 1, sizeof(tap), file) : 0;
+	zuint8 const *block;
+
+	if (file != NULL) fclose(file);
+	check(size == sizeof(tap) - 1, "size of the TAP file");
+	if (size != sizeof(tap) - 1) return;
+
+	block = tap;
+	check(block[0] == 19 && block[1] == 0, "size of the header block");
+	check(block[2] == 0x00, "flag of the header block");
+	check(!memcmp(block + 3, header, 17), "bytes of the header block");
+	check(block[20] == checksum(0x00, header, 17), "checksum of the header block");
+
+	block = tap + 2 + 19;
+	check(block[0] == (zuint8)(DATA_SIZE + 2) && block[1] == (DATA_SIZE + 2) >> 8, "size of the data block");
+	check(block[2] == 0xFF, "flag of the data block");
+	check(!memcmp(block + 3, data, DATA_SIZE), "bytes of the data block");
+	check(block[3 + DATA_SIZE] == checksum(0xFF, data, DATA_SIZE), "checksum of the data block");
+	}
+
+
+int main(int argc, char **argv)
+	{
+	char const *rom_path = argc > 1 ? argv[1] : "../../resources/common/ROMs/ZX Spectrum (Firmware)(ROM).rom";
+	static TAPWriter tap;
+	zuint8 header[17], data[DATA_SIZE];
+	zuint index;
+	FILE *file;
+
+	if ((file = fopen(rom_path, "rb")) == NULL || fread(rom, 1, sizeof(rom), file) != sizeof(rom))
+		{
+		fprintf(stderr, "Cannot read the ROM: %s\n", rom_path);
+		return EXIT_FAILURE;
+		}
+
+	fclose(file);
+	machine = malloc(abi->context_size);
+	memory	= malloc(abi->memory_size);
+
+	for (index = 0; index < 17; index++) header[index] = (zuint8)(index * 13 + 1);
+	for (index = 0; index < DATA_SIZE; index++) data[index] = (zuint8)(index * 7 ^ index >> 3);
+
+	/*--------------------------------------------------------.
+	| Header and data, each saved by its own call to SA-BYTES |
+	'--------------------------------------------------------*/
+	if (!tap_writer_open(&tap, TAP_PATH))
+		{
+		fprintf(stderr, "Cannot create %s\n", TAP_PATH);
+		return EXIT_FAILURE;
+		}
+
+	set_up();
+	machine->tape_output.save_block = save_tap_block;
+	machine->tape_output.context	= &tap;
+	memcpy(memory + HEADER, header, 17);
+	put_program(PROGRAM, 0x00, HEADER, 17);
+	run();
+	check_exit(HEADER, 17, 0x51);
+
+	machine->cpu.state.Z_Z80_STATE_MEMBER_PC = PROGRAM;
+	machine->port_fe = 0;
+	memcpy(memory + DATA, data, DATA_SIZE);
+	put_program(PROGRAM, 0xFF, DATA, DATA_SIZE);
+	run();
+	check_exit(DATA, DATA_SIZE, 0x51);
+
+	tap_writer_close(&tap);
+	check_tap(header, data);
+
+	/*--------------------------------------.
+	| The block cannot be written: no carry |
+	'--------------------------------------*/
+	set_up();
+	machine->tape_output.save_block = fail_to_save;
+	put_program(PROGRAM, 0xFF, DATA, DATA_SIZE);
+	run();
+	check_exit(DATA, DATA_SIZE, 0x50);
+
+	/*----------------------------------------------------------.
+	| SPACE held down: the ROM reports "D BREAK - CONT repeats" |
+	'----------------------------------------------------------*/
+	set_up();
+	machine->tape_output.save_block = discard_block;
+	zx_spectrum_input(machine, 0, 7, 1, TRUE);
+	put_program(PROGRAM, 0xFF, DATA, DATA_SIZE);
+	run();
+	check(machine->cpu.state.Z_Z80_STATE_MEMBER_PC == BREAK_LOOP, "BREAK returns through ERR_SP");
+	check(memory[ERR_NR] == 0x0C, "BREAK report");
+	check((machine->port_fe & 7) == 5, "border restored before BREAK");
+
+	free(machine);
+	free(memory);
+	printf(failures ? "%u checks failed\n" : "All checks passed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+
+/* test.c EOF */
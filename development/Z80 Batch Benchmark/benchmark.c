@@ -0,0 +1,195 @@
+/* Z80 Batch Benchmark
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*-------------------------------------------------------------------.
+| Machine frames per second of a full batch of Spectrum 48K CPUs run |
+| by z80_batch_run, against the same machines run one by one with    |
+| z80_run. Each machine is the 48K ROM on 48 KiB of RAM, with a      |
+| frame of 69888 cycles that starts with the INT line up for 32      |
+| cycles; there is no ULA, contention or video. The first frames     |
+| boot the ROM, the rest are the BASIC editor waiting for a key.     |
+|                                                                    |
+| In the "same" workload every machine reads no key pressed, so all  |
+| the lanes run the same code. In the "divergent" one each machine   |
+| holds down a different key, so the editors fill different lines    |
+| and the lanes split whenever the ROM reacts to the key.            |
+|                                                                    |
+| The equivalence of both ways of running is checked by the batch    |
+| configuration of the Z80 Differential Test.                        |
+'-------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Z80 Batch.h"
+
+#define FRAME_CYCLES 69888
+#define INT_CYCLES   32
+#define FRAME_COUNT  500
+#define LANE_COUNT   Z80_BATCH_LANE_COUNT
+
+typedef struct {
+	zuint8 memory[65536];
+	zuint8 key_row;
+	zuint8 key_bits;
+} Machine;
+
+static zuint8 rom[16384];
+static Machine machines[LANE_COUNT];
+static Z80 cpus[LANE_COUNT];
+
+
+static zuint8 machine_read(Machine *machine, zuint16 address)
+	{return machine->memory[address];}
+
+
+static void machine_write(Machine *machine, zuint16 address, zuint8 value)
+	{if (address >= 0x4000) machine->memory[address] = value;}
+
+
+static zuint8 machine_in(Machine *machine, zuint16 port)
+	{
+	return (port & 1) || !machine->key_row || ((port >> 8) & machine->key_row)
+		? 0xFF : (zuint8)~machine->key_bits;
+	}
+
+
+static void machine_out(Machine *machine, zuint16 port, zuint8 value)
+	{(void)machine; (void)port; (void)value;}
+
+
+static zuint32 machine_int_data(Machine *machine)
+	{
+	(void)machine;
+	return 0xFF;
+	}
+
+
+static void set_up(zboolean divergent)
+	{
+	zuint index;
+
+	for (index = 0; index < LANE_COUNT; index++)
+		{
+		Machine *machine = &machines[index];
+		Z80 *cpu = &cpus[index];
+
+		memcpy(machine->memory, rom, sizeof(rom));
+		memset(machine->memory + 16384, 0, 49152);
+
+		/*------------------------------------------------------.
+		| A different key of the 40 for each lane, or none: the |
+		| row is selected by a 0 in the high byte of the port.  |
+		'------------------------------------------------------*/
+		machine->key_row  = divergent ? (zuint8)(1 << (index % 8)) : 0;
+		machine->key_bits = divergent ? (zuint8)(1 << (index / 8 % 5)) : 0;
+
+		memset(cpu, 0, sizeof(Z80));
+		cpu->cb_context	 = machine;
+		cpu->cb.read	 = (ZContext16BitAddressRead8Bit )machine_read;
+		cpu->cb.write	 = (ZContext16BitAddressWrite8Bit)machine_write;
+		cpu->cb.in	 = (ZContext16BitAddressRead8Bit )machine_in;
+		cpu->cb.out	 = (ZContext16BitAddressWrite8Bit)machine_out;
+		cpu->cb.int_data = (ZContextRead32Bit		 )machine_int_data;
+		z80_power(cpu, TRUE);
+		}
+	}
+
+
+static double seconds(void)
+	{
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+	}
+
+
+static double run_scalar(void)
+	{
+	double start = seconds();
+	zuint frame, index;
+
+	for (frame = 0; frame < FRAME_COUNT; frame++)
+		for (index = 0; index < LANE_COUNT; index++)
+			{
+			z80_int(&cpus[index], TRUE);
+			z80_run(&cpus[index], INT_CYCLES);
+			z80_int(&cpus[index], FALSE);
+			z80_run(&cpus[index], FRAME_CYCLES - INT_CYCLES);
+			}
+
+	return seconds() - start;
+	}
+
+
+static double run_batch(Z80Batch *batch)
+	{
+	double start = seconds();
+	zuint frame, index;
+
+	for (frame = 0; frame < FRAME_COUNT; frame++)
+		{
+		for (index = 0; index < LANE_COUNT; index++) z80_int(&cpus[index], TRUE);
+		z80_batch_run(batch, INT_CYCLES);
+		for (index = 0; index < LANE_COUNT; index++) z80_int(&cpus[index], FALSE);
+		z80_batch_run(batch, FRAME_CYCLES - INT_CYCLES);
+		}
+
+	return seconds() - start;
+	}
+
+
+int main(int argc, char **argv)
+	{
+	static Z80Batch batch;
+	char const *rom_path = argc > 1 ? argv[1] : "../../resources/common/ROMs/ZX Spectrum (Firmware)(ROM).rom";
+	zuint workload, index;
+	double scalar_time, batch_time;
+	FILE *file;
+
+	if ((file = fopen(rom_path, "rb")) == NULL || fread(rom, 1, sizeof(rom), file) != sizeof(rom))
+		{
+		fprintf(stderr, "Cannot read the ROM: %s\n", rom_path);
+		return EXIT_FAILURE;
+		}
+
+	fclose(file);
+	batch.lane_count       = LANE_COUNT;
+	batch.shared_code_size = 0x4000;
+	for (index = 0; index < LANE_COUNT; index++) batch.lanes[index] = &cpus[index];
+
+	printf("%u machines, %u frames each, in machine frames per second:\n", LANE_COUNT, FRAME_COUNT);
+
+	for (workload = 0; workload < 2; workload++)
+		{
+		set_up(workload);
+		scalar_time = run_scalar();
+		set_up(workload);
+		memset(&batch.statistics, 0, sizeof(batch.statistics));
+		batch_time = run_batch(&batch);
+
+		printf(	"%-9s  z80_run %8.0f  z80_batch_run %8.0f  (x%.2f, %.1f lanes per vector instruction, %.0f%% scalar)\n",
+			workload ? "divergent" : "same",
+			LANE_COUNT * FRAME_COUNT / scalar_time,
+			LANE_COUNT * FRAME_COUNT / batch_time,
+			scalar_time / batch_time,
+			batch.statistics.vector_instructions
+				? (double)batch.statistics.vector_lane_instructions / batch.statistics.vector_instructions
+				: 0.0,
+			100.0 * batch.statistics.scalar_instructions
+				/ (batch.statistics.scalar_instructions + batch.statistics.vector_lane_instructions));
+		}
+
+	return EXIT_SUCCESS;
+	}
+
+
+/* benchmark.c EOF */
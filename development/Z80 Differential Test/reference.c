@@ -0,0 +1,54 @@
+/* Z80 Differential Test - Reference Core
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*-----------------------------------------------------------------.
+| The reference core is the Z80.c of the baseline, built with its  |
+| own Z80.h (see the Makefile), whose Z80 structure is not the one |
+| of the current core. Its API is made static and wrapped here, so |
+| that the test only deals with the state and the cycles, which    |
+| both cores share.                                                |
+'-----------------------------------------------------------------*/
+
+#define CPU_Z80_HIDE_API
+
+#include "Z80.c"
+#include <stdlib.h>
+
+
+void *reference_new(
+	void*			      context,
+	ZContext16BitAddressRead8Bit  read,
+	ZContext16BitAddressWrite8Bit write,
+	ZContext16BitAddressRead8Bit  in,
+	ZContext16BitAddressWrite8Bit out,
+	ZContextRead32Bit	      int_data
+)
+	{
+	Z80 *object = calloc(1, sizeof(Z80));
+
+	object->cb_context  = context;
+	object->cb.read	    = read;
+	object->cb.write    = write;
+	object->cb.in	    = in;
+	object->cb.out	    = out;
+	object->cb.int_data = int_data;
+	return object;
+	}
+
+
+void	   reference_destroy(void *object)		  {free(object);}
+ZZ80State *reference_state  (void *object)		  {return &((Z80 *)object)->state;}
+zsize	  *reference_cycles (void *object)		  {return &((Z80 *)object)->cycles;}
+zsize	   reference_run    (void *object, zsize cycles)  {return z80_run(object, cycles);}
+void	   reference_power  (void *object, zboolean state) {z80_power(object, state);}
+void	   reference_int    (void *object, zboolean state) {z80_int(object, state);}
+void	   reference_nmi    (void *object)		  {z80_nmi(object);}
+
+
+/* reference.c EOF */
@@ -0,0 +1,291 @@
+/* Z80 Differential Test
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*-------------------------------------------------------------------.
+| Runs the current core and the reference core (the baseline core,   |
+| see reference.c) side by side on random memory images and compares |
+| them after every slice of run: cycles, the whole state, the memory |
+| and a hash of all the I/O. The images are mostly random opcodes    |
+| with a high share of prefix bytes, so every dispatch table is hit, |
+| plus a few repeating block instructions behind DD/FD prefixes, and |
+| the INT and NMI lines are toggled between slices. The current core |
+| runs with all the features it was built with (block cache, bulk    |
+| transfers...) while the reference runs plain, so those are checked |
+| at the same time.                                                  |
+|                                                                    |
+| Built with TEST_BATCH, the current core runs a full lockstep batch |
+| (see "Z80 Batch.c") against one reference per lane. The lanes get  |
+| the same image and PC, so they run vectorized until they diverge,  |
+| and different registers, so that they do diverge.                  |
+'-------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef TEST_BATCH
+#	include "Z80 Batch.h"
+#	define LANE_COUNT Z80_BATCH_LANE_COUNT
+#else
+#	include "Z80.h"
+#	define LANE_COUNT 1
+#endif
+
+#define SEED_COUNT	   2000
+#define SLICE_COUNT	   400
+#define PREFIXED_BLOCK_OPS 16
+
+void*	   reference_new     (void*			    context,
+			      ZContext16BitAddressRead8Bit  read,
+			      ZContext16BitAddressWrite8Bit write,
+			      ZContext16BitAddressRead8Bit  in,
+			      ZContext16BitAddressWrite8Bit out,
+			      ZContextRead32Bit		    int_data);
+
+void	   reference_destroy (void* object);
+ZZ80State* reference_state   (void* object);
+zsize*	   reference_cycles  (void* object);
+zsize	   reference_run     (void* object, zsize cycles);
+void	   reference_power   (void* object, zboolean state);
+void	   reference_int     (void* object, zboolean state);
+void	   reference_nmi     (void* object);
+
+typedef struct {
+	zuint8		 memory[65536];
+	zuint64		 io_hash;
+	zsize const*	 cycles;
+	ZZ80State const* state;
+} Bus;
+
+static zuint8 const prefixes[] = {0xCB, 0xDD, 0xED, 0xFD};
+
+
+static zuint8 bus_read(Bus *bus, zuint16 address)
+	{return bus->memory[address];}
+
+
+static void bus_write(Bus *bus, zuint16 address, zuint8 value)
+	{if (address >= 0x4000) bus->memory[address] = value;}
+
+
+static zuint8 bus_in(Bus *bus, zuint16 port)
+	{
+	bus->io_hash = bus->io_hash * 31 + port + *bus->cycles * 7;
+	return (zuint8)(port ^ 0x5A ^ *bus->cycles);
+	}
+
+
+/*-----------------------------------------------------------------.
+| Only the 7 bits of R that count: the cores keep bit 7 apart while |
+| running and the batch restores it after every scalar instruction. |
+'-----------------------------------------------------------------*/
+static void bus_out(Bus *bus, zuint16 port, zuint8 value)
+	{bus->io_hash = bus->io_hash * 37 + port + value + *bus->cycles * 3 + (bus->state->Z_Z80_STATE_MEMBER_R & 127);}
+
+
+static zuint32 bus_int_data(Bus *bus)
+	{
+	(void)bus;
+	return 0xFF;
+	}
+
+
+/*---------------------------------------------------------------------.
+| Random opcodes, a quarter of them prefixes, plus a few LDIR, CPIR,   |
+| INIR... behind an illegal DD/FD prefix, which the bulk transfers run |
+| ahead with the 4 cycles of the prefix still to be added.             |
+'---------------------------------------------------------------------*/
+static void make_image(zuint8 *memory, unsigned int seed)
+	{
+	zuint index;
+	zuint16 address;
+
+	srand(seed * 77);
+
+	for (index = 0; index < 65536; index++)
+		memory[index] = rand() % 4 ? (zuint8)rand() : prefixes[rand() & 3];
+
+	for (index = 0; index < PREFIXED_BLOCK_OPS; index++)
+		{
+		address = (zuint16)(0x4000 + (rand() & 0xBFFC));
+		memory[address	  ] = rand() & 1 ? 0xDD : 0xFD;
+		memory[address + 1] = 0xED;
+		memory[address + 2] = (zuint8)(0xB0 | (rand() & 0x0B));
+		}
+	}
+
+
+static void set_up_cpu(Z80 *cpu, Bus *bus)
+	{
+	zuint index;
+
+	memset(cpu, 0, sizeof(Z80));
+	bus->io_hash	 = 0;
+	bus->cycles	 = &cpu->cycles;
+	bus->state	 = &cpu->state;
+	cpu->cb_context	 = bus;
+	cpu->cb.read	 = (ZContext16BitAddressRead8Bit )bus_read;
+	cpu->cb.write	 = (ZContext16BitAddressWrite8Bit)bus_write;
+	cpu->cb.in	 = (ZContext16BitAddressRead8Bit )bus_in;
+	cpu->cb.out	 = (ZContext16BitAddressWrite8Bit)bus_out;
+	cpu->cb.int_data = (ZContextRead32Bit		 )bus_int_data;
+
+#	ifdef CPU_Z80_USE_BLOCK_CACHE
+		for (index = 0; index < 4; index++) cpu->bank[index] = (zuint16)index;
+		cpu->block_cache = z80_block_cache_new(4);
+#	endif
+
+#	ifdef CPU_Z80_USE_BULK_TRANSFERS
+		for (index = 0; index < 4; index++)
+			{
+			cpu->read_pages [index] = bus->memory + 16384 * index;
+			cpu->write_pages[index] = index ? bus->memory + 16384 * index : NULL;
+			}
+#	endif
+
+	(void)index;
+	z80_power(cpu, TRUE);
+	}
+
+
+static void *set_up_reference(Bus *bus)
+	{
+	void *reference = reference_new(
+		bus,
+		(ZContext16BitAddressRead8Bit )bus_read,
+		(ZContext16BitAddressWrite8Bit)bus_write,
+		(ZContext16BitAddressRead8Bit )bus_in,
+		(ZContext16BitAddressWrite8Bit)bus_out,
+		(ZContextRead32Bit	      )bus_int_data);
+
+	bus->io_hash = 0;
+	bus->cycles  = reference_cycles(reference);
+	bus->state   = reference_state(reference);
+	reference_power(reference, TRUE);
+	return reference;
+	}
+
+
+/*--------------------------------------------------------------.
+| Random registers, IM 1 or IM 2 and I, the same in both cores. |
+| The PC is only drawn for the first lane; the others share it. |
+'--------------------------------------------------------------*/
+static void set_up_registers(ZZ80State *reference, ZZ80State *state, unsigned int seed, zuint lane)
+	{
+	static zuint16 pc;
+	zuint8 *reference_bytes = (zuint8 *)reference, *bytes = (zuint8 *)state;
+	zuint index;
+
+	srand(seed * LANE_COUNT + lane);
+	for (index = 0; index < 16; index++) reference_bytes[index] = bytes[index] = (zuint8)rand();
+	if (!lane) pc = (zuint16)(0x4000 + (rand() & 0xBFFF));
+	reference->Z_Z80_STATE_MEMBER_PC = state->Z_Z80_STATE_MEMBER_PC = pc;
+	reference->Z_Z80_STATE_MEMBER_IM = state->Z_Z80_STATE_MEMBER_IM = (zuint8)(1 + (rand() & 1));
+	reference->Z_Z80_STATE_MEMBER_I	 = state->Z_Z80_STATE_MEMBER_I	= (zuint8)rand();
+	}
+
+
+int main(int argc, char **argv)
+	{
+	static Bus reference_buses[LANE_COUNT], buses[LANE_COUNT];
+	static Z80 cpus[LANE_COUNT];
+	void *references[LANE_COUNT];
+	unsigned int seed, slice, seed_count = argc > 1 ? (unsigned int)atoi(argv[1]) : SEED_COUNT;
+	zsize budget, expected_cycles, cycles;
+	ZZ80State *expected, *state;
+	zuint lane;
+
+#	ifdef TEST_BATCH
+		static Z80Batch batch;
+
+		batch.lane_count = LANE_COUNT;
+		for (lane = 0; lane < LANE_COUNT; lane++) batch.lanes[lane] = &cpus[lane];
+#	endif
+
+	for (seed = 1; seed <= seed_count; seed++)
+		{
+		make_image(buses[0].memory, seed);
+
+		for (lane = 0; lane < LANE_COUNT; lane++)
+			{
+			memcpy(buses[lane].memory, buses[0].memory, 65536);
+			memcpy(reference_buses[lane].memory, buses[0].memory, 65536);
+			set_up_cpu(&cpus[lane], &buses[lane]);
+			references[lane] = set_up_reference(&reference_buses[lane]);
+			set_up_registers(reference_state(references[lane]), &cpus[lane].state, seed, lane);
+			}
+
+		for (slice = 0; slice < SLICE_COUNT; slice++)
+			{
+			budget = 1 + (slice * 7919 + seed) % (slice & 1 ? 400 : 20000);
+
+			for (lane = 0; lane < LANE_COUNT; lane++)
+				{
+				if (slice % 30 == 10) {reference_int(references[lane], TRUE ); z80_int(&cpus[lane], TRUE );}
+				if (slice % 30 == 11) {reference_int(references[lane], FALSE); z80_int(&cpus[lane], FALSE);}
+				if (slice % 101 == 5) {reference_nmi(references[lane]);	       z80_nmi(&cpus[lane]);	    }
+				}
+
+#			ifdef TEST_BATCH
+				z80_batch_run(&batch, budget);
+#			endif
+
+			for (lane = 0; lane < LANE_COUNT; lane++)
+				{
+				expected_cycles = reference_run(references[lane], budget);
+				expected	= reference_state(references[lane]);
+				state		= &cpus[lane].state;
+
+#				ifdef TEST_BATCH
+					cycles = cpus[lane].cycles;
+#				else
+					cycles = z80_run(&cpus[lane], budget);
+#				endif
+
+				if (	expected_cycles != cycles						    ||
+					memcmp(expected, state, sizeof(ZZ80State))			    ||
+					memcmp(reference_buses[lane].memory, buses[lane].memory, 65536)		    ||
+					reference_buses[lane].io_hash != buses[lane].io_hash
+				)
+					{
+					printf("seed %u, slice %u, lane %u: cycles %zu/%zu, PC %04X/%04X, R %02X/%02X, F %02X/%02X\n",
+					       seed, slice, lane, expected_cycles, cycles,
+					       expected->Z_Z80_STATE_MEMBER_PC, state->Z_Z80_STATE_MEMBER_PC,
+					       expected->Z_Z80_STATE_MEMBER_R,  state->Z_Z80_STATE_MEMBER_R,
+					       expected->Z_Z80_STATE_MEMBER_F,  state->Z_Z80_STATE_MEMBER_F);
+
+					puts("FAILED");
+					return EXIT_FAILURE;
+					}
+				}
+			}
+
+		for (lane = 0; lane < LANE_COUNT; lane++)
+			{
+			reference_destroy(references[lane]);
+
+#			ifdef CPU_Z80_USE_BLOCK_CACHE
+				z80_block_cache_destroy(cpus[lane].block_cache);
+#			endif
+			}
+		}
+
+#	ifdef TEST_BATCH
+		printf("%zu instructions run vectorized, for %zu lane-instructions; %zu run scalar\n",
+		       batch.statistics.vector_instructions,
+		       batch.statistics.vector_lane_instructions,
+		       batch.statistics.scalar_instructions);
+#	endif
+
+	printf("OK: %u images, %u slices each, %u lane(s)\n", seed_count, SLICE_COUNT, LANE_COUNT);
+	return EXIT_SUCCESS;
+	}
+
+
+/* test.c EOF */
@@ -1,3 +1,4 @@
 RESOURCES += \
 	$$P_RESOURCES_COMMON/images.qrc \
-	$$P_RESOURCES_COMMON/ROMs.qrc
+	$$P_RESOURCES_COMMON/ROMs.qrc \
+	$$P_RESOURCES_COMMON/shaders.qrc
@@ -6,87 +6,337 @@
 
 #include "system.h"
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <vector>
 #include "ALSAAudioOutputPlayer.hpp"
 
-#define FRAME_SIZE Z_INT16_SIZE * 882
+#define FRAME_SIZE		Z_INT16_SIZE * 882
+#define TARGET_FILL		(882 * 2)
+#define MAXIMUM_DEVIATION	0.005
+#define SMOOTHING		0.1
+#define INTEGRAL_GAIN		0.0001
+#define MACHINE_RATE		44100.0
+#define POLL_TIMEOUT		1000 /* ms */
+
+
+/*----------------------------------------------------------------.
+| Next sample of the machine. On underrun, the last one is held   |
+| until the machine produces more; no stale frame is played back. |
+'----------------------------------------------------------------*/
+Zeta::Int16 ALSAAudioOutputPlayer::next_sample()
+	{
+	Zeta::Int16 sample;
+
+	if (!_buffer.fill_count) return _next;
+	sample = ((Zeta::Int16 *)_buffer.consumption_buffer())[_index];
+
+	if (++_index == 882)
+		{
+		_index = 0;
+		_buffer.try_consume();
+		}
+
+	return sample;
+	}
+
+
+/*-------------------------------------------------------------------.
+| Fills the output by linear interpolation, consuming _ratio input   |
+| samples per output sample, then steers the ratio from the average  |
+| number of input samples queued meanwhile. The gains are per 882    |
+| output samples, so that the response does not depend on the period |
+| size of the device.                                                |
+'-------------------------------------------------------------------*/
+void ALSAAudioOutputPlayer::resample(Zeta::Int16 *output, Zeta::Size count)
+	{
+	double fill = 0, error, weight = double(count) / 882.0, smoothing = SMOOTHING * weight;
+	Zeta::Size index;
+
+	for (index = 0; index < count; index++)
+		{
+		while (_phase >= 1.0)
+			{
+			_last = _next;
+			_next = next_sample();
+			_phase -= 1.0;
+			}
+
+		output[index] = Zeta::Int16(_last + (_next - _last) * _phase);
+		_phase += _ratio;
+		fill += double(_buffer.fill_count * 882 - _index);
+		}
+
+	/*------------------------------------------------------------.
+	| Proportional-integral control: the integral term learns the |
+	| constant drift between the clocks, so the fill settles at   |
+	| the target instead of at an offset proportional to it.      |
+	'------------------------------------------------------------*/
+	if (smoothing > 1.0) smoothing = 1.0;
+	_average_fill += (fill / double(count) - _average_fill) * smoothing;
+
+	if (!_rate_control.load(std::memory_order_relaxed))
+		{
+		_drift = 0.0;
+		_ratio = _nominal_ratio.load(std::memory_order_relaxed) * MACHINE_RATE / double(_rate);
+		return;
+		}
+
+	error = (_average_fill - double(_target_fill)) / double(_target_fill);
+	if (error >  1.0) error =  1.0;
+	if (error < -1.0) error = -1.0;
+	_drift += INTEGRAL_GAIN * weight * error;
+	if (_drift >  MAXIMUM_DEVIATION) _drift =  MAXIMUM_DEVIATION;
+	if (_drift < -MAXIMUM_DEVIATION) _drift = -MAXIMUM_DEVIATION;
+	error = MAXIMUM_DEVIATION * error + _drift;
+	if (error >  MAXIMUM_DEVIATION) error =  MAXIMUM_DEVIATION;
+	if (error < -MAXIMUM_DEVIATION) error = -MAXIMUM_DEVIATION;
+	_ratio = _nominal_ratio.load(std::memory_order_relaxed) * MACHINE_RATE / double(_rate) * (1.0 + error);
+	}
+
+
+/*-----------------------------------------------------------------.
+| Until the machine has queued two frames, the device gets silence |
+| instead of waiting, so that it starts with its buffer full.      |
+'-----------------------------------------------------------------*/
+void ALSAAudioOutputPlayer::fill(Zeta::Int16 *output, Zeta::Size count)
+	{
+	if (!_primed && !(_primed = _buffer.fill_count >= 2))
+		memset(output, 0, count * Z_INT16_SIZE);
+
+	else resample(output, count);
+	}
+
+
+/*----------------------------------------------------------------.
+| Underruns (-EPIPE) and suspends (-ESTRPIPE) are counted and the |
+| device is prepared again; it restarts by itself when its buffer |
+| is full. Returns FALSE if the device can not be recovered.      |
+'----------------------------------------------------------------*/
+Zeta::Boolean ALSAAudioOutputPlayer::recover(int error)
+	{
+	if (error == -EAGAIN) return TRUE;
+	if (error == -EPIPE || error == -ESTRPIPE) _xruns.fetch_add(1, std::memory_order_relaxed);
+	return snd_pcm_recover(_device, error, 1) >= 0;
+	}
+
+
+/*------------------------------------------------------------------.
+| Writes one period, or what remains of it from a short write. With |
+| memory-mapped access, the samples go straight into the buffer of  |
+| the device, in as many pieces as its ring wraps.                  |
+'------------------------------------------------------------------*/
+Zeta::Boolean ALSAAudioOutputPlayer::write_period()
+	{
+	snd_pcm_sframes_t result;
+
+	if (_mmap)
+		{
+		snd_pcm_channel_area_t const *areas;
+		snd_pcm_uframes_t offset, frames = _period_size;
+		int error;
+
+		if ((error = snd_pcm_mmap_begin(_device, &areas, &offset, &frames)) < 0) return recover(error);
+
+		fill((Zeta::Int16 *)((Zeta::UInt8 *)areas->addr + (areas->first + offset * areas->step) / 8), frames);
+		result = snd_pcm_mmap_commit(_device, offset, frames);
+		return result < 0 ? recover(int(result)) : ((snd_pcm_uframes_t)result == frames || recover(-EPIPE));
+		}
+
+	if (!_output_index) fill(_output, _period_size);
+	result = snd_pcm_writei(_device, _output + _output_index, _period_size - _output_index);
+	if (result < 0) return recover(int(result));
+	if ((_output_index += Zeta::Size(result)) == _period_size) _output_index = 0;
+	return TRUE;
+	}
 
 
 void ALSAAudioOutputPlayer::main()
 	{
-	while (_buffer.fill_count < 2)
-		z_wait(1000000000 / 50 + 1000000000 / 100);
+	int count = snd_pcm_poll_descriptors_count(_device);
+	std::vector<struct pollfd> descriptors(count + 1);
+	snd_pcm_sframes_t available, delay;
+	unsigned short events;
+
+	descriptors[0].fd     = _wake;
+	descriptors[0].events = POLLIN;
+	snd_pcm_poll_descriptors(_device, &descriptors[1], count);
 
 	while (!_must_stop)
 		{
-		if (_buffer.fill_count < 2)
-			snd_pcm_writei(_device, _buffer.consumption_buffer(), 882);
+		//---------------------------------------------------.
+		// Write while there is room for whole periods, then |
+		// sleep until the device has played one of them.    |
+		//---------------------------------------------------'
+		if ((available = snd_pcm_avail_update(_device)) < 0)
+			{
+			if (recover(int(available))) continue;
+			break;
+			}
+
+		if ((snd_pcm_uframes_t)available >= _period_size - _output_index)
+			{
+			if (write_period()) continue;
+			break;
+			}
 
-		else	{
-			while (_buffer.fill_count > 3)
-				_buffer.try_consume();
+		if (snd_pcm_state(_device) == SND_PCM_STATE_PREPARED) snd_pcm_start(_device);
+		_available.store(available, std::memory_order_relaxed);
+		if (!snd_pcm_delay(_device, &delay)) _delay.store(delay, std::memory_order_relaxed);
 
-			snd_pcm_writei(_device, _buffer.consumption_buffer(), 882);
-			_buffer.try_consume();
+		if (poll(descriptors.data(), count + 1, POLL_TIMEOUT) < 0)
+			{
+			if (errno == EINTR) continue;
+			break;
 			}
+
+		if (descriptors[0].revents) continue;
+		snd_pcm_poll_descriptors_revents(_device, &descriptors[1], count, &events);
 		}
+
+	//--------------------------------------------------------.
+	// Left on an error that could not be recovered from: the |
+	// machine must not wait for this thread any longer.      |
+	//--------------------------------------------------------'
+	if (!_must_stop) _failed.store(TRUE, std::memory_order_release);
 	}
 
 
-ALSAAudioOutputPlayer::ALSAAudioOutputPlayer() : _device(NULL), playing(false)
+/*-------------------------------------------------------------------.
+| Opens and configures the device. On error, it is left closed and   |
+| errno is set: from snd_pcm_open(), or EINVAL if the device can not |
+| take the format of the machine.                                    |
+'-------------------------------------------------------------------*/
+Zeta::Boolean ALSAAudioOutputPlayer::open_device()
+	{
+	snd_pcm_t *device;
+	snd_pcm_hw_params_t *hardware;
+	snd_pcm_sw_params_t *software;
+	snd_pcm_uframes_t period_size = _configuration.period_size;
+	snd_pcm_uframes_t buffer_size = _configuration.period_size * _configuration.period_count;
+	unsigned int rate = unsigned(MACHINE_RATE);
+	int error;
+
+	if ((error = snd_pcm_open(&device, _configuration.device, SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK)) < 0)
+		{
+		errno = -error;
+		return FALSE;
+		}
+
+	/*----------------------------------------.
+	| Configure device's hardware parameters. |
+	'----------------------------------------*/
+	snd_pcm_hw_params_alloca(&hardware);
+	snd_pcm_hw_params_any(device, hardware);
+
+	_mmap = _configuration.mmap &&
+		!snd_pcm_hw_params_set_access(device, hardware, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+
+	if (	(!_mmap && snd_pcm_hw_params_set_access(device, hardware, SND_PCM_ACCESS_RW_INTERLEAVED) < 0) ||
+		snd_pcm_hw_params_set_format(device, hardware, SND_PCM_FORMAT_S16) < 0		     ||
+		snd_pcm_hw_params_set_channels(device, hardware, 1) < 0				     ||
+		snd_pcm_hw_params_set_rate_near(device, hardware, &rate, NULL) < 0		     ||
+		snd_pcm_hw_params_set_period_size_near(device, hardware, &period_size, NULL) < 0     ||
+		snd_pcm_hw_params_set_buffer_size_near(device, hardware, &buffer_size) < 0	     ||
+		snd_pcm_hw_params(device, hardware) < 0
+	)
+		goto error;
+
+	snd_pcm_hw_params_get_period_size(hardware, &period_size, NULL);
+	snd_pcm_hw_params_get_buffer_size(hardware, &buffer_size);
+
+	/*----------------------------------------.
+	| Configure device's software parameters. |
+	'----------------------------------------*/
+	snd_pcm_sw_params_alloca(&software);
+	snd_pcm_sw_params_current(device, software);
+	snd_pcm_sw_params_set_start_threshold(device, software, buffer_size);
+	snd_pcm_sw_params_set_avail_min(device, software, period_size);
+	if (snd_pcm_sw_params(device, software) < 0 || snd_pcm_prepare(device) < 0) goto error;
+
+	_device	     = device;
+	_period_size = period_size;
+	_buffer_size = buffer_size;
+	_rate	     = rate;
+	return TRUE;
+
+	error:
+	snd_pcm_close(device);
+	errno = EINVAL;
+	return FALSE;
+	}
+
+
+ALSAAudioOutputPlayer::ALSAAudioOutputPlayer()
+: _device(NULL), _wake(-1), _period_size(0), _buffer_size(0), _rate(44100), _mmap(FALSE),
+  _delay(0), _available(0), _xruns(0), _failed(FALSE), _rate_control(TRUE), _target_fill(TARGET_FILL), _index(0), _phase(1.0), _ratio(1.0),
+  _nominal_ratio(1.0), _drift(0.0), _average_fill(TARGET_FILL), _last(0), _next(0), _output(NULL),
+  _output_index(0), playing(false)
 	{
 	void *frames = calloc(1, FRAME_SIZE * 4);
 	_buffer.initialize(frames, Z_INT16_SIZE * 882, 4);
+
+	_configuration.device	    = "default";
+	_configuration.period_size  = 441;
+	_configuration.period_count = 4;
+	_configuration.mmap	    = TRUE;
 	}
 
 
 ALSAAudioOutputPlayer::~ALSAAudioOutputPlayer()
-	{free(_buffer.buffers);}
+	{
+	stop();
+	free(_buffer.buffers);
+	}
+
 
+/*-----------------------------------------------------------.
+| Takes effect the next time the player is started. The name |
+| of the device is not copied.                               |
+'-----------------------------------------------------------*/
+void ALSAAudioOutputPlayer::set_configuration(Configuration const &configuration)
+	{_configuration = configuration;}
 
-void ALSAAudioOutputPlayer::start()
+
+/*-----------------------------------------------------------.
+| A player that has failed is restarted. Returns FALSE if    |
+| the device can not be opened or configured, or on lack of  |
+| memory; errno tells why.                                   |
+'-----------------------------------------------------------*/
+Zeta::Boolean ALSAAudioOutputPlayer::start()
 	{
-	if (!playing)
+	if (playing)
 		{
-		void *parameters;
-		snd_pcm_t *device;
-		unsigned int rate = 44100;
-		snd_pcm_uframes_t size = 882 * 2 * 2;
-
-		int error = snd_pcm_open(&device, "default", SND_PCM_STREAM_PLAYBACK, 0);
-
-		/*----------------------------------------.
-		| Configure device's hardware parameters. |
-		'----------------------------------------*/
-		snd_pcm_hw_params_malloc((snd_pcm_hw_params_t **)&parameters);
-		snd_pcm_hw_params_any(device, (snd_pcm_hw_params_t *)parameters);
-		snd_pcm_hw_params_set_access(device, (snd_pcm_hw_params_t *)parameters, SND_PCM_ACCESS_RW_INTERLEAVED);
-		snd_pcm_hw_params_set_format(device, (snd_pcm_hw_params_t *)parameters, SND_PCM_FORMAT_S16_LE);
-		snd_pcm_hw_params_set_rate_near(device, (snd_pcm_hw_params_t *)parameters, &rate, (int *)NULL);
-		snd_pcm_hw_params_set_channels(device, (snd_pcm_hw_params_t *)parameters, 1);
-		snd_pcm_hw_params_set_buffer_size_near(device, (snd_pcm_hw_params_t *)parameters, &size);
-		size = 882 * 2;
-		snd_pcm_hw_params_set_period_size(device, (snd_pcm_hw_params_t *)parameters, size, 0);
-		snd_pcm_hw_params(device, (snd_pcm_hw_params_t *)parameters);
-		snd_pcm_hw_params_free((snd_pcm_hw_params_t *)parameters);
-
-		/*----------------------------------------.
-		| Configure device's software parameters. |
-		'----------------------------------------*/
-		snd_pcm_sw_params_malloc((snd_pcm_sw_params_t **)&parameters);
-		snd_pcm_sw_params_current(device, (snd_pcm_sw_params_t *)parameters);
-		snd_pcm_sw_params_set_start_threshold(device, (snd_pcm_sw_params_t *)parameters, 882);
-		snd_pcm_sw_params_set_avail_min(device, (snd_pcm_sw_params_t *)parameters, 882);
-		//snd_pcm_sw_params_set_avail_max(device, parameters, size);
-		snd_pcm_sw_params(device, (snd_pcm_sw_params_t *)parameters);
-		snd_pcm_sw_params_free((snd_pcm_sw_params_t *)parameters);
-
-		snd_pcm_prepare(device);
-
-		_device = device;
-		_must_stop = FALSE;
-		playing = TRUE;
-		_thread = std::thread(&ALSAAudioOutputPlayer::main, this);
+		if (!has_failed()) return TRUE;
+		stop();
+		}
+
+	if (!open_device()) return FALSE;
+
+	if (	(_wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1 ||
+		(_output = (Zeta::Int16 *)malloc(_period_size * Z_INT16_SIZE)) == NULL
+	)
+		{
+		int error = errno;
+
+		if (_wake != -1) close(_wake);
+		snd_pcm_close(_device);
+		_wake = -1;
+		errno = error;
+		return FALSE;
 		}
+
+	_output_index = 0;
+	_primed = FALSE;
+	_xruns.store(0, std::memory_order_relaxed);
+	_failed.store(FALSE, std::memory_order_relaxed);
+	_must_stop = FALSE;
+	playing = TRUE;
+	_thread = std::thread(&ALSAAudioOutputPlayer::main, this);
+	return TRUE;
 	}
 
 
@@ -94,9 +344,46 @@ void ALSAAudioOutputPlayer::stop()
 	{
 	if (playing)
 		{
+		eventfd_t value = 1;
+
 		_must_stop = TRUE;
+		eventfd_write(_wake, value);
 		_thread.join();
 		playing = FALSE;
 		snd_pcm_close(_device);
+		close(_wake);
+		free(_output);
+		_wake	= -1;
+		_output = NULL;
 		}
 	}
+
+
+/*-----------------------------------------------------------------.
+| Frames per second the machine produces, 50 unless it is paced by |
+| the display. The controller then only corrects the small error   |
+| of the measured rate. It can be called while playing.            |
+'-----------------------------------------------------------------*/
+void ALSAAudioOutputPlayer::set_frame_rate(double frames_per_second)
+	{_nominal_ratio.store(frames_per_second / 50.0, std::memory_order_relaxed);}
+
+
+void ALSAAudioOutputPlayer::set_rate_control(Zeta::Boolean state)
+	{_rate_control.store(state, std::memory_order_relaxed);}
+
+
+/*---------------------------------------------------------------.
+| The delay is what the device reports: the frames written that  |
+| have not been heard yet. The total output latency adds the     |
+| samples queued by the machine (about 2 frames of 882 samples). |
+'---------------------------------------------------------------*/
+void ALSAAudioOutputPlayer::statistics(Statistics *statistics)
+	{
+	statistics->delay	= _delay.load(std::memory_order_relaxed);
+	statistics->available	= _available.load(std::memory_order_relaxed);
+	statistics->xruns	= _xruns.load(std::memory_order_relaxed);
+	statistics->period_size = _period_size;
+	statistics->buffer_size = _buffer_size;
+	statistics->rate	= _rate;
+	statistics->mmap	= _mmap;
+	}
@@ -7,32 +7,107 @@
 #ifndef __mZX_Linux_ALSAAudioOutputPlayer_HPP
 #define __mZX_Linux_ALSAAudioOutputPlayer_HPP
 
-#include <Z/classes/buffering/RingBuffer.hpp>
+#include "AudioOutputPlayer.hpp"
 #include <alsa/asoundlib.h>
 #include <thread>
+#include <atomic>
 
 #if Z_CPP < Z_CPP11
 #	error "C++11 is needed."
 #endif
 
-class ALSAAudioOutputPlayer {
+/*------------------------------------------------------------------.
+| The frames of the machine are resampled to the rate of the device |
+| by a ratio that a controller keeps within 0.5% of the nominal one |
+| (1, unless the machine runs at another frame rate), so that the   |
+| samples queued stay at the target fill. The device and the        |
+| emulation can then run on different clocks without whole frames   |
+| being dropped or repeated. With the rate control off, the ratio   |
+| is the nominal one and the fill is left to the machine.           |
+|                                                                   |
+| The device is opened in non-blocking mode and the thread sleeps   |
+| in poll() until a period can be written. Underruns and suspends   |
+| are recovered from without stopping; any other error ends the     |
+| thread, and the player reports that it has failed until it is     |
+| started again.                                                    |
+'------------------------------------------------------------------*/
+class ALSAAudioOutputPlayer : public AudioOutputPlayer {
+	public:
+	/*-----------------------------------------------------------.
+	| Sizes are in frames of the device. The device can be any   |
+	| PCM name, including the "null" and "file" plugins, and the |
+	| sizes are rounded to what it supports. Falls back to plain |
+	| writes if the device has no memory-mapped access.          |
+	'-----------------------------------------------------------*/
+	struct Configuration {
+		char const*   device;
+		Zeta::Size    period_size;
+		Zeta::Size    period_count;
+		Zeta::Boolean mmap;
+	};
+
+	struct Statistics {
+		Zeta::Int64   delay;	 /* frames until a sample written now is heard */
+		Zeta::Int64   available; /* frames that could be written now           */
+		Zeta::UInt64  xruns;	 /* underruns and suspends recovered from      */
+		Zeta::Size    period_size;
+		Zeta::Size    buffer_size;
+		Zeta::UInt    rate;
+		Zeta::Boolean mmap;
+	};
+
 	private:
-	std::thread	       _thread;
-	snd_pcm_t*	       _device;
-	Zeta::RingBuffer       _buffer;
-	volatile Zeta::Boolean _must_stop;
+	std::thread		  _thread;
+	snd_pcm_t*		  _device;
+	int			  _wake;
+	Configuration		  _configuration;
+	Zeta::Size		  _period_size;
+	Zeta::Size		  _buffer_size;
+	Zeta::UInt		  _rate;
+	Zeta::Boolean		  _mmap;
+	std::atomic<Zeta::Int64>  _delay;
+	std::atomic<Zeta::Int64>  _available;
+	std::atomic<Zeta::UInt64> _xruns;
+	std::atomic<Zeta::Boolean> _failed;
+	std::atomic<Zeta::Boolean> _rate_control;
+	Zeta::RingBuffer	  _buffer;
+	volatile Zeta::Boolean	  _must_stop;
+	Zeta::Boolean		  _primed;
+	Zeta::Size		  _target_fill;
+	Zeta::Size		  _index;
+	double			  _phase;
+	double			  _ratio;
+	std::atomic<double>	  _nominal_ratio;
+	double			  _drift;
+	double			  _average_fill;
+	Zeta::Int16		  _last;
+	Zeta::Int16		  _next;
+	Zeta::Int16*		  _output;
+	Zeta::Size		  _output_index;
 
 	public:
-	Zeta::Boolean	       playing;
+	Zeta::Boolean		  playing;
 
 	ALSAAudioOutputPlayer();
 	~ALSAAudioOutputPlayer();
 	Zeta::RingBuffer *buffer() {return &_buffer;}
-	void start();
+	void set_configuration(Configuration const &configuration);
+	Zeta::Boolean start();
 	void stop();
+	Zeta::Boolean is_real_time() {return TRUE;}
+	Zeta::Boolean has_failed() {return _failed.load(std::memory_order_acquire);}
+	void set_frame_rate(double frames_per_second);
+	void set_rate_control(Zeta::Boolean state);
+	void statistics(Statistics *statistics);
 
 	private:
 	void main();
+	Zeta::Boolean open_device();
+	Zeta::Boolean recover(int error);
+	Zeta::Boolean write_period();
+	void fill(Zeta::Int16 *output, Zeta::Size count);
+	Zeta::Int16 next_sample();
+	void resample(Zeta::Int16 *output, Zeta::Size count);
 };
 
 #endif // __mZX_Linux_ALSAAudioOutputPlayer_HPP
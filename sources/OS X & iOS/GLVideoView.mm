@@ -448,6 +448,7 @@ using namespace Zeta;
 		if (!_flags.active)
 			{
 			memset(_renderer->buffer.buffers[0], 0, _renderer->input_height * _renderer->input_width * 4 * 3);
+			_renderer->reload();
 
 			#if Z_OS == Z_OS_MAC_OS_X
 				self.needsDisplay = YES;
@@ -30,13 +30,6 @@
 	//----------'
 	Zeta::Value2D<Zeta::Real> _minimumWindowSize;
 
-	//-------------.
-	// I/O Buffers |
-	//-------------'
-	Zeta::TripleBuffer* _keyboardBuffer;
-	Z64Bit*		    _keyboard;
-	Z64Bit		    _keyboardState;
-
 	BOOL		       _smooth;
 	GLVideoView*	       _videoOutputView;
 	CoreAudioOutputPlayer* _audioOutputPlayer;
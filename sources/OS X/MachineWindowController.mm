@@ -165,11 +165,7 @@ Z_INLINE Real step_up(Real n, Real step_size)
 			//_audioOutput = [[ALOutputPlayer alloc] init];
 
 
-			_keyboardBuffer = new TripleBuffer(malloc(Z_UINT64_SIZE * 3), Z_UINT64_SIZE);
-			_keyboard = (Z64Bit *)_keyboardBuffer->production_buffer();
-			memset(_keyboardBuffer->buffers[0], 0xFF, Z_UINT64_SIZE * 3);
-
-			_machine = new Machine(machineABI, _videoOutputView.buffer, _audioOutputPlayer->buffer(), _keyboardBuffer);
+			_machine = new Machine(machineABI, _videoOutputView.buffer, _audioOutputPlayer->buffer());
 
 			/*-----------------.
 			| Load needed ROMs |
@@ -192,8 +188,6 @@ Z_INLINE Real step_up(Real n, Real step_size)
 
 			//machineABI->initialize(_machine);
 
-			_keyboardState.value_uint64 = Type<Zeta::UInt64>::maximum;
-
 			/*NSData *data = [NSData dataWithContentsOfFile: @"/Users/manuel/Desktop/Batman.sna"];
 			ZSNAv48K *sna = (ZSNAv48K *)[data bytes];
 
@@ -224,8 +218,6 @@ Z_INLINE Real step_up(Real n, Real step_size)
 		[_videoOutputView release];
 		delete _audioOutputPlayer;
 		delete _machine;
-		free(_keyboardBuffer->buffers[0]);
-		free(_keyboardBuffer);
 		[super dealloc];
 		}
 
@@ -289,8 +281,8 @@ Z_INLINE Real step_up(Real n, Real step_size)
 #	pragma mark - Overwritten: Input Control
 
 
-#	define KEY_DOWN(line, bit) _keyboardState.array_uint8[line] &= ~(1 << bit)
-#	define KEY_UP(	line, bit) _keyboardState.array_uint8[line] |=  (1 << bit)
+#	define KEY_DOWN(line, bit) _machine->input(line, 1 << bit, TRUE )
+#	define KEY_UP(	line, bit) _machine->input(line, 1 << bit, FALSE)
 
 	- (void) keyDown: (NSEvent *) event
 		{
@@ -362,9 +354,6 @@ Z_INLINE Real step_up(Real n, Real step_size)
 
 			default: break;
 			}
-
-		_keyboard->value_uint64 = _keyboardState.value_uint64;
-		_keyboard = (Z64Bit *)_keyboardBuffer->produce();
 		}
 
 
@@ -430,9 +419,6 @@ Z_INLINE Real step_up(Real n, Real step_size)
 
 			default: break;
 			}
-
-		_keyboard->value_uint64 = _keyboardState.value_uint64;
-		_keyboard = (Z64Bit *)_keyboardBuffer->produce();
 		}
 
 
@@ -448,9 +434,6 @@ Z_INLINE Real step_up(Real n, Real step_size)
 			case kVK_Command: _flags.ignoreKeyboardInput = !!(flags & NSCommandKeyMask); break;
 			default: break;
 			}
-
-		_keyboard->value_uint64 = _keyboardState.value_uint64;
-		_keyboard = (Z64Bit *)_keyboardBuffer->produce();
 		}
 
 
@@ -10,20 +10,72 @@
 #include <Z/classes/mathematics/geometry/euclidean/Rectangle.hpp>
 #include "system.h"
 #include <QTimer>
+#include <QFile>
 
 #define BOUNDS Rectangle<Real>(0.0, 0.0, Real(this->width()), Real(this->height()))
 
 using namespace Zeta;
 
 
-GLVideoOutputView::GLVideoOutputView(QWidget *parent) : QGLWidget(parent)
+/*-------------------------------------------------------------------.
+| Buffer swaps wait for the vertical retrace, so a repaint per timer |
+| timeout of 0 happens exactly once per refresh of the display.      |
+'-------------------------------------------------------------------*/
+static QGLFormat synchronizedFormat()
 	{
+	QGLFormat format;
+
+	format.setSwapInterval(1);
+	return format;
+	}
+
+
+static QByteArray shaderSourceCode(char const *fileName)
+	{
+	QFile file(QString(":/shaders/GLSL/") + fileName);
+
+	file.open(QIODevice::ReadOnly);
+	return file.readAll();
+	}
+
+
+/*-----------------------------------------------------------------.
+| Buffers are swapped by paintGL() itself, and only when something |
+| has been drawn: a presentation that finds no new frame leaves    |
+| the display as it is.                                            |
+'-----------------------------------------------------------------*/
+GLVideoOutputView::GLVideoOutputView(QWidget *parent) : QGLWidget(synchronizedFormat(), parent)
+	{
+	QByteArray sourceCode;
+	std::string *error;
+
 	active = false;
-	timer = new QTimer();
+	synchronized = false;
+	presenting = false;
+	framePending = false;
+	lastRefreshTick = 0;
+	refreshPeriod = 1000000000.0 / 60.0;
+	timer = NULL;
+	setAutoBufferSwap(false);
 
 	makeCurrent();
-	videoOutput = new GLVideoOutput();
+	videoOutput = new GLFrameBufferRenderer();
+	videoOutput->use_pixel_buffer = TRUE;
 	videoOutput->set_geometry(BOUNDS, Z_SCALING_FIT);
+
+	if (!videoOutput->set_vertex_shader((sourceCode = shaderSourceCode("Simple.vsh")).data(), &error))
+		{
+		qWarning("Can not compile OpenGL vertex shader:\n%s", error->c_str());
+		delete error;
+		}
+
+	if (!videoOutput->set_fragment_shader((sourceCode = shaderSourceCode("Simple.fsh")).data(), &error))
+		{
+		qWarning("Can not compile OpenGL fragment shader:\n%s", error->c_str());
+		delete error;
+		}
+
+	videoOutput->create_shader_program();
 	doneCurrent();
 	}
 
@@ -37,14 +89,11 @@ GLVideoOutputView::~GLVideoOutputView()
 
 void GLVideoOutputView::initializeGL()
 	{
-	//QGLFormat format(QGL::SampleBuffers);
-	//format.setSwapInterval(1); // vsync
-	//setFormat(format);
 	}
 
 
 void GLVideoOutputView::paintGL()
-	{videoOutput->draw(FALSE);}
+	{if (videoOutput->draw(presenting)) swapBuffers();}
 
 
 void GLVideoOutputView::resizeGL(int width, int height)
@@ -64,6 +113,7 @@ void GLVideoOutputView::setContentSize(Value2D<Real> contentSize)
 	makeCurrent();
 	videoOutput->set_content_size(contentSize);
 	doneCurrent();
+	updateGL();
 	}
 
 
@@ -72,6 +122,7 @@ void GLVideoOutputView::setScaling(ZKey(SCALING) scaling)
 	makeCurrent();
 	videoOutput->set_geometry(BOUNDS, scaling);
 	doneCurrent();
+	updateGL();
 	}
 
 
@@ -84,15 +135,20 @@ void GLVideoOutputView::setResolutionAndFormat(Value2D<Size> resolution, UInt fo
 	}
 
 
+/*----------------------------------------------------------------.
+| The timer only runs with V-Sync, to repaint once per refresh.   |
+| Otherwise, each frame is presented when the machine produces it |
+| (see frameReady()), and nothing is drawn while none comes.      |
+'----------------------------------------------------------------*/
 void GLVideoOutputView::start()
 	{
 	if (!active)
 		{
 		active = TRUE;
 		timer = new QTimer();
-		timer->setInterval(1000 / 60);
-		connect(timer, SIGNAL(timeout()), this, SLOT(updateGL()));
-		timer->start();
+		timer->setInterval(0);
+		connect(timer, SIGNAL(timeout()), this, SLOT(refresh()));
+		if (isSynchronized()) timer->start();
 		}
 	}
 
@@ -103,7 +159,9 @@ void GLVideoOutputView::stop()
 		{
 		timer->stop();
 		delete timer;
+		timer = NULL;
 		active = FALSE;
+		lastRefreshTick = 0;
 		}
 	}
 
@@ -113,6 +171,7 @@ void GLVideoOutputView::blank()
 	if (!active)
 		{
 		memset(videoOutput->buffer.buffers[0], 0, videoOutput->input_height * videoOutput->input_width * 4 * 3);
+		videoOutput->reload();
 		updateGL();
 		}
 	}
@@ -123,6 +182,78 @@ void GLVideoOutputView::setLinearInterpolation(bool enabled)
 	makeCurrent();
 	videoOutput->set_linear_interpolation(enabled);
 	doneCurrent();
+	updateGL();
+	}
+
+
+/*----------------------------------------------------------------.
+| When synchronized, the view repaints once per refresh and emits |
+| refreshed() after each buffer swap, so that the machine can be  |
+| paced by the display. Without vertical retrace synchronization  |
+| (some drivers ignore the swap interval), frames are presented   |
+| as they are produced.                                           |
+'----------------------------------------------------------------*/
+void GLVideoOutputView::setSynchronized(bool enabled)
+	{
+	synchronized = enabled;
+
+	if (active)
+		{
+		if (isSynchronized()) timer->start();
+		else timer->stop();
+		lastRefreshTick = 0;
+		}
+	}
+
+
+bool GLVideoOutputView::isSynchronized()
+	{return synchronized && format().swapInterval() > 0;}
+
+
+/*--------------------------------------------------------.
+| Refresh rate of the display, measured from the swaps of |
+| the last second or so.                                  |
+'--------------------------------------------------------*/
+Real GLVideoOutputView::refreshRate()
+	{return Real(1000000000.0 / refreshPeriod);}
+
+
+void GLVideoOutputView::refresh()
+	{
+	updateGL();
+
+	UInt64 tick = z_ticks();
+
+	if (lastRefreshTick && tick - lastRefreshTick < 1000000000 / 10)
+		refreshPeriod += (Real(tick - lastRefreshTick) - refreshPeriod) * Real(0.02);
+
+	lastRefreshTick = tick;
+	emit refreshed();
+	}
+
+
+/*---------------------------------------------------------------.
+| Called by the emulation thread each time it produces a frame.  |
+| The GUI thread is asked to present it, once for all the frames |
+| that arrive before it gets to do so.                           |
+'---------------------------------------------------------------*/
+void GLVideoOutputView::frameReady()
+	{
+	if (!framePending.exchange(true))
+		QMetaObject::invokeMethod(this, "present", Qt::QueuedConnection);
+	}
+
+
+void GLVideoOutputView::present()
+	{
+	framePending = false;
+
+	if (active && !isSynchronized())
+		{
+		presenting = true;
+		updateGL();
+		presenting = false;
+		}
 	}
 
 
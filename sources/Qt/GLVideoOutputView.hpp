@@ -9,14 +9,20 @@
 
 #include <QGLWidget>
 #include <QTimer>
-#include "GLVideoOutput.hpp"
+#include "GLFrameBufferRenderer.hpp"
 #include <Z/classes/base/Value2D.hpp>
+#include <atomic>
 
 class GLVideoOutputView : public QGLWidget {Q_OBJECT
 	private:
-	QTimer*	       timer;
-	GLVideoOutput* videoOutput;
-	bool	       active;
+	QTimer*		       timer;
+	GLFrameBufferRenderer* videoOutput;
+	bool		       active;
+	bool		       synchronized;
+	bool		       presenting;
+	std::atomic<bool>      framePending;
+	Zeta::UInt64	       lastRefreshTick;
+	Zeta::Real	       refreshPeriod;
 
 	public:
 	explicit GLVideoOutputView(QWidget *parent = 0);
@@ -35,6 +41,17 @@ class GLVideoOutputView : public QGLWidget {Q_OBJECT
 	void stop();
 	void blank();
 	void setLinearInterpolation(bool enabled);
+	void setSynchronized(bool enabled);
+	bool isSynchronized();
+	Zeta::Real refreshRate();
+	void frameReady();
+
+	signals:
+	void refreshed();
+
+	private slots:
+	void refresh();
+	void present();
 };
 
 #endif // __mZX_Qt_GLVideoOutputView_HPP
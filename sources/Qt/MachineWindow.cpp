@@ -14,6 +14,9 @@
 #include <QFileDialog>
 #include <QInputDialog>
 #include <math.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
 #include <Z/keys/layout.h>
 #include <Z/functions/buffering/ZTripleBuffer.h>
 #include <Z/functions/buffering/ZRingBuffer.h>
@@ -22,6 +25,9 @@
 #include "system.h"
 #include <Z/types/time.h>
 #include "MachineABI.h"
+#include "MachinePool.h"
+#include "FileAudioOutputPlayer.hpp"
+#include "NullAudioOutputPlayer.hpp"
 
 using namespace Zeta;
 
@@ -31,6 +37,91 @@ using namespace Zeta;
 static AboutDialog* aboutDialog = NULL;
 
 
+static bool hasArgument(const char *name)
+	{return QCoreApplication::arguments().contains(name);}
+
+
+/*-----------------------------------------------------------------.
+| The audio goes to the sound device unless the command line says  |
+| otherwise: --audio-output=null, --audio-output=wav:<file> or     |
+| --audio-output=raw:<file> (16-bit little-endian, 44100 Hz, mono) |
+|                                                                  |
+| For the sound device, --audio-output=alsa:<PCM> selects another  |
+| ALSA device than "default", --audio-period=<size>x<count> sets   |
+| the periods in frames of the device (441x4 by default) and       |
+| --audio-no-mmap disables the memory-mapped access.               |
+'-----------------------------------------------------------------*/
+static AudioOutputPlayer *newAudioOutputPlayer()
+	{
+	static QByteArray device("default");
+	QStringList arguments = QCoreApplication::arguments();
+	QString output, period;
+
+	for (int index = 1; index < arguments.size(); index++)
+		{
+		if (arguments[index].startsWith("--audio-output=")) output = arguments[index].mid(15);
+		if (arguments[index].startsWith("--audio-period=")) period = arguments[index].mid(15);
+		}
+
+	if (output == "null") return new NullAudioOutputPlayer();
+
+	if (output.startsWith("wav:") || output.startsWith("raw:")) return new FileAudioOutputPlayer
+		(QFile::encodeName(output.mid(4)).constData(), output.startsWith("wav:"));
+
+	ALSAAudioOutputPlayer *player = new ALSAAudioOutputPlayer();
+	ALSAAudioOutputPlayer::Configuration configuration = {NULL, 441, 4, !hasArgument("--audio-no-mmap")};
+	QStringList sizes = period.split('x');
+
+	if (output.startsWith("alsa:")) device = output.mid(5).toLocal8Bit();
+	configuration.device = device.constData();
+
+	if (sizes.size() == 2 && sizes[0].toUInt() && sizes[1].toUInt())
+		{
+		configuration.period_size  = sizes[0].toUInt();
+		configuration.period_count = sizes[1].toUInt();
+		}
+
+	player->set_configuration(configuration);
+	return player;
+	}
+
+
+/*------------------------------------------------------------------.
+| --joystick=kempston, --joystick=fuller or --joystick=mikrogen     |
+| attaches that interface; the arrow keys and Ctrl then drive the   |
+| joystick instead of the cursor keys of the Spectrum.              |
+'------------------------------------------------------------------*/
+static UInt8 joystickInterfaceArgument()
+	{
+	QStringList arguments = QCoreApplication::arguments();
+	QString interface;
+
+	for (int index = 1; index < arguments.size(); index++)
+		if (arguments[index].startsWith("--joystick=")) interface = arguments[index].mid(11);
+
+	if (interface == "kempston") return ZX_SPECTRUM_JOYSTICK_INTERFACE_KEMPSTON;
+	if (interface == "fuller"  ) return ZX_SPECTRUM_JOYSTICK_INTERFACE_FULLER;
+	if (interface == "mikrogen") return ZX_SPECTRUM_JOYSTICK_INTERFACE_MIKROGEN;
+	return ZX_SPECTRUM_JOYSTICK_INTERFACE_NONE;
+	}
+
+
+/*-----------------------------------------------------------------.
+| --tape-output=<file.tap> appends to that file every block saved  |
+| with the SAVE commands of the 48K BASIC; empty if not given.     |
+'-----------------------------------------------------------------*/
+static QString tapeOutputArgument()
+	{
+	QStringList arguments = QCoreApplication::arguments();
+	QString path;
+
+	for (int index = 1; index < arguments.size(); index++)
+		if (arguments[index].startsWith("--tape-output=")) path = arguments[index].mid(14);
+
+	return path;
+	}
+
+
 Real MachineWindow::currentZoom()
 	{
 	return isFullScreen()
@@ -73,6 +164,10 @@ MachineWindow::MachineWindow(QWidget *parent) :	QMainWindow(parent), ui(new Ui::
 	//setMenuBar(NULL);
 
 	flags.running = false;
+	flags.displayPaced = false;
+	refreshCount = 0;
+	tape = NULL;
+	tapeOutput = NULL;
 
 	//---------------------------------------.
 	// Create the machine and its components |
@@ -81,16 +176,43 @@ MachineWindow::MachineWindow(QWidget *parent) :	QMainWindow(parent), ui(new Ui::
 	ui->videoOutputView->setResolutionAndFormat
 		(Value2D<Size>(Z_ZX_SPECTRUM_SCREEN_WIDTH, Z_ZX_SPECTRUM_SCREEN_HEIGHT), 0);
 
-	audioOutputPlayer = new ALSAAudioOutputPlayer();
+	audioOutputPlayer = newAudioOutputPlayer();
 
-	keyboardBuffer = new TripleBuffer();
-	keyboardBuffer->initialize(malloc(sizeof(zuint64) * 3), sizeof(zuint64));
-	keyboard = (Z64Bit *)keyboardBuffer->production_buffer();
-	memset(keyboardBuffer->buffers[0], 0xFF, sizeof(zuint64) * 3);
+	//--------------------------------------------------------------.
+	// --huge-pages backs the memory of the machines with huge      |
+	// pages, where the kernel has transparent huge pages enabled.  |
+	// --merge-pages offers it to the kernel for merging identical  |
+	// pages (KSM); the result is logged when the window is closed. |
+	//--------------------------------------------------------------'
+	machine_pool_set_huge_pages(hasArgument("--huge-pages"));
+	machine_pool_set_merge_pages(hasArgument("--merge-pages"));
 
 	MachineABI *abi = &machine_abi_table[4];
 
-	machine = new Machine(abi, ui->videoOutputView->buffer(), audioOutputPlayer->buffer(), keyboardBuffer);
+	machine = new Machine(abi, ui->videoOutputView->buffer(), audioOutputPlayer->buffer());
+
+	GLVideoOutputView *videoOutputView = ui->videoOutputView;
+
+	machine->set_frame_observer([videoOutputView] {videoOutputView->frameReady();});
+	machine->set_joystick_interface(joystickInterface = joystickInterfaceArgument());
+
+	QString tapeOutputPath = tapeOutputArgument();
+
+	if (!tapeOutputPath.isEmpty())
+		{
+		tapeOutput = new TAPWriter;
+
+		if (tap_writer_open(tapeOutput, QFile::encodeName(tapeOutputPath).constData()))
+			machine->set_tape_output(tapeOutput);
+
+		else	{
+			QMessageBox::warning(this, tr("Unable to open the tape output"),
+			QString::fromLocal8Bit(strerror(errno)));
+
+			delete tapeOutput;
+			tapeOutput = NULL;
+			}
+		}
 
 	Size index = abi->rom_count;
 	ROM *rom;
@@ -102,41 +224,129 @@ MachineWindow::MachineWindow(QWidget *parent) :	QMainWindow(parent), ui(new Ui::
 		QString fileName;
 		fileName.sprintf("/home/ciro/ROMs/NEStalin/%s.rom", rom->file_name);
 
-		QFile file(fileName);
+		//--------------------------------------------------------.
+		// Every machine maps the same read-only copy of each ROM |
+		//--------------------------------------------------------'
+		ROMImage *image = rom_registry_load(QFile::encodeName(fileName).constData(), rom->size);
 
-		if (!file.open(QIODevice::ReadOnly))
+		if (image == NULL)
 			{
 			QMessageBox::information(this, tr("Unable to open file"),
-			file.errorString());
+			QString::fromLocal8Bit(strerror(errno)));
 			}
 
-		else	{
-			file.read((char *)(machine->context->memory + rom->base_address), rom->size);
-			file.close();
-			}
+		else machine->map_rom(rom, image);
 		}
 
-	keyboardState.value_uint64 = Z_UINT64(0xFFFFFFFFFFFFFFFF);
+	connect(ui->videoOutputView, SIGNAL(refreshed()), this, SLOT(videoOutputRefreshed()));
+	on_actionV_Sync_toggled(ui->actionV_Sync->isChecked());
 	setWindowTitle(QString(abi->model_name));
 	ui->videoOutputView->start();
 	machine->power(ON);
-	audioOutputPlayer->start();
+	startAudioOutput();
+	}
+
+
+/*--------------------------------------------------------------.
+| Players that are not real-time make the machine run at the    |
+| speed they consume, which is as fast as it can go. A player   |
+| that does not start, or whose thread dies later, must not     |
+| hold the machine, which then runs silently on the host clock. |
+'--------------------------------------------------------------*/
+void MachineWindow::startAudioOutput()
+	{
+	AudioOutputPlayer *player = audioOutputPlayer;
+
+	if (player->start()) machine->set_audio_pacing
+		(player->is_real_time() ? 2 : player->buffer()->buffer_count - 1,
+		 [player] {return player->has_failed();});
+
+	else	{
+		QString error = QString::fromLocal8Bit(strerror(errno));
+
+		machine->set_audio_pacing(0);
+		QMessageBox::warning(this, tr("Unable to start the audio output"), error);
+		}
 	}
 
 
 MachineWindow::~MachineWindow()
 	{
+	if (flags.displayPaced) logFrameStatistics();
+	if (hasArgument("--merge-pages")) logMergeStatistics();
+	logAudioStatistics();
 	ui->videoOutputView->stop();
+	machine->power(OFF).wait();
+
+	if (tapeOutput)
+		{
+		machine->set_tape_output(NULL).wait();
+		tap_writer_close(tapeOutput);
+		delete tapeOutput;
+		}
+
 	audioOutputPlayer->stop();
 	delete audioOutputPlayer;
 	//delete audioOutput;
-	machine->power(OFF);
+
+	if (tape)
+		{
+		audio_tape_close(tape);
+		delete tape;
+		}
+
 	delete ui;
 	}
 
 
-#define KEY_DOWN(line, bit) keyboardState.array_uint8[line] &= ~(1 << bit)
-#define KEY_UP(  line, bit) keyboardState.array_uint8[line] |=  (1 << bit)
+/*-----------------------------------------------------------------.
+| Events the machine can not take yet (its queue is full) are kept |
+| and sent again, in order, until it does; a lost release would    |
+| leave the key pressed.                                           |
+'-----------------------------------------------------------------*/
+void MachineWindow::sendInput(UInt8 device, UInt8 mask, bool pressed)
+	{
+	InputEvent event = {device, mask, pressed};
+
+	pendingInput.append(event);
+	if (pendingInput.size() == 1) flushInput();
+	}
+
+
+void MachineWindow::flushInput()
+	{
+	while (	!pendingInput.isEmpty() &&
+		machine->input(pendingInput.first().device, pendingInput.first().mask, pendingInput.first().pressed)
+	)
+		pendingInput.removeFirst();
+
+	if (!pendingInput.isEmpty()) QTimer::singleShot(20, this, SLOT(flushInput()));
+	}
+
+
+bool MachineWindow::sendJoystickInput(int key, bool pressed)
+	{
+	UInt8 mask;
+
+	if (joystickInterface == ZX_SPECTRUM_JOYSTICK_INTERFACE_NONE) return false;
+
+	switch (key)
+		{
+		case Qt::Key_Right:   mask = ZX_SPECTRUM_JOYSTICK_RIGHT; break;
+		case Qt::Key_Left:    mask = ZX_SPECTRUM_JOYSTICK_LEFT;	 break;
+		case Qt::Key_Down:    mask = ZX_SPECTRUM_JOYSTICK_DOWN;	 break;
+		case Qt::Key_Up:      mask = ZX_SPECTRUM_JOYSTICK_UP;	 break;
+		case Qt::Key_Control: mask = ZX_SPECTRUM_JOYSTICK_FIRE;	 break;
+		default: return false;
+		}
+
+	sendInput(ZX_SPECTRUM_INPUT_JOYSTICK, mask, pressed);
+	return true;
+	}
+
+
+#define KEY_DOWN(line, bit) sendInput(line, 1 << bit, true )
+#define KEY_UP(  line, bit) sendInput(line, 1 << bit, false)
 
 
 void MachineWindow::keyPressEvent(QKeyEvent* event)
@@ -144,6 +354,8 @@ void MachineWindow::keyPressEvent(QKeyEvent* event)
 	//int key = event->key();
 	//qDebug("%c => %d\n", (char)key, key);
 	//Qt::Key
+	if (event->isAutoRepeat() || sendJoystickInput(event->key(), true)) return;
+
 	switch (event->key())
 		{
 		case Qt::Key_Escape:
@@ -228,14 +440,13 @@ void MachineWindow::keyPressEvent(QKeyEvent* event)
 
 		default: break;
 		}
-
-	keyboard->value_uint64 = keyboardState.value_uint64;
-	keyboard = (Z64Bit *)keyboardBuffer->produce();
 	}
 
 
 void MachineWindow::keyReleaseEvent(QKeyEvent* event)
 	{
+	if (event->isAutoRepeat() || sendJoystickInput(event->key(), false)) return;
+
 	switch (event->key())
 		{
 		// Line 0
@@ -296,9 +507,6 @@ void MachineWindow::keyReleaseEvent(QKeyEvent* event)
 
 		default: break;
 		}
-
-	keyboard->value_uint64 = keyboardState.value_uint64;
-	keyboard = (Z64Bit *)keyboardBuffer->produce();
 	}
 
 
@@ -322,10 +530,102 @@ void MachineWindow::resizeEvent(QResizeEvent *)
 	}
 
 
+void MachineWindow::logFrameStatistics()
+	{
+	Machine::FrameStatistics statistics;
+
+	machine->frame_statistics(&statistics).wait();
+
+	if (statistics.frames) qDebug
+		("%llu refreshes, %llu frames, %llu repeated; "
+		 "frame time %.2f/%.2f/%.2f ms, refresh time %.2f/%.2f/%.2f ms (minimum/mean/maximum)",
+		 (unsigned long long)statistics.refreshes,
+		 (unsigned long long)statistics.frames,
+		 (unsigned long long)statistics.repeated_frames,
+		 statistics.minimum_frame_time / 1000000.0,
+		 statistics.total_frame_time / 1000000.0 / statistics.frames,
+		 statistics.maximum_frame_time / 1000000.0,
+		 statistics.minimum_refresh_time / 1000000.0,
+		 statistics.total_refresh_time / 1000000.0 / statistics.refreshes,
+		 statistics.maximum_refresh_time / 1000000.0);
+	}
+
+
+/*-----------------------------------------------------------------.
+| The saving is the number of pages that point to a merged page    |
+| instead of having their own copy; the ratio, how many pages each |
+| merged page saves. Both are for the whole system.                |
+'-----------------------------------------------------------------*/
+void MachineWindow::logMergeStatistics()
+	{
+	MachinePoolMergeStatistics statistics;
+	long pageSize = sysconf(_SC_PAGESIZE);
+
+	if (!machine_pool_merge_statistics(&statistics))
+		{
+		qDebug("Page merging statistics not available (is KSM enabled in the kernel?)");
+		return;
+		}
+
+	qDebug
+		("%llu pages of this process merged; %llu merged pages in the system save %llu pages (%.1f MiB), "
+		 "ratio %.2f; %llu full scans, scanner CPU time %.2f s",
+		 (unsigned long long)statistics.merged_pages,
+		 (unsigned long long)statistics.shared_pages,
+		 (unsigned long long)statistics.sharing_pages,
+		 statistics.sharing_pages * pageSize / (1024.0 * 1024.0),
+		 statistics.shared_pages
+			? double(statistics.sharing_pages) / statistics.shared_pages
+			: 0.0,
+		 (unsigned long long)statistics.full_scans,
+		 statistics.scanner_time / 1000000000.0);
+	}
+
+
+/*-----------------------------------------------------------------.
+| What the ALSA device was configured to, and how it went: the     |
+| delay and the room left in its buffer when last written, and the |
+| underruns and suspends recovered from.                           |
+'-----------------------------------------------------------------*/
+void MachineWindow::logAudioStatistics()
+	{
+	ALSAAudioOutputPlayer *player = dynamic_cast<ALSAAudioOutputPlayer *>(audioOutputPlayer);
+	ALSAAudioOutputPlayer::Statistics statistics;
+
+	if (player == NULL) return;
+	player->statistics(&statistics);
+
+	qDebug
+		("ALSA: %u Hz, period of %lu frames, buffer of %lu frames, %s access; "
+		 "delay %lld frames, %lld available, %llu xruns",
+		 statistics.rate,
+		 (unsigned long)statistics.period_size,
+		 (unsigned long)statistics.buffer_size,
+		 statistics.mmap ? "mmap" : "read/write",
+		 (long long)statistics.delay,
+		 (long long)statistics.available,
+		 (unsigned long long)statistics.xruns);
+	}
+
+
 void MachineWindow::aboutDialogClosed()
 	{aboutDialog = NULL;}
 
 
+/*----------------------------------------------------------------.
+| Every refresh of the display runs one frame when display-paced; |
+| the audio follows the measured refresh rate.                    |
+'----------------------------------------------------------------*/
+void MachineWindow::videoOutputRefreshed()
+	{
+	if (!flags.displayPaced) return;
+	machine->refresh();
+
+	if (!(++refreshCount % 64))
+		audioOutputPlayer->set_frame_rate(ui->videoOutputView->refreshRate());
+	}
+
+
 void MachineWindow::on_actionFileNewWindow_triggered()
 	{
 	}
@@ -334,7 +634,31 @@ void MachineWindow::on_actionFileNewWindow_triggered()
 void MachineWindow::on_actionFileOpen_triggered()
 	{
 	QString fileName = QFileDialog::getOpenFileName
-		(this, tr("Open ROM Image"), "", tr("NES ROM Images (*.nes)"));
+		(this, tr("Open Tape"), "", tr("Tape Audio (*.wav *.raw)"));
+
+	if (fileName.isEmpty()) return;
+
+	AudioTape *newTape = new AudioTape;
+
+	if (!audio_tape_open
+		(newTape, QFile::encodeName(fileName).constData(),
+		 machine->context->cycles->per_frame * 50)
+	)
+		{
+		delete newTape;
+		QMessageBox::information(this, tr("Unable to open file"), fileName);
+		return;
+		}
+
+	machine->set_tape_input(newTape).wait();
+
+	if (tape)
+		{
+		audio_tape_close(tape);
+		delete tape;
+		}
+
+	tape = newTape;
 	}
 
 
@@ -357,7 +681,7 @@ void MachineWindow::on_actionMachinePower_toggled(bool enabled)
 
 	if (state)
 		{
-		audioOutputPlayer->start();
+		startAudioOutput();
 		ui->videoOutputView->start();
 		}
 
@@ -382,7 +706,7 @@ void MachineWindow::on_actionMachinePause_toggled(bool enabled)
 		audioOutputPlayer->stop();
 		}
 	else	{
-		audioOutputPlayer->start();
+		startAudioOutput();
 		ui->videoOutputView->start();
 		}
 	}
@@ -398,6 +722,26 @@ void MachineWindow::on_actionMachineReset_triggered()
 	}
 
 
+/*---------------------------------------------------------------.
+| With V-Sync, the machine is paced by the display if the buffer |
+| swaps really wait for the vertical retrace; otherwise it keeps |
+| being paced by the audio output. Only in the first case is     |
+| there a drift between the clocks for the player to absorb.     |
+'---------------------------------------------------------------*/
+void MachineWindow::on_actionV_Sync_toggled(bool enabled)
+	{
+	if (flags.displayPaced && !enabled) logFrameStatistics();
+	ui->videoOutputView->setSynchronized(enabled);
+	flags.displayPaced = ui->videoOutputView->isSynchronized() && audioOutputPlayer->is_real_time();
+	machine->set_display_pacing(flags.displayPaced);
+
+	audioOutputPlayer->set_frame_rate
+		(flags.displayPaced ? ui->videoOutputView->refreshRate() : 50.0);
+
+	audioOutputPlayer->set_rate_control(flags.displayPaced);
+	}
+
+
 void MachineWindow::on_actionViewFullScreen_toggled(bool enabled)
 	{
 	if (enabled)
@@ -10,6 +10,7 @@
 #include <QMainWindow>
 #include <QFrame>
 #include <QTimer>
+#include <QList>
 #include <Z/types/buffering.h>
 #include "Machine.hpp"
 #include "ALSAAudioOutputPlayer.hpp"
@@ -17,6 +18,13 @@
 namespace Ui {class MachineWindow;}
 
 class MachineWindow : public QMainWindow {Q_OBJECT
+	private:
+	struct InputEvent {
+		Zeta::UInt8 device;
+		Zeta::UInt8 mask;
+		bool	    pressed;
+	};
+
 	public:
 	explicit MachineWindow(QWidget *parent = 0);
 	~MachineWindow();
@@ -24,23 +32,32 @@ class MachineWindow : public QMainWindow {Q_OBJECT
 
 	private:
 	Ui::MachineWindow*     ui;
-	ALSAAudioOutputPlayer* audioOutputPlayer;
+	AudioOutputPlayer*     audioOutputPlayer;
 	Machine*	       machine;
+	AudioTape*	       tape;
+	TAPWriter*	       tapeOutput;
 	void*		       memory;
 	pthread_t	       thread;
-	Zeta::TripleBuffer*    keyboardBuffer;
-	Z64Bit*		       keyboard;
-	Z64Bit		       keyboardState;
 	QFrame*		       fullScreenMenuFrame;
 	volatile bool	       mustStop;
+	Zeta::UInt	       refreshCount;
+	Zeta::UInt8	       joystickInterface;
+	QList<InputEvent>      pendingInput;
 
-	struct {bool running :1;
+	struct {bool running	  :1;
+		bool displayPaced :1;
 	} flags;
 
 	void runMachine();
 	void stopMachine();
 	Zeta::Real currentZoom();
 	void setZoom(Zeta::Real);
+	void logFrameStatistics();
+	void logMergeStatistics();
+	void logAudioStatistics();
+	void startAudioOutput();
+	void sendInput(Zeta::UInt8 device, Zeta::UInt8 mask, bool pressed);
+	bool sendJoystickInput(int key, bool pressed);
 
 	protected:
 	void keyPressEvent	   (QKeyEvent*);
@@ -50,12 +67,15 @@ class MachineWindow : public QMainWindow {Q_OBJECT
 
 	private slots:
 	void aboutDialogClosed();
+	void videoOutputRefreshed();
+	void flushInput();
 	void on_actionFileNewWindow_triggered();
 	void on_actionFileOpen_triggered();
 	void on_actionFileQuit_triggered();
 	void on_actionMachinePower_toggled(bool);
 	void on_actionMachinePause_toggled(bool);
 	void on_actionMachineReset_triggered();
+	void on_actionV_Sync_toggled(bool);
 	void on_actionViewFullScreen_toggled(bool);
 	void on_actionViewZoomIn_triggered();
 	void on_actionViewZoomOut_triggered();
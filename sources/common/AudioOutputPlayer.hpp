@@ -0,0 +1,44 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/AudioOutputPlayer.hpp
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#ifndef __mZX_common_AudioOutputPlayer_HPP
+#define __mZX_common_AudioOutputPlayer_HPP
+
+#include <Z/classes/buffering/RingBuffer.hpp>
+
+/*------------------------------------------------------------------.
+| Consumer of the audio frames of a machine (882 samples, 16 bits,  |
+| mono, 44100 Hz). The machine produces into the ring buffer of the |
+| player, which takes the frames from its own thread.               |
+|                                                                   |
+| A real-time player consumes at the rate of a device, so the       |
+| machine keeps a couple of frames queued. If the machine runs on   |
+| another clock, the player steers its resampling ratio to absorb   |
+| the drift. When the machine is paced by the player instead, it    |
+| follows the clock of the device and there is no drift to absorb:  |
+| set_rate_control(FALSE) then makes the player resample at the     |
+| nominal ratio. The others consume as fast as they can; a machine  |
+| paced by them (set_audio_pacing with all but one of their         |
+| buffers) runs at full speed and loses no frame.                   |
+|                                                                   |
+| start() returns FALSE if the player can not start, and errno      |
+| tells why. has_failed() can be called from any thread and returns |
+| TRUE once the player has stopped consuming on its own, after an   |
+| error.                                                            |
+'------------------------------------------------------------------*/
+class AudioOutputPlayer {
+	public:
+	virtual ~AudioOutputPlayer() {}
+	virtual Zeta::RingBuffer *buffer() = 0;
+	virtual Zeta::Boolean start() = 0;
+	virtual void stop() = 0;
+	virtual Zeta::Boolean is_real_time() = 0;
+	virtual void set_frame_rate(double frames_per_second) {(void)frames_per_second;}
+	virtual void set_rate_control(Zeta::Boolean state) {(void)state;}
+	virtual Zeta::Boolean has_failed() {return FALSE;}
+};
+
+#endif // __mZX_common_AudioOutputPlayer_HPP
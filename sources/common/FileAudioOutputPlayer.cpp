@@ -0,0 +1,173 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/FileAudioOutputPlayer.cpp
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "system.h"
+#include "FileAudioOutputPlayer.hpp"
+
+#define FRAME_SAMPLES	882
+#define FRAME_SIZE	(Z_INT16_SIZE * FRAME_SAMPLES)
+#define BUFFER_COUNT	64
+#define SAMPLE_RATE	44100
+#define HEADER_SIZE	44
+#define STDIO_BUFFER	(1024 * 256)
+#define IDLE_TICKS	(1000000000 / 1000)
+
+using namespace Zeta;
+
+
+static void store_16(UInt8 *data, UInt16 value)
+	{
+	data[0] = UInt8(value);
+	data[1] = UInt8(value >> 8);
+	}
+
+
+static void store_32(UInt8 *data, UInt32 value)
+	{
+	store_16(data,	   UInt16(value));
+	store_16(data + 2, UInt16(value >> 16));
+	}
+
+
+/*--------------------------------------------------------------.
+| Canonical 44-byte header of a PCM WAV file: one channel of 16 |
+| bits at 44100 Hz, followed by _data_size bytes of samples.    |
+'--------------------------------------------------------------*/
+void FileAudioOutputPlayer::write_header()
+	{
+	UInt8 header[HEADER_SIZE];
+	UInt32 data_size = _data_size < 0xFFFFFFFF - HEADER_SIZE ? UInt32(_data_size) : 0xFFFFFFFF - HEADER_SIZE;
+
+	memcpy	(header,      "RIFF", 4);
+	store_32(header +  4, data_size + HEADER_SIZE - 8);
+	memcpy	(header +  8, "WAVEfmt ", 8);
+	store_32(header + 16, 16);
+	store_16(header + 20, 1);		/* PCM		*/
+	store_16(header + 22, 1);		/* channels	*/
+	store_32(header + 24, SAMPLE_RATE);
+	store_32(header + 28, SAMPLE_RATE * 2); /* bytes/second */
+	store_16(header + 32, 2);		/* bytes/frame	*/
+	store_16(header + 34, 16);		/* bits/sample	*/
+	memcpy	(header + 36, "data", 4);
+	store_32(header + 40, data_size);
+	fwrite(header, HEADER_SIZE, 1, _file);
+	}
+
+
+/*----------------------------------------------------------------.
+| Writes all the frames queued. Samples are stored little-endian, |
+| so they are swapped on big-endian hosts. Returns FALSE if there |
+| were none.                                                      |
+'----------------------------------------------------------------*/
+Boolean FileAudioOutputPlayer::write_frames()
+	{
+	static UInt16 const endianness = 1;
+	UInt8 swapped[FRAME_SIZE];
+	Boolean written = FALSE;
+	UInt8 *samples;
+	Size index;
+
+	while (_buffer.fill_count)
+		{
+		samples = (UInt8 *)_buffer.consumption_buffer();
+
+		if (!*(UInt8 const *)&endianness)
+			{
+			for (index = 0; index < FRAME_SIZE; index += 2)
+				{
+				swapped[index]	   = samples[index + 1];
+				swapped[index + 1] = samples[index];
+				}
+
+			samples = swapped;
+			}
+
+		fwrite(samples, FRAME_SIZE, 1, _file);
+		_data_size += FRAME_SIZE;
+		_buffer.try_consume();
+		written = TRUE;
+		}
+
+	return written;
+	}
+
+
+void FileAudioOutputPlayer::main()
+	{
+	while (!_must_stop) if (!write_frames()) z_wait(IDLE_TICKS);
+	write_frames();
+	}
+
+
+FileAudioOutputPlayer::FileAudioOutputPlayer(char const *path, Boolean wav)
+: _path(strdup(path)), _wav(wav), _file(NULL), _data_size(0), playing(FALSE)
+	{
+	void *frames = calloc(BUFFER_COUNT, FRAME_SIZE);
+	_buffer.initialize(frames, FRAME_SIZE, BUFFER_COUNT);
+	}
+
+
+FileAudioOutputPlayer::~FileAudioOutputPlayer()
+	{
+	stop();
+	if (_file != NULL) fclose(_file);
+	free(_buffer.buffers);
+	free(_path);
+	}
+
+
+/*-----------------------------------------------------------.
+| The file is created the first time; starting again after a |
+| stop appends to it. Returns FALSE if it can not be opened, |
+| and errno tells why.                                       |
+'-----------------------------------------------------------*/
+Boolean FileAudioOutputPlayer::start()
+	{
+	if (playing) return TRUE;
+
+	if (_file == NULL)
+		{
+		if ((_file = fopen(_path, "wb")) == NULL) return FALSE;
+		setvbuf(_file, NULL, _IOFBF, STDIO_BUFFER);
+		_data_size = 0;
+		if (_wav) write_header();
+		}
+
+	_must_stop = FALSE;
+	playing = TRUE;
+	_thread = std::thread(&FileAudioOutputPlayer::main, this);
+	return TRUE;
+	}
+
+
+/*-------------------------------------------------------------.
+| Writes what the machine has queued, then completes the WAV   |
+| header and flushes the file, which is left valid after every |
+| stop.                                                        |
+'-------------------------------------------------------------*/
+void FileAudioOutputPlayer::stop()
+	{
+	if (playing)
+		{
+		_must_stop = TRUE;
+		_thread.join();
+		playing = FALSE;
+
+		if (_wav)
+			{
+			fseek(_file, 0, SEEK_SET);
+			write_header();
+			fseek(_file, 0, SEEK_END);
+			}
+
+		fflush(_file);
+		}
+	}
+
+
+// common/FileAudioOutputPlayer.cpp EOF
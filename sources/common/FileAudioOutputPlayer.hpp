@@ -0,0 +1,46 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/FileAudioOutputPlayer.hpp
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#ifndef __mZX_common_FileAudioOutputPlayer_HPP
+#define __mZX_common_FileAudioOutputPlayer_HPP
+
+#include "AudioOutputPlayer.hpp"
+#include <stdio.h>
+#include <thread>
+
+/*-----------------------------------------------------------------.
+| Streams the audio to a WAV or raw (16-bit little-endian) file.   |
+| The writes are done by the thread of the player through a large  |
+| stdio buffer, never by the emulation thread. The WAV header gets |
+| its sizes when the player is stopped.                            |
+'-----------------------------------------------------------------*/
+class FileAudioOutputPlayer : public AudioOutputPlayer {
+	private:
+	std::thread	       _thread;
+	Zeta::RingBuffer       _buffer;
+	char*		       _path;
+	Zeta::Boolean	       _wav;
+	FILE*		       _file;
+	Zeta::UInt64	       _data_size;
+	volatile Zeta::Boolean _must_stop;
+
+	public:
+	Zeta::Boolean	       playing;
+
+	FileAudioOutputPlayer(char const *path, Zeta::Boolean wav);
+	~FileAudioOutputPlayer();
+	Zeta::RingBuffer *buffer() {return &_buffer;}
+	Zeta::Boolean start();
+	void stop();
+	Zeta::Boolean is_real_time() {return FALSE;}
+
+	private:
+	void main();
+	Zeta::Boolean write_frames();
+	void write_header();
+};
+
+#endif // __mZX_common_FileAudioOutputPlayer_HPP
@@ -16,9 +16,16 @@ static GLfloat const vertices[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f,
 
 
 GLFrameBufferRenderer::GLFrameBufferRenderer()
-: _vertex_shader(0), _fragment_shader(0), _shader_program(0), content_scaling(Z_SCALING_FIT)
+: _vertex_shader(0), _fragment_shader(0), _shader_program(0), content_scaling(Z_SCALING_FIT), use_pixel_buffer(FALSE)
 	{
 	buffer.buffers[0] = nullptr;
+	frame_sequence	  = 0;
+	reload();
+
+#	ifdef OPEN_GL
+		_pixel_buffer = 0;
+		_upload_fence = 0;
+#	endif
 
 	glEnable(GL_TEXTURE_2D);
 	//glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -46,17 +53,89 @@ GLFrameBufferRenderer::~GLFrameBufferRenderer()
 	if (_vertex_shader  ) glDeleteShader (_vertex_shader  );
 	if (_fragment_shader) glDeleteShader (_fragment_shader);
 	glDeleteTextures(1, &_texture);
+
+#	ifdef OPEN_GL
+		if (_pixel_buffer) destroy_pixel_buffer();
+#	endif
+
 	free(buffer.buffers[0]);
 	}
 
 
+#ifdef OPEN_GL
+
+	/*-----------------------------------------------------------------.
+	| The three frames of the triple buffer are placed in one pixel    |
+	| buffer that stays mapped (ARB_buffer_storage), so the machine    |
+	| draws straight into memory the GL reads from, and the texture is |
+	| updated from it asynchronously, without copying the frame in the |
+	| client. Returns nullptr if the extension is not available.       |
+	'-----------------------------------------------------------------*/
+	void *GLFrameBufferRenderer::create_pixel_buffer(Size size)
+		{
+#		ifdef GL_MAP_PERSISTENT_BIT
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			void *data;
+
+			if (!has_extension("GL_ARB_buffer_storage")) return nullptr;
+			glGenBuffers(1, &_pixel_buffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixel_buffer);
+			glBufferStorage(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(size), nullptr, flags);
+			data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(size), flags);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			if (data == nullptr)
+				{
+				glDeleteBuffers(1, &_pixel_buffer);
+				_pixel_buffer = 0;
+				}
+
+			return data;
+#		else
+			(void)size;
+			return nullptr;
+#		endif
+		}
+
+
+	void GLFrameBufferRenderer::destroy_pixel_buffer()
+		{
+		if (_upload_fence)
+			{
+			glClientWaitSync(_upload_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			glDeleteSync(_upload_fence);
+			_upload_fence = 0;
+			}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixel_buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &_pixel_buffer);
+		_pixel_buffer	  = 0;
+		buffer.buffers[0] = nullptr;
+		}
+
+#endif
+
+
+/*-------------------------------------------------------------------.
+| Set use_pixel_buffer before calling this, and call this before the |
+| machine takes the first buffer to produce into.                    |
+'-------------------------------------------------------------------*/
 void GLFrameBufferRenderer::set_resolution(Value2D<Size> resolution)
 	{
 	Size frame_buffer_size = resolution.inner_product() * sizeof(UInt32);
+	void *frames = nullptr;
 
-	buffer.initialize
-		(buffer.buffers[0] = realloc(buffer.buffers[0], frame_buffer_size * 3),
-		 frame_buffer_size);
+#	ifdef OPEN_GL
+		if (_pixel_buffer) destroy_pixel_buffer();
+
+		if (use_pixel_buffer && (frames = create_pixel_buffer(frame_buffer_size * 3)) != nullptr)
+			free(buffer.buffers[0]);
+#	endif
+
+	if (frames == nullptr) frames = realloc(buffer.buffers[0], frame_buffer_size * 3);
+	buffer.initialize(buffer.buffers[0] = frames, frame_buffer_size);
 
 	glEnable(GL_TEXTURE_2D);
 
@@ -67,6 +146,7 @@ void GLFrameBufferRenderer::set_resolution(Value2D<Size> resolution)
 		 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
 	glDisable(GL_TEXTURE_2D);
+	reload();
 	}
 
 
@@ -132,20 +212,31 @@ void GLFrameBufferRenderer::set_linear_interpolation(Boolean value)
 	}
 
 
-void GLFrameBufferRenderer::draw(Boolean skip_old)
+/*-----------------------------------------------------------------.
+| Each frame consumed from the buffer gets the next sequence       |
+| number. With skip_old, nothing is drawn if the frame has already |
+| been presented, and FALSE is returned so that the caller does    |
+| not swap the buffers either.                                     |
+'-----------------------------------------------------------------*/
+Boolean GLFrameBufferRenderer::draw(Boolean skip_old)
 	{
-	void *frame = buffer.consume();
+#	ifdef OPEN_GL
+		//-----------------------------------------------------------.
+		// The frame uploaded last time goes back to the machine on  |
+		// consume(), so the GL must have finished reading it. It is |
+		// always the case after a refresh; the wait is a safeguard. |
+		//-----------------------------------------------------------'
+		if (_upload_fence)
+			{
+			glClientWaitSync(_upload_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			glDeleteSync(_upload_fence);
+			_upload_fence = 0;
+			}
+#	endif
 
-	if (!frame)
-		{
-		if (skip_old) return;
-		frame = buffer.consumption_buffer();
-		}
-
-	/*for (Size x = 0; x < input_width * input_height; x++)
-		{
-		((UInt32 *)frame)[x] = 0x1F32FFFF;
-		}*/
+	if (buffer.consume()) frame_sequence++;
+	if (skip_old && _presented_sequence == frame_sequence) return FALSE;
+	_presented_sequence = frame_sequence;
 
 	glEnable(GL_TEXTURE_2D);
 
@@ -155,10 +246,41 @@ void GLFrameBufferRenderer::draw(Boolean skip_old)
 		glClear(GL_COLOR_BUFFER_BIT);
 		}
 
-	glTexSubImage2D
-		(GL_TEXTURE_2D, 0, 0, 0,
-		 input_width, input_height,
-		 GL_RGBA, GL_UNSIGNED_BYTE, frame);
+	//-----------------------------------------------------------.
+	// The texture is only updated if it does not hold the frame |
+	// already, so repainting a frame costs no upload.           |
+	//-----------------------------------------------------------'
+	if (_uploaded_sequence != frame_sequence)
+		{
+		void *frame = buffer.consumption_buffer();
+
+		_uploaded_sequence = frame_sequence;
+
+#		ifdef OPEN_GL
+			//-----------------------------------------------------.
+			// From a pixel buffer, the pixels are given as offset |
+			// and the upload runs while the machine goes on.      |
+			//-----------------------------------------------------'
+			if (_pixel_buffer)
+				{
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixel_buffer);
+				frame = (void *)((UInt8 *)frame - (UInt8 *)buffer.buffers[0]);
+				}
+#		endif
+
+		glTexSubImage2D
+			(GL_TEXTURE_2D, 0, 0, 0,
+			 input_width, input_height,
+			 GL_RGBA, GL_UNSIGNED_BYTE, frame);
+
+#		ifdef OPEN_GL
+			if (_pixel_buffer)
+				{
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				_upload_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				}
+#		endif
+		}
 
 	//glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 	glBindTexture(GL_TEXTURE_2D, _texture);
@@ -178,6 +300,19 @@ void GLFrameBufferRenderer::draw(Boolean skip_old)
 #	if Z_OS != Z_OS_IOS
 		glFlush();
 #	endif
+
+	return TRUE;
+	}
+
+
+/*--------------------------------------------------------------.
+| Makes the next draw upload and present the consumption buffer |
+| even if no new frame has been produced, for when its contents |
+| have been changed by someone other than the producer.         |
+'--------------------------------------------------------------*/
+void GLFrameBufferRenderer::reload()
+	{
+	_uploaded_sequence = _presented_sequence = frame_sequence - 1;
 	}
 
 
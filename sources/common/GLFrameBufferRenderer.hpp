@@ -24,11 +24,18 @@ class GLFrameBufferRenderer {
 	GLuint _shader_program;
 	GLuint _index_buffer_id;
 	GLuint _transform_uniform;
+	Zeta::UInt64 _uploaded_sequence;
+	Zeta::UInt64 _presented_sequence;
 
 #	ifdef OPEN_GL_ES
 		GLuint _vertex_attribute;
 #	endif
 
+#	ifdef OPEN_GL
+		GLuint _pixel_buffer;
+		GLsync _upload_fence;
+#	endif
+
 	//GLuint  _texture_size_uniform_id;
 
 	public:
@@ -38,6 +45,8 @@ class GLFrameBufferRenderer {
 	Zeta::Rectangle<Zeta::Real> viewport;
 	Zeta::Rectangle<Zeta::Real> content_bounds;
 	ZKey(SCALING)		    content_scaling;
+	Zeta::Boolean		    use_pixel_buffer;
+	Zeta::UInt64		    frame_sequence;
 
 	GLFrameBufferRenderer();
 	~GLFrameBufferRenderer();
@@ -46,12 +55,19 @@ class GLFrameBufferRenderer {
 	void set_content_bounds(Zeta::Rectangle<Zeta::Real> bounds);
 	void set_content_size(Zeta::Value2D<Zeta::Real> size);
 	void set_geometry(Zeta::Rectangle<Zeta::Real> viewport, ZKey(SCALING) content_scaling);
-	void draw(Zeta::Boolean skip_old);
+	Zeta::Boolean draw(Zeta::Boolean skip_old);
+	void reload();
 	void set_linear_interpolation(Zeta::Boolean value);
 	Zeta::Boolean set_vertex_shader(Zeta::Character *source_code, std::string **error_log);
 	Zeta::Boolean set_fragment_shader(Zeta::Character *source_code, std::string **error_log);
 	void create_shader_program();
 	void destroy_shader_program();
+
+#	ifdef OPEN_GL
+		private:
+		void *create_pixel_buffer(Zeta::Size size);
+		void destroy_pixel_buffer();
+#	endif
 };
 
 #endif // __mZX_common_GLFrameBufferRenderer_HPP
@@ -7,8 +7,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <new>
+#include <vector>
 #include "Machine.hpp"
 #include "system.h"
+#include "MachinePool.h"
+#include "ROMRegistry.h"
 #include "Z80.h"
 
 using namespace Zeta;
@@ -18,21 +22,75 @@ using namespace Zeta;
 '--------------------------------*/
 void Machine::main()
 	{
-	UInt64	frames_per_second = 50;
-	UInt64	frame_ticks	  = 1000000000 / frames_per_second;
-	UInt64	next_frame_tick   = z_ticks();
 	UInt64	delta;
 	UInt	maximum_frameskip = 5;
 	UInt	loops;
 	void*	buffer;
-	UInt64* keyboard;
+	Boolean audio_paced;
 
-	while (!_must_stop)
+	while (TRUE)
 		{
-		loops = 0;
+		run_commands();
+		if (_must_exit) break;
 
-		do abi->run_1_frame(context);
-		while ((next_frame_tick += frame_ticks) < z_ticks() && ++loops < maximum_frameskip);
+		if (!_running)
+			{
+			settle_input();
+
+			std::unique_lock<std::mutex> lock(_idle_mutex);
+
+			_idle_condition.wait(lock, [this] {return !_commands.is_empty() || !_input.is_empty();});
+			continue;
+			}
+
+		audio_paced = _audio_pacing && !(_audio_output_failed && _audio_output_failed());
+
+		if (_display_pacing)
+			{
+			if (_refresh_count.load(std::memory_order_acquire) == _refreshes_served)
+				{
+				std::unique_lock<std::mutex> lock(_idle_mutex);
+
+				_idle_condition.wait(lock, [this]
+					{
+					return	!_commands.is_empty() ||
+						_refresh_count.load(std::memory_order_acquire) != _refreshes_served;
+					});
+
+				continue;
+				}
+
+			run_display_frame();
+			}
+
+		/*---------------------------------------------------------.
+		| Paced by the audio output, a frame is run whenever the   |
+		| device has consumed enough of the queued ones; the speed |
+		| of the emulation follows the clock of the device. If the |
+		| output fails, the host clock takes over.                 |
+		'---------------------------------------------------------*/
+		else if (audio_paced)
+			{
+			if (_audio_output->fill_count > _audio_pacing)
+				{
+				z_wait(_frame_ticks / 8);
+				continue;
+				}
+
+			_next_frame_tick = z_ticks();
+			deliver_input();
+			abi->run_1_frame(context);
+			}
+
+		else	{
+			loops = 0;
+
+			do	{
+				deliver_input();
+				abi->run_1_frame(context);
+				}
+			while ((_next_frame_tick += _frame_ticks) < z_ticks() && ++loops < maximum_frameskip);
+			}
 
 		//-----------------.
 		// Produce output. |
@@ -41,12 +99,7 @@ void Machine::main()
 			context->audio_output_buffer = (Int16 *)buffer;
 
 		context->video_output_buffer = _video_output->produce();
-
-		//----------------.
-		// Consume input. |
-		//----------------'
-		if ((keyboard = (UInt64 *)_keyboard_input->consume()) != NULL)
-			{context->state.keyboard.value_uint64 = *keyboard;}
+		if (_frame_observer) _frame_observer();
 
 #		if Z_OS == Z_OS_MAC_OS_X
 		if (_audio_input)
@@ -54,8 +107,8 @@ void Machine::main()
 			while (!(buffer = _audio_input->try_consume()))
 				{
 				//printf("skip");
-				next_frame_tick += frame_ticks / 4;
-				z_wait(frame_ticks / 4);
+				_next_frame_tick += _frame_ticks / 4;
+				z_wait(_frame_ticks / 4);
 				}
 
 			context->audio_input_buffer = (UInt8 *)buffer;
@@ -65,56 +118,242 @@ void Machine::main()
 		//----------------------------------------.
 		// Schedule next iteration time and wait. |
 		//----------------------------------------'
-		if ((delta = next_frame_tick - z_ticks()) <= frame_ticks) z_wait(delta);
-		//else printf("delta => %lu, next => %lu\n", delta, next_frame_tick);
+		if (!audio_paced && !_display_pacing && (delta = _next_frame_tick - z_ticks()) <= _frame_ticks) z_wait(delta);
+		//else printf("delta => %lu, next => %lu\n", delta, _next_frame_tick);
 		}
 	}
 
 
-void Machine::start()
+void Machine::run_commands()
 	{
-	_must_stop = FALSE;
-	_thread = std::thread(&Machine::main, this);
+	Command command;
+
+	while (_commands.try_pop(command))
+		{
+		command.action();
+		command.done.set_value();
+		}
 	}
 
 
-void Machine::stop()
+/*-------------------------------------------------------------------.
+| Runs one frame for the refreshes of the display signaled since the |
+| last one. More than one means that the previous frame was not      |
+| ready in time and the display showed it again.                     |
+'-------------------------------------------------------------------*/
+void Machine::run_display_frame()
 	{
-	_must_stop = TRUE;
-	_thread.join();
+	FrameStatistics &statistics = _frame_statistics;
+	UInt64 count   = _refresh_count.load(std::memory_order_acquire);
+	UInt64 tick    = _refresh_tick.load(std::memory_order_relaxed);
+	UInt64 pending = count - _refreshes_served;
+	UInt64 time;
+
+	if (_last_refresh_tick && tick > _last_refresh_tick)
+		{
+		time = (tick - _last_refresh_tick) / pending;
+		if (!statistics.minimum_refresh_time || time < statistics.minimum_refresh_time) statistics.minimum_refresh_time = time;
+		if (time > statistics.maximum_refresh_time) statistics.maximum_refresh_time = time;
+		statistics.total_refresh_time += tick - _last_refresh_tick;
+		}
+
+	statistics.refreshes	   += pending;
+	statistics.repeated_frames += pending - 1;
+	_refreshes_served	    = count;
+	_last_refresh_tick	    = tick;
+
+	_next_frame_tick = time = z_ticks();
+	deliver_input();
+	abi->run_1_frame(context);
+	time = z_ticks() - time;
+	if (!statistics.minimum_frame_time || time < statistics.minimum_frame_time) statistics.minimum_frame_time = time;
+	if (time > statistics.maximum_frame_time) statistics.maximum_frame_time = time;
+	statistics.total_frame_time += time;
+	statistics.frames++;
+	}
+
+
+/*------------------------------------------------------------------.
+| The frame about to run stands for the host time that elapsed just |
+| before it was due, so each input event is passed to the machine   |
+| at the cycle of the frame that matches its timestamp. Input is    |
+| one frame late, but keeps its timing within the frame: presses    |
+| shorter than a frame are not lost.                                |
+'------------------------------------------------------------------*/
+void Machine::deliver_input()
+	{
+	UInt64 end = _next_frame_tick, start = end - _frame_ticks;
+	UInt64 per_frame = context->cycles->per_frame;
+	InputEvent *event;
+
+	while ((event = _input.front()) != NULL && event->time < end)
+		{
+		zx_spectrum_input
+			(context,
+			 context->frame_start + (event->time > start ? (event->time - start) * per_frame / _frame_ticks : 0),
+			 event->device, event->mask, event->pressed);
+
+		_input.pop();
+		}
+	}
+
+
+/*------------------------------------------------------------------.
+| While the machine is stopped, the events are not kept for later:  |
+| they all take effect at the start of the next frame, so that what |
+| was typed in between is never replayed; the machine only sees the |
+| keys as they are when it runs again.                              |
+'------------------------------------------------------------------*/
+void Machine::settle_input()
+	{
+	InputEvent *event;
+
+	while ((event = _input.front()) != NULL)
+		{
+		zx_spectrum_input(context, context->frame_start, event->device, event->mask, event->pressed);
+		_input.pop();
+		}
+	}
+
+
+/*-----------------------------------------------------------------.
+| Only called from the emulation thread. The frame timing restarts |
+| from now, so that the frames missed while stopped are not run.   |
+'-----------------------------------------------------------------*/
+void Machine::set_running(Boolean state)
+	{
+	if ((_running = state))
+		{
+		_next_frame_tick   = z_ticks();
+		_refreshes_served  = _refresh_count.load(std::memory_order_acquire);
+		_last_refresh_tick = 0;
+		}
 	}
 
 
-Machine::Machine(MachineABI *abi, TripleBuffer *video_output, RingBuffer *audio_output, TripleBuffer *keyboard_input)
-: _video_output(video_output), _audio_output(audio_output), abi(abi), _keyboard_input(keyboard_input)
+static std::future<void> completed()
+	{
+	std::promise<void> promise;
+
+	promise.set_value();
+	return promise.get_future();
+	}
+
+
+/*----------------------------------------------------------------.
+| Queues an action to be run by the emulation thread between two  |
+| frames. If the queue is full, waits for the thread to drain it. |
+'----------------------------------------------------------------*/
+std::future<void> Machine::perform(std::function<void()> action)
+	{
+	Command command;
+	std::future<void> future = command.done.get_future();
+
+	command.action = std::move(action);
+	while (!_commands.try_push(std::move(command))) std::this_thread::yield();
+
+	std::lock_guard<std::mutex> lock(_idle_mutex);
+	_idle_condition.notify_one();
+	return future;
+	}
+
+
+static_assert(ZX_SPECTRUM_ALIGNMENT <= MACHINE_POOL_ALIGNMENT, "the pool must align the machine context");
+
+
+/*------------------------------------------------------------------.
+| Runs in the emulation thread before its main loop, so that the    |
+| context, with the CPU embedded, and the memory are taken from the |
+| pool on the NUMA node of that thread, and first touched by it.    |
+| They are one cache-line-aligned block. The memory starts at a     |
+| page boundary, so that the ROM images can be mapped into it.      |
+'------------------------------------------------------------------*/
+void Machine::create()
+	{
+	Size context_size = (abi->context_size + ZX_SPECTRUM_ALIGNMENT - 1) & ~(Size)(ZX_SPECTRUM_ALIGNMENT - 1);
+	Size page_size	  = rom_registry_alignment();
+	void *block	  = machine_pool_allocate(context_size + page_size + abi->memory_size, MACHINE_POOL_CURRENT_NODE);
+
+	if (block == NULL) throw std::bad_alloc();
+	context			     = (ZXSpectrum *)block;
+	context->memory		     = (UInt8 *)(((Size)block + context_size + page_size - 1) & ~(page_size - 1));
+
+#	ifdef CPU_Z80_USE_BLOCK_CACHE
+		context->cpu.block_cache = z80_block_cache_new(abi->memory_size / (1024 * 16));
+#	endif
+
+	context->video_output_buffer = _video_output->production_buffer();
+	context->audio_output_buffer = (Int16 *)_audio_output->production_buffer();
+	abi->initialize(context);
+	}
+
+
+/*----------------------------------------------------------------.
+| Waits for the emulation thread to create the machine; if it can |
+| not (no memory), the thread ends and the error is thrown here.  |
+'----------------------------------------------------------------*/
+Machine::Machine(MachineABI *abi, TripleBuffer *video_output, RingBuffer *audio_output)
+: _video_output(video_output), _audio_output(audio_output), abi(abi)
 	{
 #	if Z_OS != Z_OS_LINUX
 	_audio_input = NULL;
 #	endif
 	flags.power  = OFF;
 	flags.pause  = OFF;
+	_must_exit   = FALSE;
+	_running     = FALSE;
+	_frame_ticks = 1000000000 / 50;
+	_audio_pacing = 0;
+	_display_pacing = FALSE;
+	_refresh_count = 0;
+	_refresh_tick = 0;
+	_refreshes_served = 0;
+	_last_refresh_tick = 0;
+	memset(&_frame_statistics, 0, sizeof(FrameStatistics));
+
+	std::promise<void> created;
+	std::future<void> future = created.get_future();
+
+	_thread = std::thread([this, &created]
+		{
+		try	{
+			create();
+			created.set_value();
+			}
 
-	/*--------------------------------------.
-	| Create the machine and its components |
-	'--------------------------------------*/
-	context			     = (ZXSpectrum *)malloc(abi->context_size);
-	context->cpu_abi.run	     = (ZEmulatorRun  )z80_run;
-	context->cpu_abi.irq	     = (ZContextSwitch)z80_int;
-	context->cpu_abi.reset	     = (ZContextDo    )z80_reset;
-	context->cpu_abi.power	     = (ZEmulatorPower)z80_power;
-	context->cpu		     = (Z80 *)malloc(sizeof(Z80));
-	context->cpu_cycles	     = &context->cpu->cycles;
-	context->memory		     = (UInt8 *)calloc(1, abi->memory_size);
-	context->video_output_buffer = video_output->production_buffer();
-	context->audio_output_buffer = (Int16 *)audio_output->production_buffer();
-	abi->initialize(context);
+		catch (...)
+			{
+			created.set_exception(std::current_exception());
+			return;
+			}
+
+		main();
+		});
+
+	try {future.get();}
+
+	catch (...)
+		{
+		_thread.join();
+		throw;
+		}
 	}
 
 
 Machine::~Machine()
 	{
-	free(context->memory);
-	free(context->cpu);
+	perform([this] {_must_exit = TRUE;});
+	_thread.join();
+
+	ROM *rom = abi->roms, *end = rom + abi->rom_count;
+
+	for (; rom != end; rom++) rom_registry_unmap(context->memory + rom->base_address, rom->size);
+
+#	ifdef CPU_Z80_USE_BLOCK_CACHE
+		if (context->cpu.block_cache != NULL) z80_block_cache_destroy(context->cpu.block_cache);
+#	endif
+
+	machine_pool_free(context);
 	}
 
 
@@ -123,81 +362,275 @@ void machine_run_one_frame(Machine *object)
 	}
 
 
-void Machine::power(Boolean state)
+std::future<void> Machine::power(Boolean state)
 	{
-	if (state != flags.power)
+	if (state == flags.power) return completed();
+	flags.power = state;
+	flags.pause = OFF;
+
+	if (state) return perform([this]
+		{
+#		ifdef CPU_Z80_USE_BLOCK_CACHE
+			//---------------------------------------------------------.
+			// ROM blocks are shared by every machine with the same ROM |
+			//---------------------------------------------------------'
+			if (context->cpu.block_cache != NULL)
+				{
+				ROM *rom = abi->roms, *end = rom + abi->rom_count;
+				Size offset;
+
+				for (; rom != end; rom++)
+					for (offset = rom->base_address; offset < rom->base_address + rom->size; offset += 1024 * 16)
+						{
+						z80_block_cache_set_rom
+							(context->cpu.block_cache, (UInt16)(offset / (1024 * 16)),
+							 context->memory + offset);
+						}
+
+				z80_block_cache_invalidate(context->cpu.block_cache);
+				}
+#		endif
+
+		abi->power(context, ON);
+		set_running(TRUE);
+		});
+
+	return perform([this]
 		{
-		if (state)
+		Size rom_count = abi->rom_count, index = 0;
+		Size offset = 0;
+		ROM *rom;
+
+		set_running(FALSE);
+		abi->power(context, OFF);
+
+		for (; index < rom_count; index++)
 			{
-			flags.power = ON;
-			flags.pause = OFF;
-			abi->power(context, ON);
-			start();
+			rom = &abi->roms[index];
+			memset(context->memory + offset, 0, rom->base_address - offset);
+			offset = rom->base_address + rom->size;
 			}
 
-		else	{
-			Size rom_count = abi->rom_count, index = 0;
-			Size offset = 0;
-			ROM *rom;
+		memset(context->memory + offset, 0, abi->memory_size - offset);
+		});
+	}
 
-			if (!flags.pause) stop();
-			abi->power(context, OFF);
 
-			for (; index < rom_count; index++)
-				{
-				rom = &abi->roms[index];
-				memset(context->memory + offset, 0, rom->base_address - offset);
-				offset = rom->base_address + rom->size;
-				}
+std::future<void> Machine::pause(Boolean state)
+	{
+	if (!flags.power || state == flags.pause) return completed();
+	flags.pause = state;
+	return perform([this, state] {set_running(!state);});
+	}
 
-			memset(context->memory + offset, 0, abi->memory_size - offset);
-			flags.power = OFF;
-			flags.pause = OFF;
-			}
-		}
+
+std::future<void> Machine::reset()
+	{
+	if (!flags.power) return completed();
+	flags.pause = OFF;
+
+	return perform([this]
+		{
+		abi->reset(context);
+		set_running(TRUE);
+		});
+	}
+
+
+/*----------------------------------------------------------------.
+| Speed relative to the real machine; 2 runs twice as fast. Speeds |
+| that are not positive are ignored, and a frame never takes less  |
+| than one tick, as frame times are divided by it.                 |
+'----------------------------------------------------------------*/
+std::future<void> Machine::set_speed(Real speed)
+	{
+	if (!(speed > 0)) return completed();
+
+	return perform([this, speed]
+		{
+		double ticks = 1000000000.0 / (50.0 * speed);
+
+		_frame_ticks = ticks >= 1.0 ? UInt64(ticks) : 1;
+		});
+	}
+
+
+/*-----------------------------------------------------------------.
+| With 0 buffers, the emulation is paced by the host clock, as the |
+| audio output resamples to absorb the drift between the clocks.   |
+| Otherwise, it is paced by the audio output, which is kept with   |
+| that many buffers queued. Only for outputs that consume steadily |
+| (the emulation stops if the output stops). With an output that   |
+| is not real-time (a file), the emulation runs at full speed.     |
+|                                                                  |
+| output_failed, if given, is polled by the emulation thread each  |
+| frame; once it returns TRUE (the thread of the output has died), |
+| the emulation goes back to the host clock.                       |
+'-----------------------------------------------------------------*/
+std::future<void> Machine::set_audio_pacing(Size buffers, std::function<Boolean()> output_failed)
+	{
+	return perform([this, buffers, output_failed]
+		{
+		_audio_pacing	     = buffers;
+		_audio_output_failed = output_failed;
+		_next_frame_tick     = z_ticks();
+		});
 	}
 
 
-void Machine::pause(Boolean state)
+/*------------------------------------------------------------------.
+| Paced by the display, the machine runs one frame each time the    |
+| view calls refresh() after a buffer swap synchronized to vertical |
+| retrace, so every refresh shows a new frame. The emulation speed  |
+| follows the refresh rate (60 Hz runs 1.2 times as fast), and the  |
+| audio output has to be told to resample accordingly. Enabling it  |
+| clears the frame statistics.                                      |
+'------------------------------------------------------------------*/
+std::future<void> Machine::set_display_pacing(Boolean state)
 	{
-	if (flags.power && state != flags.pause)
+	return perform([this, state]
 		{
-		if (state)
+		if ((_display_pacing = state)) memset(&_frame_statistics, 0, sizeof(FrameStatistics));
+		_refreshes_served  = _refresh_count.load(std::memory_order_acquire);
+		_last_refresh_tick = 0;
+		_next_frame_tick   = z_ticks();
+		});
+	}
+
+
+/*----------------------------------------------------------------.
+| Called by the view each time the display is refreshed. It never |
+| waits for the emulation thread.                                 |
+'----------------------------------------------------------------*/
+void Machine::refresh()
+	{
+	_refresh_tick.store(z_ticks(), std::memory_order_relaxed);
+	_refresh_count.fetch_add(1, std::memory_order_release);
+
+	std::lock_guard<std::mutex> lock(_idle_mutex);
+	_idle_condition.notify_one();
+	}
+
+
+/*--------------------------------------------------------------.
+| The observer is called from the emulation thread right after  |
+| each frame is produced, so it must only signal another thread |
+| (the view) that a frame is ready; it must not draw or wait.   |
+'--------------------------------------------------------------*/
+std::future<void> Machine::set_frame_observer(std::function<void()> observer)
+	{
+	return perform([this, observer] {_frame_observer = observer;});
+	}
+
+
+std::future<void> Machine::frame_statistics(FrameStatistics *statistics)
+	{
+	return perform([this, statistics] {*statistics = _frame_statistics;});
+	}
+
+
+std::future<void> Machine::set_joystick_interface(UInt8 interface)
+	{
+	return perform([this, interface] {context->joystick_interface = interface;});
+	}
+
+
+/*------------------------------------------------------------------.
+| Presses or releases keys of one half-row of the keyboard, or      |
+| directions of the joystick (ZX_SPECTRUM_INPUT_JOYSTICK), now. The |
+| event is timestamped here and does not wait for a command. FALSE  |
+| is returned if the queue is full; the caller has to send it again |
+| later, or a release may be lost and leave a key pressed.          |
+'------------------------------------------------------------------*/
+Boolean Machine::input(UInt8 device, UInt8 mask, Boolean pressed)
+	{
+	InputEvent event = {z_ticks(), device, mask, pressed};
+
+	if (!_input.try_push(std::move(event))) return FALSE;
+
+	std::lock_guard<std::mutex> lock(_idle_mutex);
+	_idle_condition.notify_one();
+	return TRUE;
+	}
+
+
+std::future<void> Machine::set_audio_input(RingBuffer *audio_input)
+	{
+#	if Z_OS != Z_OS_LINUX
+		return perform([this, audio_input] {_audio_input = audio_input;});
+#	else
+		return completed();
+#	endif
+	}
+
+
+std::future<void> Machine::set_tape_input(AudioTape *tape)
+	{
+	return perform([this, tape]
+		{
+		if (tape)
 			{
-			flags.pause = ON;
-			stop();
+			context->tape.next_pulse      = (ZContextRead32Bit)audio_tape_next_pulse;
+			context->tape.context	      = tape;
+			context->tape.next_edge_cycle = context->clock;
 			}
 
 		else	{
-			start();
-			flags.pause = OFF;
+			context->tape.next_pulse = NULL;
+			context->tape.context	 = NULL;
 			}
-		}
+
+		context->tape.ear = 0;
+		});
 	}
 
 
-void Machine::reset()
+static zboolean save_tap_block(void *tap, zsize block_size, zsize offset, zuint8 const *data, zsize data_size)
 	{
-	if (flags.power)
+	return	(offset || tap_writer_begin_block((TAPWriter *)tap, block_size)) &&
+		tap_writer_write((TAPWriter *)tap, data, data_size);
+	}
+
+
+std::future<void> Machine::set_tape_output(TAPWriter *tap)
+	{
+	return perform([this, tap]
 		{
-		if (!flags.pause) stop();
-		abi->reset(context);
-		start();
-		flags.pause = OFF;
-		}
+		context->tape_output.save_block = tap ? save_tap_block : NULL;
+		context->tape_output.context	= tap;
+		});
 	}
 
 
-void Machine::set_audio_input(RingBuffer *audio_input)
+std::future<void> Machine::map_rom(ROM *rom, ROMImage *image)
 	{
-#	if Z_OS != Z_OS_LINUX
-	_audio_input = audio_input;
-#	endif
+	return perform([this, rom, image]
+		{
+		rom_registry_map(image, context->memory + rom->base_address);
+
+#		ifdef CPU_Z80_USE_BLOCK_CACHE
+			if (context->cpu.block_cache != NULL) z80_block_cache_invalidate(context->cpu.block_cache);
+#		endif
+		});
 	}
 
 
-void Machine::write_memory(Zeta::UInt16 base_address, void *data, Zeta::Size data_size)
-	{memcpy(context->memory + base_address, data, data_size);}
+/*----------------------------------------------------------.
+| The data is copied, so the caller can free it right away. |
+'----------------------------------------------------------*/
+std::future<void> Machine::write_memory(Zeta::UInt16 base_address, void *data, Zeta::Size data_size)
+	{
+	std::vector<UInt8> bytes((UInt8 *)data, (UInt8 *)data + data_size);
+
+	return perform([this, base_address, bytes]
+		{
+		memcpy(context->memory + base_address, bytes.data(), bytes.size());
+
+#		ifdef CPU_Z80_USE_BLOCK_CACHE
+			if (context->cpu.block_cache != NULL) z80_block_cache_invalidate(context->cpu.block_cache);
+#		endif
+		});
+	}
 
 
 /* Machine.c EOF */
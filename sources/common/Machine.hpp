@@ -11,16 +11,78 @@
 #include <Z/classes/buffering/RingBuffer.hpp>
 #include "ZX Spectrum.h"
 #include "MachineABI.h"
+#include "ROMRegistry.h"
+#include "SPSCQueue.hpp"
+#include "codecs/tape/audio.h"
+#include "codecs/tape/TAP.h"
 #include <Z/inspection/OS.h>
 #include <thread>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*------------------------------------------------------------------.
+| The machine runs in its own thread, which lives as long as the    |
+| machine. Other threads control it by sending commands, which are  |
+| run between two frames, so that the emulation never sees a change |
+| in the middle of one. Each command returns a future that is ready |
+| when it has been run. Only one thread may send commands.          |
+'------------------------------------------------------------------*/
 
 class Machine {
+	public:
+	/*--------------------------------------------------------.
+	| Collected while paced by the display. Times are in host |
+	| ticks (nanoseconds). A repeated frame is a refresh that |
+	| found no new frame to show.                             |
+	'--------------------------------------------------------*/
+	struct FrameStatistics {
+		Zeta::UInt64 refreshes;
+		Zeta::UInt64 frames;
+		Zeta::UInt64 repeated_frames;
+		Zeta::UInt64 minimum_frame_time;
+		Zeta::UInt64 maximum_frame_time;
+		Zeta::UInt64 total_frame_time;
+		Zeta::UInt64 minimum_refresh_time;
+		Zeta::UInt64 maximum_refresh_time;
+		Zeta::UInt64 total_refresh_time;
+	};
+
 	private:
-	std::thread	       _thread;
-	volatile Zeta::Boolean _must_stop;
+	struct Command {
+		std::function<void()> action;
+		std::promise<void>    done;
+	};
+
+	struct InputEvent {
+		Zeta::UInt64  time;
+		Zeta::UInt8   device;
+		Zeta::UInt8   mask;
+		Zeta::Boolean pressed;
+	};
+
+	std::thread		      _thread;
+	SPSCQueue<Command, 64>	      _commands;
+	SPSCQueue<InputEvent, 256>    _input;
+	std::mutex		      _idle_mutex;
+	std::condition_variable	      _idle_condition;
+	Zeta::Boolean		      _must_exit;
+	Zeta::Boolean		      _running;
+	Zeta::UInt64		      _frame_ticks;
+	Zeta::UInt64		      _next_frame_tick;
+	Zeta::Size		      _audio_pacing;
+	Zeta::Boolean		      _display_pacing;
+	std::atomic<Zeta::UInt64>     _refresh_count;
+	std::atomic<Zeta::UInt64>     _refresh_tick;
+	Zeta::UInt64		      _refreshes_served;
+	Zeta::UInt64		      _last_refresh_tick;
+	FrameStatistics		      _frame_statistics;
+	std::function<void()>	      _frame_observer;
+	std::function<Zeta::Boolean()> _audio_output_failed;
 	Zeta::TripleBuffer*    _video_output;
 	Zeta::RingBuffer*      _audio_output;
-	Zeta::TripleBuffer*    _keyboard_input;
 
 #	if Z_OS != Z_OS_LINUX
 		Zeta::RingBuffer* _audio_input;
@@ -36,22 +98,37 @@ class Machine {
 
 	Machine(MachineABI*	    abi,
 		Zeta::TripleBuffer* video_output,
-		Zeta::RingBuffer*   audio_output,
-		Zeta::TripleBuffer* keyboard_input);
+		Zeta::RingBuffer*   audio_output);
 
 	~Machine();
 
 	void run_one_frame();
-	void power(Zeta::Boolean state);
-	void pause(Zeta::Boolean state);
-	void reset();
-	void set_audio_input(Zeta::RingBuffer *audio_input);
-	void write_memory(Zeta::UInt16 base_address, void *data, Zeta::Size data_size);
+	std::future<void> perform(std::function<void()> action);
+	std::future<void> power(Zeta::Boolean state);
+	std::future<void> pause(Zeta::Boolean state);
+	std::future<void> reset();
+	std::future<void> set_speed(Zeta::Real speed);
+	std::future<void> set_audio_pacing(Zeta::Size buffers, std::function<Zeta::Boolean()> output_failed = nullptr);
+	std::future<void> set_display_pacing(Zeta::Boolean state);
+	void refresh();
+	std::future<void> set_frame_observer(std::function<void()> observer);
+	std::future<void> frame_statistics(FrameStatistics *statistics);
+	std::future<void> set_joystick_interface(Zeta::UInt8 interface);
+	Zeta::Boolean input(Zeta::UInt8 device, Zeta::UInt8 mask, Zeta::Boolean pressed);
+	std::future<void> set_audio_input(Zeta::RingBuffer *audio_input);
+	std::future<void> set_tape_input(AudioTape *tape);
+	std::future<void> set_tape_output(TAPWriter *tap);
+	std::future<void> map_rom(ROM *rom, ROMImage *image);
+	std::future<void> write_memory(Zeta::UInt16 base_address, void *data, Zeta::Size data_size);
 
 	private:
+	void create();
 	void main();
-	void start();
-	void stop();
+	void run_commands();
+	void run_display_frame();
+	void deliver_input();
+	void settle_input();
+	void set_running(Zeta::Boolean state);
 };
 
 #endif /* __mZX_common_Machine_H */
@@ -0,0 +1,305 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/MachinePool.c
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <Z/inspection/OS.h>
+#include "MachinePool.h"
+
+#if Z_OS == Z_OS_LINUX
+#	include <unistd.h>
+#	include <dirent.h>
+#	include <sys/syscall.h>
+#endif
+
+#ifndef MAP_ANONYMOUS
+#	define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define ARENA_SIZE	(1024 * 1024 * 2) /* one huge page on x86-64 */
+#define HEADER_SIZE	MACHINE_POOL_ALIGNMENT
+#define MAXIMUM_NODES	64
+#define MAXIMUM_CLASSES 64
+#define MPOL_PREFERRED	1
+
+#define ROUND_UP(value, alignment) (((value) + (alignment) - 1) & ~(zsize)((alignment) - 1))
+
+/*-----------------------------------------------------------------.
+| Every block is preceded by a header of one cache line. While the |
+| block is in use, it points to the class the block belongs to; in |
+| the free list of the class, to the next free block.              |
+'-----------------------------------------------------------------*/
+typedef union Header Header;
+
+typedef struct {
+	zsize	size;
+	zint	node;
+	Header* free;
+} Class;
+
+union Header {
+	Header* next;
+	Class*	owner;
+};
+
+typedef struct {
+	zuint8* next;
+	zuint8* end;
+} Arena;
+
+static struct {
+	pthread_mutex_t mutex;
+	zboolean	huge_pages;
+	zboolean	merge_pages;
+	Arena		arenas [MAXIMUM_NODES];
+	Class		classes[MAXIMUM_CLASSES];
+	zuint		class_count;
+} pool = {PTHREAD_MUTEX_INITIALIZER, FALSE, FALSE, {{NULL, NULL}}, {{0, 0, NULL}}, 0};
+
+
+Z_PRIVATE zint current_node(void)
+	{
+#	if Z_OS == Z_OS_LINUX && defined(SYS_getcpu)
+		unsigned int cpu, node;
+
+		if (!syscall(SYS_getcpu, &cpu, &node, NULL) && node < MAXIMUM_NODES)
+			return (zint)node;
+#	endif
+
+	return 0;
+	}
+
+
+/*------------------------------------------------------------------.
+| Maps a region aligned to the arena size, so that it can be backed |
+| by transparent huge pages, and binds it to the node before it is  |
+| touched. Both are only hints: without THP or NUMA support in the  |
+| kernel, the region is an ordinary mapping.                        |
+'------------------------------------------------------------------*/
+Z_PRIVATE zuint8 *map_region(zsize size, zint node)
+	{
+	zuint8 *region, *aligned;
+
+	if ((region = mmap(NULL, size + ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))
+	    == MAP_FAILED
+	)
+		return NULL;
+
+	aligned = (zuint8 *)ROUND_UP((zsize)region, ARENA_SIZE);
+	if (aligned != region) munmap(region, aligned - region);
+	munmap(aligned + size, (region + ARENA_SIZE) - aligned);
+
+#	if Z_OS == Z_OS_LINUX
+#		ifdef MADV_HUGEPAGE
+			if (pool.huge_pages) madvise(aligned, size, MADV_HUGEPAGE);
+#		endif
+
+#		ifdef MADV_MERGEABLE
+			if (pool.merge_pages) madvise(aligned, size, MADV_MERGEABLE);
+#		endif
+
+#		ifdef SYS_mbind
+			{
+			unsigned long mask = 1UL << node;
+
+			syscall(SYS_mbind, aligned, size, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0);
+			}
+#		endif
+#	endif
+
+	return aligned;
+	}
+
+
+Z_PRIVATE Class *find_class(zsize size, zint node)
+	{
+	Class *class = pool.classes, *end = class + pool.class_count;
+
+	for (; class != end; class++)
+		if (class->size == size && class->node == node) return class;
+
+	if (pool.class_count == MAXIMUM_CLASSES) return NULL;
+	class->size = size;
+	class->node = node;
+	class->free = NULL;
+	pool.class_count++;
+	return class;
+	}
+
+
+Z_PRIVATE zuint8 *carve(zsize size, zint node)
+	{
+	Arena *arena = &pool.arenas[node];
+	zuint8 *block;
+
+	/*---------------------------------------------------------------.
+	| Blocks bigger than a quarter of an arena get a region of their |
+	| own; the rest of the current arena would be mostly wasted.     |
+	'---------------------------------------------------------------*/
+	if (size > ARENA_SIZE / 4) return map_region(ROUND_UP(size, ARENA_SIZE), node);
+
+	if ((zsize)(arena->end - arena->next) < size)
+		{
+		if ((block = map_region(ARENA_SIZE, node)) == NULL) return NULL;
+		arena->next = block;
+		arena->end  = block + ARENA_SIZE;
+		}
+
+	block = arena->next;
+	arena->next += size;
+	return block;
+	}
+
+
+void *machine_pool_allocate(zsize size, zint node)
+	{
+	Class *class;
+	zuint8 *block = NULL;
+
+	size = ROUND_UP(size + HEADER_SIZE, HEADER_SIZE);
+	if (node < 0 || node >= MAXIMUM_NODES) node = current_node();
+	pthread_mutex_lock(&pool.mutex);
+
+	if ((class = find_class(size, node)) != NULL)
+		{
+		if (class->free != NULL)
+			{
+			block = (zuint8 *)class->free;
+			class->free = class->free->next;
+			}
+
+		else block = carve(size, node);
+		}
+
+	pthread_mutex_unlock(&pool.mutex);
+	if (block == NULL) return NULL;
+	((Header *)block)->owner = class;
+	memset(block + HEADER_SIZE, 0, size - HEADER_SIZE);
+	return block + HEADER_SIZE;
+	}
+
+
+void machine_pool_free(void *block)
+	{
+	Header *header;
+	Class *class;
+
+	if (block == NULL) return;
+	header = (Header *)((zuint8 *)block - HEADER_SIZE);
+	class  = header->owner;
+	pthread_mutex_lock(&pool.mutex);
+	header->next = class->free;
+	class->free  = header;
+	pthread_mutex_unlock(&pool.mutex);
+	}
+
+
+void machine_pool_set_huge_pages(zboolean value)
+	{
+	pthread_mutex_lock(&pool.mutex);
+	pool.huge_pages = value;
+	pthread_mutex_unlock(&pool.mutex);
+	}
+
+
+/*-----------------------------------------------------------------.
+| Regions mapped from now on are offered to the kernel for merging |
+| (KSM). It only takes effect if the administrator has started the |
+| scanner (/sys/kernel/mm/ksm/run). With merge_across_nodes set to |
+| 0, pages are only merged between instances of the same node.     |
+'-----------------------------------------------------------------*/
+void machine_pool_set_merge_pages(zboolean value)
+	{
+	pthread_mutex_lock(&pool.mutex);
+	pool.merge_pages = value;
+	pthread_mutex_unlock(&pool.mutex);
+	}
+
+
+#if Z_OS == Z_OS_LINUX
+
+	Z_PRIVATE zboolean read_counter(char const *path, char const *key, zuint64 *value)
+		{
+		FILE *file = fopen(path, "r");
+		char line[128];
+		zsize key_size = strlen(key);
+		zboolean found = FALSE;
+		unsigned long long number;
+
+		if (file == NULL) return FALSE;
+
+		while (!found && fgets(line, sizeof(line), file) != NULL)
+			if (!strncmp(line, key, key_size) && sscanf(line + key_size, "%llu", &number) == 1)
+				{
+				*value = number;
+				found = TRUE;
+				}
+
+		fclose(file);
+		return found;
+		}
+
+
+	/*-----------------------------------------------------------.
+	| The scanner is a kernel thread; its CPU time is read from  |
+	| its process entry, which has to be looked up by name.      |
+	'-----------------------------------------------------------*/
+	Z_PRIVATE zuint64 scanner_time(void)
+		{
+		DIR *directory = opendir("/proc");
+		struct dirent *entry;
+		char path[sizeof("/proc//stat") + sizeof(entry->d_name)], name[16];
+		unsigned long long user_ticks, system_ticks;
+		zuint64 time = 0;
+		FILE *file;
+
+		if (directory == NULL) return 0;
+
+		while ((entry = readdir(directory)) != NULL)
+			{
+			if (*entry->d_name < '0' || *entry->d_name > '9') continue;
+			snprintf(path, sizeof(path), "/proc/%s/stat", entry->d_name);
+			if ((file = fopen(path, "r")) == NULL) continue;
+
+			if (	fscanf(file, "%*d (%15[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+					name, &user_ticks, &system_ticks) == 3 &&
+				!strcmp(name, "ksmd")
+			)
+				time = (user_ticks + system_ticks) * Z_UINT64(1000000000) / (zuint64)sysconf(_SC_CLK_TCK);
+
+			fclose(file);
+			if (time) break;
+			}
+
+		closedir(directory);
+		return time;
+		}
+
+#endif
+
+
+zboolean machine_pool_merge_statistics(MachinePoolMergeStatistics *statistics)
+	{
+	memset(statistics, 0, sizeof(MachinePoolMergeStatistics));
+
+#	if Z_OS == Z_OS_LINUX
+		if (!read_counter("/sys/kernel/mm/ksm/pages_shared", "", &statistics->shared_pages))
+			return FALSE;
+
+		read_counter("/sys/kernel/mm/ksm/pages_sharing", "", &statistics->sharing_pages);
+		read_counter("/sys/kernel/mm/ksm/full_scans",	 "", &statistics->full_scans);
+		read_counter("/proc/self/ksm_stat", "ksm_merging_pages", &statistics->merged_pages);
+		statistics->scanner_time = scanner_time();
+		return TRUE;
+#	else
+		return FALSE;
+#	endif
+	}
+
+
+/* MachinePool.c EOF */
@@ -0,0 +1,55 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/MachinePool.h
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#ifndef __mZX_common_MachinePool_H
+#define __mZX_common_MachinePool_H
+
+#include <Z/types/base.h>
+
+/*-------------------------------------------------------------------.
+| Allocator for the memory of the machine instances (context, CPU    |
+| and RAM in one block). Blocks are carved from large arenas of the  |
+| NUMA node they are requested for, and freed blocks are kept for    |
+| the next instance of the same size and node instead of being       |
+| returned to the system. Blocks are zeroed and aligned to          |
+| MACHINE_POOL_ALIGNMENT (a cache line).                             |
+'-------------------------------------------------------------------*/
+
+#define MACHINE_POOL_ALIGNMENT	  64
+#define MACHINE_POOL_CURRENT_NODE -1
+
+/*------------------------------------------------------------------.
+| Identical pages of different instances (the same game loaded from |
+| the same snapshot, for example) can be merged by the kernel into  |
+| one copy-on-write page; an instance that writes to a merged page  |
+| gets its own copy back. The scan runs in the background (ksmd),   |
+| and these counters tell how much memory it saves and what it      |
+| costs. All the page counts are in pages of the system.            |
+'------------------------------------------------------------------*/
+typedef struct {
+	zuint64 merged_pages;	/* pages of this process backed by a merged page    */
+	zuint64 shared_pages;	/* merged pages in the system                       */
+	zuint64 sharing_pages;	/* pages saved in the system by the merged pages    */
+	zuint64 full_scans;	/* times the scanner has gone through all the pages */
+	zuint64 scanner_time;	/* CPU time used by the scanner, in nanoseconds     */
+} MachinePoolMergeStatistics;
+
+Z_C_SYMBOLS_BEGIN
+
+void*	 machine_pool_allocate		(zsize			     size,
+					 zint			     node);
+
+void	 machine_pool_free		(void*			     block);
+
+void	 machine_pool_set_huge_pages	(zboolean		     value);
+
+void	 machine_pool_set_merge_pages	(zboolean		     value);
+
+zboolean machine_pool_merge_statistics	(MachinePoolMergeStatistics* statistics);
+
+Z_C_SYMBOLS_END
+
+#endif /* __mZX_common_MachinePool_H */
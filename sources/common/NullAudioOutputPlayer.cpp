@@ -0,0 +1,72 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/NullAudioOutputPlayer.cpp
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#include <stdlib.h>
+#include "system.h"
+#include "NullAudioOutputPlayer.hpp"
+
+#define FRAME_SIZE   (Z_INT16_SIZE * 882)
+#define BUFFER_COUNT 64
+#define IDLE_TICKS   (1000000000 / 1000)
+
+using namespace Zeta;
+
+
+void NullAudioOutputPlayer::main()
+	{
+	while (!_must_stop)
+		{
+		if (!_buffer.fill_count) z_wait(IDLE_TICKS);
+
+		else while (_buffer.fill_count)
+			{
+			_buffer.try_consume();
+			frame_count++;
+			}
+		}
+	}
+
+
+NullAudioOutputPlayer::NullAudioOutputPlayer()
+: playing(FALSE), frame_count(0)
+	{
+	void *frames = calloc(BUFFER_COUNT, FRAME_SIZE);
+	_buffer.initialize(frames, FRAME_SIZE, BUFFER_COUNT);
+	}
+
+
+NullAudioOutputPlayer::~NullAudioOutputPlayer()
+	{
+	stop();
+	free(_buffer.buffers);
+	}
+
+
+Boolean NullAudioOutputPlayer::start()
+	{
+	if (!playing)
+		{
+		_must_stop = FALSE;
+		playing = TRUE;
+		_thread = std::thread(&NullAudioOutputPlayer::main, this);
+		}
+
+	return TRUE;
+	}
+
+
+void NullAudioOutputPlayer::stop()
+	{
+	if (playing)
+		{
+		_must_stop = TRUE;
+		_thread.join();
+		playing = FALSE;
+		}
+	}
+
+
+// common/NullAudioOutputPlayer.cpp EOF
@@ -0,0 +1,38 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/NullAudioOutputPlayer.hpp
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#ifndef __mZX_common_NullAudioOutputPlayer_HPP
+#define __mZX_common_NullAudioOutputPlayer_HPP
+
+#include "AudioOutputPlayer.hpp"
+#include <thread>
+
+/*-----------------------------------------------------------.
+| Discards the frames as soon as they are produced, for runs |
+| without a sound device. The frames consumed are counted.   |
+'-----------------------------------------------------------*/
+class NullAudioOutputPlayer : public AudioOutputPlayer {
+	private:
+	std::thread	       _thread;
+	Zeta::RingBuffer       _buffer;
+	volatile Zeta::Boolean _must_stop;
+
+	public:
+	Zeta::Boolean	       playing;
+	Zeta::UInt64	       frame_count;
+
+	NullAudioOutputPlayer();
+	~NullAudioOutputPlayer();
+	Zeta::RingBuffer *buffer() {return &_buffer;}
+	Zeta::Boolean start();
+	void stop();
+	Zeta::Boolean is_real_time() {return FALSE;}
+
+	private:
+	void main();
+};
+
+#endif // __mZX_common_NullAudioOutputPlayer_HPP
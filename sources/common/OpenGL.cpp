@@ -5,6 +5,7 @@
 |_*/
 
 #include "OpenGL.hpp"
+#include <cstring>
 
 using namespace Zeta;
 using namespace std;
@@ -37,3 +38,35 @@ GLuint compile_shader(Character const *source_code, GLenum type, string **error_
 
 	return id;
 	}
+
+
+/*-----------------------------------------------------------------.
+| Looks for the extension in the list of the current context. Core |
+| contexts only give the names one by one.                         |
+'-----------------------------------------------------------------*/
+Boolean has_extension(Character const *name)
+	{
+	Size size = strlen(name);
+	Character const *start, *list;
+
+#	ifdef GL_NUM_EXTENSIONS
+		GLint count = 0, index;
+
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+		for (index = 0; index < count; index++)
+			if (!strcmp((Character const *)glGetStringi(GL_EXTENSIONS, GLuint(index)), name)) return TRUE;
+
+		if (count) return FALSE;
+#	endif
+
+	if ((start = list = (Character const *)glGetString(GL_EXTENSIONS)) == NULL) return FALSE;
+
+	for (; (list = strstr(list, name)) != NULL; list += size) if (
+		(list == start || list[-1] == ' ') &&
+		(list[size] == ' ' || list[size] == '\0')
+	)
+		return TRUE;
+
+	return FALSE;
+	}
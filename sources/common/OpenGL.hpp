@@ -36,9 +36,11 @@
 #endif
 
 
-GLuint compile_shader	(Zeta::Character const *source_code,
-				 GLenum type,
-				 std::string **error_log);
+GLuint	      compile_shader  (Zeta::Character const *source_code,
+			       GLenum type,
+			       std::string **error_log);
+
+Zeta::Boolean has_extension   (Zeta::Character const *name);
 
 
 #endif // __mZX_common_OpenGL_HPP
@@ -0,0 +1,254 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/ROMRegistry.c
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <Z/inspection/OS.h>
+#include "ROMRegistry.h"
+
+#if Z_OS == Z_OS_LINUX
+#	include <sys/syscall.h>
+#endif
+
+#ifndef MAP_ANONYMOUS
+#	define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MFD_CLOEXEC
+#	define MFD_CLOEXEC	 1
+#	define MFD_ALLOW_SEALING 2
+#endif
+
+#ifndef F_ADD_SEALS
+#	define F_ADD_SEALS  1033
+#	define F_SEAL_SEAL  1
+#	define F_SEAL_SHRINK 2
+#	define F_SEAL_GROW  4
+#	define F_SEAL_WRITE 8
+#endif
+
+#define FNV_OFFSET_BASIS Z_UINT64(0xCBF29CE484222325)
+#define FNV_PRIME	 Z_UINT64(0x00000100000001B3)
+
+struct ROMImage {
+	ROMImage* next;
+	zuint64	  hash;
+	zsize	  size;
+	int	  file;	/* memory file, or -1 if the image is only in the heap */
+	zuint8*	  data;
+};
+
+typedef struct Path Path;
+
+struct Path {
+	Path*	  next;
+	ROMImage* image;
+	char	  name[];
+};
+
+static struct {
+	pthread_mutex_t mutex;
+	ROMImage*	images;
+	Path*		paths;
+	zsize		alignment;
+} registry = {PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0};
+
+
+Z_PRIVATE zuint64 hash(zuint8 const *data, zsize size)
+	{
+	zuint64 value = FNV_OFFSET_BASIS;
+
+	while (size--) value = (value ^ *data++) * FNV_PRIME;
+	return value;
+	}
+
+
+/*------------------------------------------------------------------.
+| The content is written to an anonymous memory file, which is then |
+| sealed so that it can never change again. Without memory files    |
+| (other systems, or kernels older than 3.17), the image is kept in |
+| the heap and machines get a copy of it.                           |
+'------------------------------------------------------------------*/
+Z_PRIVATE ROMImage *new_image(zuint8 const *data, zsize size, zuint64 data_hash)
+	{
+	ROMImage *image;
+	zsize written;
+	ssize_t result;
+
+	if ((image = malloc(sizeof(ROMImage))) == NULL) return NULL;
+	image->hash = data_hash;
+	image->size = size;
+	image->file = -1;
+
+#	if Z_OS == Z_OS_LINUX && defined(SYS_memfd_create)
+		if ((image->file = syscall(SYS_memfd_create, "mZX ROM", MFD_CLOEXEC | MFD_ALLOW_SEALING)) != -1)
+			{
+			if (ftruncate(image->file, size)) goto no_file;
+
+			for (written = 0; written < size; written += result)
+				if ((result = pwrite(image->file, data + written, size - written, written)) <= 0)
+					goto no_file;
+
+			fcntl(image->file, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+
+			if ((image->data = mmap(NULL, size, PROT_READ, MAP_SHARED, image->file, 0)) != MAP_FAILED)
+				goto done;
+
+			no_file:
+			close(image->file);
+			image->file = -1;
+			}
+#	endif
+
+	if ((image->data = malloc(size)) == NULL)
+		{
+		free(image);
+		return NULL;
+		}
+
+	memcpy(image->data, data, size);
+
+	done:
+	image->next = registry.images;
+	registry.images = image;
+	return image;
+	}
+
+
+Z_PRIVATE ROMImage *find_or_add_image(zuint8 const *data, zsize size)
+	{
+	zuint64 data_hash = hash(data, size);
+	ROMImage *image = registry.images;
+
+	for (; image != NULL; image = image->next) if (
+		image->hash == data_hash &&
+		image->size == size	 &&
+		!memcmp(image->data, data, size)
+	)
+		return image;
+
+	return new_image(data, size, data_hash);
+	}
+
+
+/*----------------------------------------------------------------.
+| Returns the image of a ROM file, reading it only the first time |
+| the path is requested. Short files are padded with zeros. On    |
+| error, returns NULL and errno tells why.                        |
+'----------------------------------------------------------------*/
+ROMImage *rom_registry_load(char const *file_path, zsize size)
+	{
+	ROMImage *image = NULL;
+	zuint8 *data = NULL;
+	Path *path;
+	FILE *file;
+	int error = 0;
+
+	pthread_mutex_lock(&registry.mutex);
+
+	for (path = registry.paths; path != NULL; path = path->next)
+		if (path->image->size == size && !strcmp(path->name, file_path))
+			{
+			image = path->image;
+			goto done;
+			}
+
+	if ((file = fopen(file_path, "rb")) == NULL)
+		{
+		error = errno;
+		goto done;
+		}
+
+	if ((data = calloc(1, size)) == NULL) error = ENOMEM;
+	else if (fread(data, 1, size, file) < size && ferror(file)) error = EIO;
+	fclose(file);
+	if (error) goto done;
+
+	if (	(image = find_or_add_image(data, size)) == NULL ||
+		(path = malloc(sizeof(Path) + strlen(file_path) + 1)) == NULL
+	)
+		{
+		error = ENOMEM;
+		goto done;
+		}
+
+	strcpy(path->name, file_path);
+	path->image = image;
+	path->next = registry.paths;
+	registry.paths = path;
+
+	done:
+	pthread_mutex_unlock(&registry.mutex);
+	free(data);
+	if (error) {errno = error; return NULL;}
+	return image;
+	}
+
+
+ROMImage *rom_registry_insert(void const *data, zsize size)
+	{
+	ROMImage *image;
+
+	pthread_mutex_lock(&registry.mutex);
+	image = find_or_add_image(data, size);
+	pthread_mutex_unlock(&registry.mutex);
+	return image;
+	}
+
+
+/*---------------------------------------------------------------.
+| Images can only be mapped at addresses multiple of this value, |
+| which is the size of the memory pages of the system.           |
+'---------------------------------------------------------------*/
+zsize rom_registry_alignment(void)
+	{
+	if (!registry.alignment) registry.alignment = (zsize)sysconf(_SC_PAGESIZE);
+	return registry.alignment;
+	}
+
+
+/*------------------------------------------------------------------.
+| Maps the image over the target range, replacing its pages with    |
+| the read-only pages of the image. Returns FALSE if the image had  |
+| to be copied instead because the range is not aligned to memory   |
+| pages or the image is not in a memory file.                       |
+'------------------------------------------------------------------*/
+zboolean rom_registry_map(ROMImage *image, void *target)
+	{
+	zsize alignment = rom_registry_alignment();
+
+	if (	image->file != -1			    &&
+		!((zsize)target & (alignment - 1))	    &&
+		!(image->size & (alignment - 1))	    &&
+		mmap(target, image->size, PROT_READ, MAP_SHARED | MAP_FIXED, image->file, 0) != MAP_FAILED
+	)
+		return TRUE;
+
+	memcpy(target, image->data, image->size);
+	return FALSE;
+	}
+
+
+/*---------------------------------------------------------------.
+| Gives back to the range private, writable and zeroed pages, so |
+| that the memory can be reused after the machine is destroyed.  |
+'---------------------------------------------------------------*/
+void rom_registry_unmap(void *target, zsize size)
+	{
+	zsize alignment = rom_registry_alignment();
+
+	if (!((zsize)target & (alignment - 1)) && !(size & (alignment - 1)))
+		mmap(target, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+	}
+
+
+/* ROMRegistry.c EOF */
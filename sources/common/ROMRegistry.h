@@ -0,0 +1,40 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/ROMRegistry.h
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#ifndef __mZX_common_ROMRegistry_H
+#define __mZX_common_ROMRegistry_H
+
+#include <Z/types/base.h>
+
+/*------------------------------------------------------------------.
+| Process-wide registry of ROM images. Each file is read only once, |
+| and files with the same content share one image, which is kept in |
+| a sealed memory file. Machines map the image read-only into their |
+| memory, so all of them use the same physical pages. Where that is |
+| not possible, the image is copied instead.                        |
+'------------------------------------------------------------------*/
+
+typedef struct ROMImage ROMImage;
+
+Z_C_SYMBOLS_BEGIN
+
+ROMImage* rom_registry_load	 (char const* file_path,
+				  zsize	      size);
+
+ROMImage* rom_registry_insert	 (void const* data,
+				  zsize	      size);
+
+zsize	  rom_registry_alignment (void);
+
+zboolean  rom_registry_map	 (ROMImage*   image,
+				  void*	      target);
+
+void	  rom_registry_unmap	 (void*	      target,
+				  zsize	      size);
+
+Z_C_SYMBOLS_END
+
+#endif /* __mZX_common_ROMRegistry_H */
@@ -0,0 +1,73 @@
+/*     _________  ___
+ _____ \_   /\  \/  / common/SPSCQueue.hpp
+|  |  |_/  /__>    <  Copyright © 2014-2015 Manuel Sainz de Baranda y Goñi.
+|   ____________/\__\ Released under the GNU General Public License v3.
+|_*/
+
+#ifndef __mZX_common_SPSCQueue_HPP
+#define __mZX_common_SPSCQueue_HPP
+
+#include <Z/types/base.hpp>
+#include <atomic>
+#include <utility>
+
+/*-----------------------------------------------------------------.
+| Bounded lock-free queue for exactly one producer thread and one  |
+| consumer thread. The indices grow forever and are reduced modulo |
+| the capacity, which must be a power of 2. Each index is written  |
+| by one side only and lives in its own cache line.                |
+'-----------------------------------------------------------------*/
+template <class T, Zeta::Size capacity> class SPSCQueue {
+	static_assert(capacity && !(capacity & (capacity - 1)), "the capacity must be a power of 2");
+
+	private:
+	alignas(64) std::atomic<Zeta::Size> _head;
+	alignas(64) std::atomic<Zeta::Size> _tail;
+	T				    _slots[capacity];
+
+	public:
+	SPSCQueue() : _head(0), _tail(0) {}
+
+
+	Zeta::Boolean try_push(T &&item)
+		{
+		Zeta::Size tail = _tail.load(std::memory_order_relaxed);
+
+		if (tail - _head.load(std::memory_order_acquire) == capacity) return FALSE;
+		_slots[tail & (capacity - 1)] = std::move(item);
+		_tail.store(tail + 1, std::memory_order_release);
+		return TRUE;
+		}
+
+
+	Zeta::Boolean try_pop(T &item)
+		{
+		Zeta::Size head = _head.load(std::memory_order_relaxed);
+
+		if (head == _tail.load(std::memory_order_acquire)) return FALSE;
+		item = std::move(_slots[head & (capacity - 1)]);
+		_head.store(head + 1, std::memory_order_release);
+		return TRUE;
+		}
+
+
+	/*------------------------------------------------------------.
+	| Lets the consumer look at the next item before removing it. |
+	'------------------------------------------------------------*/
+	T *front()
+		{
+		Zeta::Size head = _head.load(std::memory_order_relaxed);
+
+		return head == _tail.load(std::memory_order_acquire) ? NULL : &_slots[head & (capacity - 1)];
+		}
+
+
+	void pop()
+		{_head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);}
+
+
+	Zeta::Boolean is_empty() const
+		{return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);}
+};
+
+#endif /* __mZX_common_SPSCQueue_HPP */
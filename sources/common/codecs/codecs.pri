@@ -0,0 +1,7 @@
+SOURCES += \
+	$$P_SOURCES/common/codecs/tape/audio.c \
+	$$P_SOURCES/common/codecs/tape/TAP.c \
+
+HEADERS += \
+	$$P_SOURCES/common/codecs/tape/audio.h \
+	$$P_SOURCES/common/codecs/tape/TAP.h \
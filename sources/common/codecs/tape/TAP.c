@@ -0,0 +1,110 @@
+/* TAP Writer v1.0
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+#include "TAP.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/* MARK: - Private Functions */
+
+Z_PRIVATE zboolean write_all(int file, zuint8 const *data, zsize size)
+	{
+	ssize_t written;
+
+	while (size)
+		{
+		if ((written = write(file, data, size)) < 0)
+			{
+			if (errno == EINTR) continue;
+			return FALSE;
+			}
+
+		data += written;
+		size -= (zsize)written;
+		}
+
+	return TRUE;
+	}
+
+
+Z_PRIVATE zboolean append(TAPWriter *object, zuint8 const *data, zsize size)
+	{
+	if (object->buffer_fill + size > TAP_WRITER_BUFFER_SIZE)
+		{
+		if (!tap_writer_flush(object)) return FALSE;
+
+		/*--------------------------------------------------.
+		| Blocks larger than the buffer are written through |
+		'--------------------------------------------------*/
+		if (size > TAP_WRITER_BUFFER_SIZE) return write_all(object->file, data, size);
+		}
+
+	memcpy(object->buffer + object->buffer_fill, data, size);
+	object->buffer_fill += size;
+	return TRUE;
+	}
+
+
+/* MARK: - Public Functions */
+
+zboolean tap_writer_open(TAPWriter *object, char const *file_path)
+	{
+	object->buffer_fill = 0;
+	return (object->file = open(file_path, O_WRONLY | O_CREAT | O_APPEND, 0644)) != -1;
+	}
+
+
+zboolean tap_writer_close(TAPWriter *object)
+	{
+	zboolean result = tap_writer_flush(object);
+
+	return !close(object->file) && result;
+	}
+
+
+zboolean tap_writer_flush(TAPWriter *object)
+	{
+	zsize size = object->buffer_fill;
+
+	object->buffer_fill = 0;
+	return write_all(object->file, object->buffer, size);
+	}
+
+
+/*---------------------------------------------------------------------.
+| A TAP block is the raw tape block (flag, data and checksum) preceded |
+| by its size as a little-endian 16 bit value.                         |
+'---------------------------------------------------------------------*/
+zboolean tap_writer_write_block(TAPWriter *object, zuint8 const *block, zsize block_size)
+	{return tap_writer_begin_block(object, block_size) && append(object, block, block_size);}
+
+
+/*-----------------------------------------------------------------.
+| For blocks written in pieces: the size is written first, and the |
+| caller has to follow it with exactly that many bytes.            |
+'-----------------------------------------------------------------*/
+zboolean tap_writer_begin_block(TAPWriter *object, zsize block_size)
+	{
+	zuint8 header[2];
+
+	if (block_size > 0xFFFF) return FALSE;
+	header[0] = (zuint8)block_size;
+	header[1] = (zuint8)(block_size >> 8);
+	return append(object, header, 2);
+	}
+
+
+zboolean tap_writer_write(TAPWriter *object, zuint8 const *data, zsize data_size)
+	{return append(object, data, data_size);}
+
+
+/* TAP.c EOF */
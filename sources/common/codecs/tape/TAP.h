@@ -0,0 +1,45 @@
+/* TAP Writer v1.0
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+#ifndef mZX_codecs_tape_TAP_h
+#define mZX_codecs_tape_TAP_h
+
+#include <Z/types/base.h>
+
+#define TAP_WRITER_BUFFER_SIZE (1024 * 64)
+
+typedef struct {
+	int    file;
+	zsize  buffer_fill;
+	zuint8 buffer[TAP_WRITER_BUFFER_SIZE];
+} TAPWriter;
+
+Z_C_SYMBOLS_BEGIN
+
+zboolean tap_writer_open       (TAPWriter*    object,
+				char const*   file_path);
+
+zboolean tap_writer_close      (TAPWriter*    object);
+
+zboolean tap_writer_flush      (TAPWriter*    object);
+
+zboolean tap_writer_write_block(TAPWriter*    object,
+				zuint8 const* block,
+				zsize	      block_size);
+
+zboolean tap_writer_begin_block(TAPWriter*    object,
+				zsize	      block_size);
+
+zboolean tap_writer_write      (TAPWriter*    object,
+				zuint8 const* data,
+				zsize	      data_size);
+
+Z_C_SYMBOLS_END
+
+#endif /* mZX_codecs_tape_TAP_h */
@@ -0,0 +1,296 @@
+/* Audio Tape Reader v1.0
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+#include "audio.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#	define USE_SSE2
+#endif
+
+#define RAW_SAMPLE_RATE		  44100
+#define DEFAULT_HYSTERESIS	  2048
+#define RELEASE_GRANULARITY	  (1024 * 1024)
+
+#define LE16(p) ((zuint16)((p)[0] | ((p)[1] << 8)))
+#define LE32(p) ((zuint32)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((zuint32)(p)[3] << 24)))
+
+
+/* MARK: - Container Parsing
+
+   Only two layouts are recognized: RIFF/WAVE with PCM samples of 8 or 16
+   bits and any number of channels, and header-less raw files, which are
+   read as 8 bit unsigned mono sampled at 44100 Hz. Only the first channel
+   is demodulated. */
+
+Z_PRIVATE zboolean parse_wav(AudioTape *object)
+	{
+	zuint8 const *p = object->data, *e = p + object->data_size;
+	zuint16 format = 0, bits = 0;
+	zuint32 chunk_size;
+
+	if (	object->data_size < 12	    ||
+		memcmp(p,     "RIFF", 4)    ||
+		memcmp(p + 8, "WAVE", 4)
+	)
+		return FALSE;
+
+	for (p += 12; e - p >= 8; p += 8 + chunk_size + (chunk_size & 1))
+		{
+		chunk_size = LE32(p + 4);
+
+		if (!memcmp(p, "fmt ", 4) && chunk_size >= 16 && e - p >= 24)
+			{
+			format		      = LE16(p +  8);
+			object->channel_count = (zuint8)LE16(p + 10);
+			object->sample_rate   = LE32(p + 12);
+			bits		      = LE16(p + 22);
+			}
+
+		else if (!memcmp(p, "data", 4))
+			{
+			object->samples = p + 8;
+			object->sample_count = (zsize)(e - object->samples) < chunk_size
+				? (zsize)(e - object->samples)
+				: chunk_size;
+			break;
+			}
+
+		if ((zsize)(e - p) < 8 + chunk_size) return FALSE;
+		}
+
+	if (	object->samples == NULL	      ||
+		(format != 1 && format != 0xFFFE) ||
+		(bits	!= 8 && bits   != 16)	  ||
+		!object->channel_count		  ||
+		!object->sample_rate
+	)
+		return FALSE;
+
+	object->sample_size   = (zuint8)(bits / 8);
+	object->frame_size    = object->sample_size * object->channel_count;
+	object->sample_count /= object->frame_size;
+	return TRUE;
+	}
+
+
+/* MARK: - Sample Access */
+
+Z_INLINE zint16 sample_at(AudioTape *object, zsize index)
+	{
+	zuint8 const *p = object->samples + index * object->frame_size;
+
+	return object->sample_size == 1
+		? (zint16)(((zint)*p - 128) << 8)
+		: (zint16)LE16(p);
+	}
+
+
+/* MARK: - Edge Search
+
+   The demodulator is a Schmitt trigger: while the signal is high, the next
+   edge is the first sample below the low threshold, and while it is low,
+   the first sample above the high threshold. Both searches are "find first
+   element matching a comparison", so they vectorize well; the scalar loop
+   only handles the tail and layouts the vector path does not cover. */
+
+Z_PRIVATE zsize find_edge(AudioTape *object, zsize index, zboolean falling)
+	{
+	zint16 threshold = falling ? object->low_threshold : object->high_threshold;
+	zsize end = object->sample_count;
+
+#	ifdef USE_SSE2
+	zsize frame_size = object->frame_size;
+
+	if (frame_size == 1 || frame_size == 2 || frame_size == 4)
+		{
+		zuint8 const *p = object->samples + index * frame_size;
+		zuint8 const *e = object->samples + end * frame_size;
+		zuint mask = frame_size == 1 ? 0xFFFF : (frame_size == 2 ? 0x5555 : 0x1111);
+		__m128i t, v;
+		zuint bits;
+
+		if (object->sample_size == 1)
+			{
+			__m128i bias = _mm_set1_epi8((char)0x80);
+
+			t = _mm_set1_epi8((char)(threshold >> 8));
+
+			for (; e - p >= 16; p += 16)
+				{
+				v = _mm_xor_si128(_mm_loadu_si128((__m128i const *)p), bias);
+				v = falling ? _mm_cmplt_epi8(v, t) : _mm_cmpgt_epi8(v, t);
+
+				if ((bits = (zuint)_mm_movemask_epi8(v) & mask))
+					return (zsize)(p - object->samples + __builtin_ctz(bits)) / frame_size;
+				}
+			}
+
+		else	{
+			t = _mm_set1_epi16(threshold);
+
+			for (; e - p >= 16; p += 16)
+				{
+				v = _mm_loadu_si128((__m128i const *)p);
+				v = falling ? _mm_cmplt_epi16(v, t) : _mm_cmpgt_epi16(v, t);
+
+				if ((bits = (zuint)_mm_movemask_epi8(v) & mask))
+					return (zsize)(p - object->samples + __builtin_ctz(bits)) / frame_size;
+				}
+			}
+
+		index = (zsize)(p - object->samples) / frame_size;
+		}
+#	endif
+
+	if (falling)
+		{for (; index < end; index++) if (sample_at(object, index) < threshold) return index;}
+
+	else	{for (; index < end; index++) if (sample_at(object, index) > threshold) return index;}
+
+	return end;
+	}
+
+
+/* MARK: - Memory Release
+
+   The file is mapped as a whole, but the pages behind the read position
+   are dropped from time to time, so the resident size stays bounded no
+   matter how long the recording is. */
+
+Z_PRIVATE void release_consumed_pages(AudioTape *object)
+	{
+	zsize page_size = (zsize)sysconf(_SC_PAGESIZE);
+	zsize consumed	= (zsize)(object->samples - object->data) + object->position * object->frame_size;
+
+	consumed &= ~(page_size - 1);
+
+	if (consumed - object->released_size >= RELEASE_GRANULARITY)
+		{
+		madvise((void *)(object->data + object->released_size),
+			consumed - object->released_size, MADV_DONTNEED);
+
+		object->released_size = consumed;
+		}
+	}
+
+
+/* MARK: - Public Functions */
+
+zboolean audio_tape_open(AudioTape *object, char const *file_path, zuint cpu_clock)
+	{
+	struct stat file_status;
+	void *data;
+	int file;
+
+	memset(object, 0, sizeof(AudioTape));
+
+	if ((file = open(file_path, O_RDONLY)) == -1) return FALSE;
+
+	if (fstat(file, &file_status) || !file_status.st_size)
+		{
+		close(file);
+		return FALSE;
+		}
+
+	data = mmap(NULL, (size_t)file_status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) return FALSE;
+	madvise(data, (size_t)file_status.st_size, MADV_SEQUENTIAL);
+
+	object->data	  = data;
+	object->data_size = (zsize)file_status.st_size;
+	object->cpu_clock = cpu_clock;
+
+	if (!parse_wav(object))
+		{
+		object->samples	      = object->data;
+		object->sample_count  = object->data_size;
+		object->sample_rate   = RAW_SAMPLE_RATE;
+		object->sample_size   = 1;
+		object->channel_count = 1;
+		object->frame_size    = 1;
+		}
+
+	object->high_threshold =  DEFAULT_HYSTERESIS;
+	object->low_threshold  = -DEFAULT_HYSTERESIS;
+	return TRUE;
+	}
+
+
+void audio_tape_close(AudioTape *object)
+	{
+	if (object->data != NULL)
+		{
+		munmap((void *)object->data, object->data_size);
+		object->data = NULL;
+		}
+	}
+
+
+void audio_tape_rewind(AudioTape *object)
+	{
+	object->position	= 0;
+	object->released_size	= 0;
+	object->level		= FALSE;
+	object->last_edge_cycle = 0;
+	object->pulse_index	= 0;
+	object->pulse_count	= 0;
+	}
+
+
+zsize audio_tape_read_pulses(AudioTape *object, zuint32 *pulses, zsize pulse_count)
+	{
+	zsize index, count = 0;
+	zuint64 cycle, pulse;
+
+	while (count < pulse_count)
+		{
+		if ((index = find_edge(object, object->position, object->level)) == object->sample_count)
+			{
+			object->position = index;
+			break;
+			}
+
+		cycle = ((zuint64)index * object->cpu_clock) / object->sample_rate;
+		pulse = cycle - object->last_edge_cycle;
+
+		pulses[count++] = pulse ? (pulse > 0xFFFFFFFF ? 0xFFFFFFFF : (zuint32)pulse) : 1;
+		object->last_edge_cycle = cycle;
+		object->level		= !object->level;
+		object->position	= index + 1;
+		}
+
+	release_consumed_pages(object);
+	return count;
+	}
+
+
+zuint32 audio_tape_next_pulse(AudioTape *object)
+	{
+	if (object->pulse_index == object->pulse_count)
+		{
+		object->pulse_index = 0;
+
+		if (!(object->pulse_count = audio_tape_read_pulses
+			(object, object->pulses, AUDIO_TAPE_PULSE_BUFFER_SIZE))
+		)
+			return 0;
+		}
+
+	return object->pulses[object->pulse_index++];
+	}
+
+
+/* audio.c EOF */
@@ -0,0 +1,56 @@
+/* Audio Tape Reader v1.0
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+#ifndef mZX_codecs_tape_audio_h
+#define mZX_codecs_tape_audio_h
+
+#include <Z/types/base.h>
+
+#define AUDIO_TAPE_PULSE_BUFFER_SIZE 256
+
+typedef struct {
+	zuint8 const* data;
+	zsize	      data_size;
+	zuint8 const* samples;
+	zsize	      sample_count;
+	zsize	      frame_size;
+	zsize	      position;
+	zsize	      released_size;
+	zuint	      sample_rate;
+	zuint	      cpu_clock;
+	zuint8	      sample_size;
+	zuint8	      channel_count;
+	zboolean      level;
+	zint16	      high_threshold;
+	zint16	      low_threshold;
+	zuint64	      last_edge_cycle;
+	zuint32	      pulses[AUDIO_TAPE_PULSE_BUFFER_SIZE];
+	zsize	      pulse_index;
+	zsize	      pulse_count;
+} AudioTape;
+
+Z_C_SYMBOLS_BEGIN
+
+zboolean audio_tape_open       (AudioTape*  object,
+				char const* file_path,
+				zuint	    cpu_clock);
+
+void	 audio_tape_close      (AudioTape*  object);
+
+void	 audio_tape_rewind     (AudioTape*  object);
+
+zsize	 audio_tape_read_pulses(AudioTape*  object,
+				zuint32*    pulses,
+				zsize	    pulse_count);
+
+zuint32	 audio_tape_next_pulse (AudioTape*  object);
+
+Z_C_SYMBOLS_END
+
+#endif /* mZX_codecs_tape_audio_h */
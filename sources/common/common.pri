@@ -1,10 +1,22 @@
 SOURCES += \
 	$$P_SOURCES/common/system.c \
-	$$P_SOURCES/common/GLVideoOutput.cpp \
+	$$P_SOURCES/common/MachinePool.c \
+	$$P_SOURCES/common/ROMRegistry.c \
+	$$P_SOURCES/common/OpenGL.cpp \
+	$$P_SOURCES/common/Matrix.cpp \
+	$$P_SOURCES/common/GLFrameBufferRenderer.cpp \
 	$$P_SOURCES/common/Machine.cpp \
+	$$P_SOURCES/common/FileAudioOutputPlayer.cpp \
+	$$P_SOURCES/common/NullAudioOutputPlayer.cpp \
 
 HEADERS += \
-	$$P_SOURCES/common/OpenGL.h \
+	$$P_SOURCES/common/OpenGL.hpp \
 	$$P_SOURCES/common/system.h \
-	$$P_SOURCES/common/GLVideoOutput.hpp \
+	$$P_SOURCES/common/MachinePool.h \
+	$$P_SOURCES/common/ROMRegistry.h \
+	$$P_SOURCES/common/Matrix.hpp \
+	$$P_SOURCES/common/GLFrameBufferRenderer.hpp \
 	$$P_SOURCES/common/Machine.hpp \
+	$$P_SOURCES/common/AudioOutputPlayer.hpp \
+	$$P_SOURCES/common/FileAudioOutputPlayer.hpp \
+	$$P_SOURCES/common/NullAudioOutputPlayer.hpp \
@@ -0,0 +1,628 @@
+/* Zilog Z80 CPU Emulator - Lockstep Batch
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*------------------------------------------------------------------.
+| Copy of the Z80 core used by the batch to run the instructions it |
+| does not vectorize. A machine can compile its own batch with the  |
+| memory accesses inlined, by defining CPU_Z80_INLINE_* before      |
+| including this file, the same way it does with "Z80.c".           |
+'------------------------------------------------------------------*/
+
+#define CPU_Z80_HIDE_API
+#define CPU_Z80_API static /* Z80.h is first included by "Z80 Batch.h" */
+#define CPU_Z80_ABI
+
+#include "Z80 Batch.h"
+#include "Z80.c"
+
+#define LANES	   Z80_BATCH_LANE_COUNT
+#define EACH_LANE  for (i = 0; i < LANES; i++)
+#define REGISTER_F 6
+#define REGISTER_A 7
+
+
+/* MARK: - Vectorized Instruction Subset
+
+   Size of the instructions that the batch executes across lanes, or 0 for
+   those left to the Z80 objects: everything that accesses memory (other
+   than to fetch itself), the stack, I/O, SP, the index registers or the
+   interrupt state, plus the prefixed instructions. What remains is the
+   register arithmetic and the jumps, which is what the loops of a game
+   are mostly made of. */
+
+static zuint8 const vector_instruction_sizes[256] = {
+/*	0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+/* 0 */ 1, 0, 0, 1, 1, 1, 2, 1, 0, 0, 0, 1, 1, 1, 2, 1,
+/* 1 */ 2, 0, 0, 1, 1, 1, 2, 1, 2, 0, 0, 1, 1, 1, 2, 1,
+/* 2 */ 2, 0, 0, 1, 1, 1, 2, 0, 2, 0, 0, 1, 1, 1, 2, 1,
+/* 3 */ 2, 0, 0, 0, 0, 0, 0, 1, 2, 0, 0, 0, 1, 1, 2, 1,
+/* 4 */ 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+/* 5 */ 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+/* 6 */ 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+/* 7 */ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 1,
+/* 8 */ 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+/* 9 */ 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+/* A */ 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+/* B */ 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 0, 1,
+/* C */ 0, 0, 3, 3, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 2, 0,
+/* D */ 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 2, 0,
+/* E */ 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 2, 0,
+/* F */ 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 2, 0
+};
+
+/*----------------------------------------------------------------.
+| Flag tested by each pair of conditions (nz/z, nc/c, po/pe, p/m) |
+'----------------------------------------------------------------*/
+static zuint8 const condition_flags[4] = {ZF, CF, PF, SF};
+
+
+/* MARK: - Lane Access */
+
+Z_INLINE zuint8 lane_read(Z80 *object, zuint16 address)
+	{return READ_8(address);}
+
+
+Z_INLINE zboolean lane_has_code(Z80 *object, zuint16 address, zuint8 const *bytes, zuint size)
+	{
+	zuint index;
+
+	for (index = 0; index < size; index++)
+		if (READ_8(address + index) != bytes[index]) return FALSE;
+
+	return TRUE;
+	}
+
+
+/*-------------------------------------------------------------------.
+| A lane can only take part in a vector instruction if nothing would |
+| happen before the instruction is fetched: no interrupt to accept,  |
+| no HALT, no EI delay to clear and no trap to call.                 |
+'-------------------------------------------------------------------*/
+Z_INLINE zboolean lane_is_ready(Z80 *object)
+	{return !HALT && !NMI && !EI && !(INT && IFF1) && CB_ACTION(trap) == NULL;}
+
+
+Z_INLINE zboolean lane_is_idle(Z80 *object)
+	{return HALT && !NMI && !(INT && IFF1);}
+
+
+Z_PRIVATE void load_lane(Z80Batch *batch, zuint index)
+	{
+	Z80 *object = batch->lanes[index];
+
+	batch->soa.r8[0][index]		 = B;
+	batch->soa.r8[1][index]		 = C;
+	batch->soa.r8[2][index]		 = D;
+	batch->soa.r8[3][index]		 = E;
+	batch->soa.r8[4][index]		 = H;
+	batch->soa.r8[5][index]		 = L;
+	batch->soa.r8[REGISTER_F][index] = F;
+	batch->soa.r8[REGISTER_A][index] = A;
+	batch->soa.pc[index]		 = PC;
+	batch->soa.r[index]		 = R;
+	batch->soa.ready[index]		 = lane_is_ready(object);
+	}
+
+
+Z_PRIVATE void store_lane(Z80Batch *batch, zuint index)
+	{
+	Z80 *object = batch->lanes[index];
+
+	B  = batch->soa.r8[0][index];
+	C  = batch->soa.r8[1][index];
+	D  = batch->soa.r8[2][index];
+	E  = batch->soa.r8[3][index];
+	H  = batch->soa.r8[4][index];
+	L  = batch->soa.r8[5][index];
+	F  = batch->soa.r8[REGISTER_F][index];
+	A  = batch->soa.r8[REGISTER_A][index];
+	PC = batch->soa.pc[index];
+	R  = batch->soa.r[index];
+	}
+
+
+/*------------------------------------------------------------------.
+| Runs one instruction of a lane on its Z80 object. The cycle count |
+| is resumed instead of restarted, so the machine callbacks see the |
+| same CYCLES as in a z80_run. A lane halted with no interrupt to   |
+| accept, or the last one left running, goes to the end of the run  |
+| at once.                                                          |
+'------------------------------------------------------------------*/
+Z_PRIVATE void scalar_step(Z80Batch *object, zuint index, zsize cycles, zboolean alone)
+	{
+	Z80 *lane = object->lanes[index];
+
+	store_lane(object, index);
+	lane->cycles = object->soa.cycles[index];
+	object->soa.cycles[index] = run(lane, alone || lane_is_idle(lane) ? cycles : lane->cycles + 1);
+	load_lane(object, index);
+	object->statistics.scalar_instructions++;
+	}
+
+
+/* MARK: - Vector Execution
+
+   All the lanes are processed by every loop, with the lanes that are not
+   taking part masked out, so the loops have a fixed trip count and no
+   branches, and the compiler can turn them into SIMD code. Results are
+   merged with BLEND rather than stored conditionally, which SSE2 lacks.
+   The loops only address arrays of the batch or locals, never zuint8
+   pointers, which could alias anything and would defeat vectorization.
+   The operation is the same for every lane of a group, so it is decoded
+   only once, outside the loops. */
+
+#define MASK	   object->soa.mask
+#define VALUES	   object->soa.values
+#define ROW(index) object->soa.r8[index]
+#define BLEND(mask, new, old) (((new) & (mask)) | ((old) & ~(mask)))
+
+
+Z_INLINE zuint8 parity(zuint8 value)
+	{
+	value ^= value >> 4;
+	value ^= value >> 2;
+	value ^= value >> 1;
+	return (~value & 1) << 2; /* PF = Parity */
+	}
+
+
+Z_PRIVATE void vector_refresh(Z80Batch *object)
+	{
+	zuint i;
+
+	EACH_LANE object->soa.r[i] = (object->soa.r[i] & 128) | ((object->soa.r[i] + MASK[i]) & 127);
+	}
+
+
+/*----------------------------------------------------------.
+| VALUES holds whether each lane takes the branch (0 or 1). |
+'----------------------------------------------------------*/
+Z_PRIVATE void vector_branch(Z80Batch *object, zuint16 target, zuint16 next, zuint8 taken_cycles, zuint8 cycles)
+	{
+	zuint16 m;
+	zuint i;
+
+	EACH_LANE
+		{
+		m = -MASK[i];
+		object->soa.pc[i] = BLEND(m, BLEND((zuint16)-VALUES[i], target, next), object->soa.pc[i]);
+		}
+
+	EACH_LANE object->soa.cycles[i] += MASK[i] * (cycles + VALUES[i] * (taken_cycles - cycles));
+	}
+
+
+Z_PRIVATE void vector_advance(Z80Batch *object, zuint16 pc, zuint8 cycles)
+	{
+	zuint i;
+
+	EACH_LANE VALUES[i] = 0;
+	vector_branch(object, pc, pc, cycles, cycles);
+	}
+
+
+Z_PRIVATE void vector_load(Z80Batch *object, zuint8 x)
+	{
+	zuint8 m;
+	zuint i;
+
+	EACH_LANE
+		{
+		m	  = -MASK[i];
+		ROW(x)[i] = BLEND(m, VALUES[i], ROW(x)[i]);
+		}
+	}
+
+
+/*-------------------------------------------------------------------.
+| add, adc, sub, sbc and cp share one loop: a subtraction is the sum |
+| of the complement with the carry inverted, and cp only differs in  |
+| where YF and XF come from and in leaving A untouched.              |
+'-------------------------------------------------------------------*/
+Z_PRIVATE void vector_arithmetic(Z80Batch *object, zuint8 operation)
+	{
+	zuint8 *a	  = ROW(REGISTER_A);
+	zuint8 *f	  = ROW(REGISTER_F);
+	zuint8 subtract	  = operation >= 2;
+	zuint8 carry	  = operation == 1 || operation == 3 ? CF : 0;
+	zuint8 compare	  = operation == 7 ? 0xFF : 0;
+	zuint8 complement = subtract ? 0xFF : 0;
+	zuint8 v, t, m, flags;
+	zuint  total, i;
+
+	EACH_LANE
+		{
+		v     = VALUES[i] ^ complement;
+		total = a[i] + v + ((f[i] & carry) ^ subtract);
+		t     = (zuint8)total;
+		m     = -MASK[i];
+
+		flags =	(((total >> 8) ^ subtract) & CF)	/* CF = Carry / Borrow		     */
+			| (subtract << 1)			/* NF = subtract		     */
+			| ((((a[i] ^ t) & (v ^ t)) >> 5) & PF)	/* PF = Overflow		     */
+			| ((a[i] ^ VALUES[i] ^ t) & HF)		/* HF = Half-carry / Half-borrow     */
+			| (BLEND(compare, VALUES[i], t) & YXF)	/* YF = t.5 / v.5; XF = t.3 / v.3    */
+			| (t & SF)				/* SF = t.7			     */
+			| ZF_ZERO(t);				/* ZF = !t			     */
+
+		f[i] = BLEND(m, flags, f[i]);
+		a[i] = BLEND(m & ~compare, t, a[i]);
+		}
+	}
+
+
+#define VECTOR_LOGIC(name, operator, hf)						   \
+Z_PRIVATE void vector_##name(Z80Batch *object)						   \
+	{										   \
+	zuint8 *a = ROW(REGISTER_A);							   \
+	zuint8 *f = ROW(REGISTER_F);							   \
+	zuint8 t, m;									   \
+	zuint i;									   \
+											   \
+	EACH_LANE									   \
+		{									   \
+		t    = a[i] operator VALUES[i];						   \
+		m    = -MASK[i];							   \
+		f[i] = BLEND(m, hf | parity(t) | (t & SYXF) | ZF_ZERO(t), f[i]);	   \
+		a[i] = BLEND(m, t, a[i]);						   \
+		}									   \
+	}
+
+VECTOR_LOGIC(and, &, HF)
+VECTOR_LOGIC(xor, ^, 0 )
+VECTOR_LOGIC(or,  |, 0 )
+
+
+Z_PRIVATE void vector_alu(Z80Batch *object, zuint8 operation)
+	{
+	switch (operation)
+		{
+		case 4:	 vector_and(object); break;
+		case 5:	 vector_xor(object); break;
+		case 6:	 vector_or (object); break;
+		default: vector_arithmetic(object, operation);
+		}
+	}
+
+
+Z_PRIVATE void vector_inc_dec(Z80Batch *object, zuint8 x, zboolean decrement)
+	{
+	zuint8 *f    = ROW(REGISTER_F);
+	zuint8 delta = decrement ? 0xFF : 1;
+	zuint8 limit = decrement ? 128 : 127;
+	zuint8 n     = decrement ? NF : 0;
+	zuint8 flags[LANES], t, m;
+	zuint i;
+
+	EACH_LANE
+		{
+		VALUES[i] = t = ROW(x)[i] + delta;
+
+		flags[i]  = (f[i] & CF)			 /* CF unchanged		  */
+			    | n				 /* NF = decrement		  */
+			    | ((ROW(x)[i] == limit) << 2) /* PF = Overflow		  */
+			    | (t & SYXF)		 /* SF = t.7; YF = t.5; XF = t.3  */
+			    | ((ROW(x)[i] ^ 1 ^ t) & HF)  /* HF = Half-carry / Half-borrow */
+			    | ZF_ZERO(t);		 /* ZF = !t			  */
+		}
+
+	/*-----------------------------------------------------------.
+	| Merged apart, as x is not known not to be F until run time |
+	'-----------------------------------------------------------*/
+	EACH_LANE
+		{
+		m    = -MASK[i];
+		f[i] = BLEND(m, flags[i], f[i]);
+		}
+
+	EACH_LANE
+		{
+		m	  = -MASK[i];
+		ROW(x)[i] = BLEND(m, VALUES[i], ROW(x)[i]);
+		}
+	}
+
+
+Z_PRIVATE void vector_inc_dec_pair(Z80Batch *object, zuint8 pair, zboolean decrement)
+	{
+	zuint16 delta = decrement ? 0xFFFF : 1, t, m;
+	zuint i;
+
+	EACH_LANE
+		{
+		m = -MASK[i];
+		t = (ROW(pair * 2)[i] << 8) | ROW(pair * 2 + 1)[i];
+		t = BLEND(m, (zuint16)(t + delta), t);
+
+		ROW(pair * 2	)[i] = (zuint8)(t >> 8);
+		ROW(pair * 2 + 1)[i] = (zuint8)t;
+		}
+	}
+
+
+/*---------------------------------------------------.
+| rlca, rrca, rla, rra, cpl, scf and ccf, which only |
+| touch A and F (see Z80.c for the flags of each).   |
+'---------------------------------------------------*/
+#define ACCUMULATOR(t_value, flags_value)	    \
+	EACH_LANE				    \
+		{				    \
+		t    = t_value;			    \
+		m    = -MASK[i];		    \
+		f[i] = BLEND(m, flags_value, f[i]); \
+		a[i] = BLEND(m, t, a[i]);	    \
+		}
+
+Z_PRIVATE void vector_accumulator(Z80Batch *object, zuint8 opcode)
+	{
+	zuint8 *a = ROW(REGISTER_A);
+	zuint8 *f = ROW(REGISTER_F);
+	zuint8 t, m;
+	zuint i;
+
+	switch (opcode)
+		{
+		case 0x07: /* rlca */
+		ACCUMULATOR(Z_8BIT_ROTATE_LEFT(a[i], 1), (f[i] & SZPF) | (t & YXCF))
+		break;
+
+		case 0x0F: /* rrca */
+		ACCUMULATOR(Z_8BIT_ROTATE_RIGHT(a[i], 1), (f[i] & SZPF) | (t & YXF) | (t >> 7))
+		break;
+
+		case 0x17: /* rla */
+		ACCUMULATOR((zuint8)((a[i] << 1) | (f[i] & CF)), (f[i] & SZPF) | (t & YXF) | (a[i] >> 7))
+		break;
+
+		case 0x1F: /* rra */
+		ACCUMULATOR((zuint8)((a[i] >> 1) | (f[i] << 7)), (f[i] & SZPF) | (t & YXF) | (a[i] & CF))
+		break;
+
+		case 0x2F: /* cpl */
+		ACCUMULATOR((zuint8)~a[i], (f[i] & (SF | ZF | PF | CF)) | HF | NF | (t & YXF))
+		break;
+
+		case 0x37: /* scf */
+		ACCUMULATOR(a[i], (f[i] & SZPF) | (t & YXF) | CF)
+		break;
+
+		default: /* ccf */
+		ACCUMULATOR(a[i], (f[i] & SZPF) | (t & YXF) | ((f[i] & CF) << 4) | (~f[i] & CF))
+		}
+	}
+
+
+/*----------------------------------------------------------------.
+| jp Z,WORD and jr Z,OFFSET send each lane its own way; the group |
+| is split by the next selection of the leader.                   |
+'----------------------------------------------------------------*/
+Z_PRIVATE void vector_jump(
+	Z80Batch* object,
+	zuint8	  condition,
+	zuint16	  target,
+	zuint16	  next,
+	zuint8	  taken_cycles,
+	zuint8	  cycles
+)
+	{
+	zuint8 flag = condition_flags[condition >> 1], polarity = condition & 1;
+	zuint i;
+
+	EACH_LANE VALUES[i] = ((ROW(REGISTER_F)[i] & flag) == 0) ^ polarity;
+	vector_branch(object, target, next, taken_cycles, cycles);
+	}
+
+
+Z_PRIVATE void vector_djnz(Z80Batch *object, zuint16 target, zuint16 next)
+	{
+	zuint i;
+
+	EACH_LANE
+		{
+		ROW(0)[i] -= MASK[i];
+		VALUES[i]  = ROW(0)[i] != 0;
+		}
+
+	vector_branch(object, target, next, 13, 8);
+	}
+
+
+Z_PRIVATE void vector_execute(Z80Batch *object, zuint16 pc, zuint8 const *bytes)
+	{
+	zuint8 opcode = bytes[0], cycles = 4;
+	zuint16 next = pc + vector_instruction_sizes[opcode];
+	zuint16 word = bytes[1] | (bytes[2] << 8);
+	zuint16 relative = next + (zint8)bytes[1];
+	zuint i;
+
+	vector_refresh(object);
+
+	switch (opcode >> 6)
+		{
+		case 0:
+
+		switch (opcode & 7)
+			{
+			case 0:
+			if (opcode == 0x10) {vector_djnz(object, relative, next); return;}
+			if (opcode >= 0x20) {vector_jump(object, (opcode >> 3) & 3, relative, next, 12, 7); return;}
+
+			if (opcode == 0x18)
+				{
+				EACH_LANE VALUES[i] = 1;
+				vector_branch(object, relative, next, 12, 12);
+				return;
+				}
+
+			break; /* nop */
+
+			case 3:
+			vector_inc_dec_pair(object, opcode >> 4, opcode & 8);
+			cycles = 6;
+			break;
+
+			case 4: vector_inc_dec(object, (opcode >> 3) & 7, FALSE); break;
+			case 5: vector_inc_dec(object, (opcode >> 3) & 7, TRUE ); break;
+
+			case 6:
+			EACH_LANE VALUES[i] = bytes[1];
+			vector_load(object, (opcode >> 3) & 7);
+			cycles = 7;
+			break;
+
+			default: vector_accumulator(object, opcode);
+			}
+
+		break;
+
+		case 1:
+		EACH_LANE VALUES[i] = ROW(opcode & 7)[i];
+		vector_load(object, (opcode >> 3) & 7);
+		break;
+
+		case 2:
+		EACH_LANE VALUES[i] = ROW(opcode & 7)[i];
+		vector_alu(object, (opcode >> 3) & 7);
+		break;
+
+		default:
+
+		if (opcode == 0xC3)
+			{
+			EACH_LANE VALUES[i] = 1;
+			vector_branch(object, word, next, 10, 10);
+			return;
+			}
+
+		if ((opcode & 7) == 2)
+			{
+			vector_jump(object, (opcode >> 3) & 7, word, next, 10, 10);
+			return;
+			}
+
+		EACH_LANE VALUES[i] = bytes[1];
+		vector_alu(object, (opcode >> 3) & 7);
+		cycles = 7;
+		}
+
+	vector_advance(object, next, cycles);
+	}
+
+
+/* MARK: - Main Functions */
+
+void z80_batch_run(Z80Batch *object, zsize cycles)
+	{
+	zuint8 bytes[3] = {0, 0, 0};
+	zuint32 key, lowest;
+	zuint16 pc;
+	zuint i, leader, size, count, remaining;
+	zboolean shared;
+
+	/*------------------------------------------.
+	| Move the registers of the lanes to arrays |
+	'------------------------------------------*/
+	EACH_LANE
+		{
+		if (i < object->lane_count)
+			{
+			load_lane(object, i);
+			object->soa.cycles[i] = 0;
+			}
+
+		else	{
+			object->soa.cycles[i] = cycles;
+			object->soa.ready [i] = FALSE;
+			}
+		}
+
+	while (TRUE)
+		{
+		/*-------------------------------------------------------------.
+		| The lane with the lowest PC leads: lanes that jumped forward |
+		| wait for the others to reach them, so they tend to regroup.  |
+		'-------------------------------------------------------------*/
+		for (lowest = 0x10000, remaining = 0, i = 0; i < LANES; i++)
+			{
+			key = object->soa.cycles[i] < cycles ? object->soa.pc[i] : 0x10000;
+			lowest = key < lowest ? key : lowest;
+			remaining += key != 0x10000;
+			}
+
+		if (lowest == 0x10000) break;
+		pc = (zuint16)lowest;
+
+		for (leader = 0;
+		     object->soa.pc[leader] != pc || object->soa.cycles[leader] >= cycles;
+		     leader++
+		);
+
+		/*---------------------------------------------------.
+		| Instructions outside the vectorized subset are run |
+		| on the Z80 object of every lane at PC, one by one. |
+		'---------------------------------------------------*/
+		if (	!object->soa.ready[leader] ||
+			!(size = vector_instruction_sizes[bytes[0] = lane_read(object->lanes[leader], pc)])
+		)
+			{
+			for (i = leader; i < object->lane_count; i++)
+				if (object->soa.cycles[i] < cycles && object->soa.pc[i] == pc)
+					scalar_step(object, i, cycles, remaining == 1);
+
+			continue;
+			}
+
+		for (i = 1; i < size; i++) bytes[i] = lane_read(object->lanes[leader], pc + i);
+		shared = pc + size <= object->shared_code_size;
+
+		/*--------------------------------------------------------.
+		| The group is formed by the ready lanes at PC whose code |
+		| is the same as that of the leader.                      |
+		'--------------------------------------------------------*/
+		for (count = 0, i = 0; i < LANES; i++) count += (MASK[i] =
+			(i >= leader)			   &
+			(object->soa.cycles[i] < cycles) &
+			(object->soa.pc[i] == pc)	   &
+			object->soa.ready[i]);
+
+		if (!shared) for (i = leader + 1; i < object->lane_count; i++)
+			if (MASK[i] && !lane_has_code(object->lanes[i], pc, bytes, size))
+				{
+				MASK[i] = FALSE;
+				count--;
+				}
+
+		/*---------------------------------------------------------.
+		| A lane alone at PC has diverged from the others, it runs |
+		| as a scalar until it meets them again.                   |
+		'---------------------------------------------------------*/
+		if (count == 1)
+			{
+			scalar_step(object, leader, cycles, remaining == 1);
+			continue;
+			}
+
+		vector_execute(object, pc, bytes);
+		object->statistics.vector_instructions++;
+		object->statistics.vector_lane_instructions += count;
+		}
+
+	/*-------------------------------------------------.
+	| Move the registers back and report the cycles of |
+	| each lane as z80_run would                       |
+	'-------------------------------------------------*/
+	for (i = 0; i < object->lane_count; i++)
+		{
+		store_lane(object, i);
+		object->lanes[i]->cycles = object->soa.cycles[i];
+		}
+	}
+
+
+/* Z80 Batch.c EOF */
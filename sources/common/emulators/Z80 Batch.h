@@ -0,0 +1,66 @@
+/* Zilog Z80 CPU Emulator - Lockstep Batch
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2016 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+#ifndef __mZX_emulators_Z80_Batch_H
+#define __mZX_emulators_Z80_Batch_H
+
+#include "Z80.h"
+
+#ifndef Z80_BATCH_LANE_COUNT
+#	define Z80_BATCH_LANE_COUNT 16
+#endif
+
+/*-------------------------------------------------------------------.
+| Runs several Z80 objects executing the same program in lockstep.   |
+| The registers used by the most common instructions are kept in one |
+| array per register (structure of arrays), so an instruction that   |
+| several lanes reach at the same PC is executed for all of them at  |
+| once. The rest of the state stays in the Z80 objects, which also   |
+| execute, one by one, everything the batch does not vectorize.      |
+|                                                                    |
+| r8 is indexed by the register field of the opcodes (b, c, d, e, h, |
+| l, -, a); F takes the place of (hl).                               |
+|                                                                    |
+| Experimental: it is slower than running the lanes one by one on    |
+| the Spectrum ROM, so it is not part of the application build. See  |
+| the Z80 Batch Benchmark in the development directory.              |
+'-------------------------------------------------------------------*/
+
+typedef struct {
+	zuint	lane_count;
+	Z80*	lanes[Z80_BATCH_LANE_COUNT];
+
+	/*-------------------------------------------------------------.
+	| Code below this address is the same in every lane (i.e. the  |
+	| ROM), so it is only fetched from the lane leading the group. |
+	'-------------------------------------------------------------*/
+	zuint16 shared_code_size;
+
+	struct {zuint8	r8    [8][Z80_BATCH_LANE_COUNT];
+		zuint16 pc    [Z80_BATCH_LANE_COUNT];
+		zuint8	r     [Z80_BATCH_LANE_COUNT];
+		zsize	cycles[Z80_BATCH_LANE_COUNT];
+		zuint8	ready [Z80_BATCH_LANE_COUNT];
+		zuint8	mask  [Z80_BATCH_LANE_COUNT];
+		zuint8	values[Z80_BATCH_LANE_COUNT];
+	} soa;
+
+	struct {zsize vector_instructions;
+		zsize vector_lane_instructions;
+		zsize scalar_instructions;
+	} statistics;
+} Z80Batch;
+
+Z_C_SYMBOLS_BEGIN
+
+void z80_batch_run(Z80Batch* object, zsize cycles);
+
+Z_C_SYMBOLS_END
+
+#endif /* __mZX_emulators_Z80_Batch_H */
@@ -38,11 +38,80 @@ Released under the terms of the GNU General Public License v3. */
 #	include <emulation/CPU/Z80.h>
 #endif
 
+#if DEFINED(USE_JIT) && !defined(__x86_64__)
+#	undef CPU_Z80_USE_JIT
+#endif
+
 
 /* MARK: - Types */
 
 typedef zuint8 (* Instruction)(Z80 *object);
 
+#if DEFINED(USE_BLOCK_CACHE)
+
+#	define BLOCK_CACHE_SIZE	2048
+#	define BLOCK_MAXIMUM_SIZE	16
+#	define BANK_SIZE		16384
+#	define PAGES_PER_BANK		64
+#	define PAGE_INDEX(bank, address) ((bank) * PAGES_PER_BANK + (((address) >> 8) & (PAGES_PER_BANK - 1)))
+
+	typedef struct {
+		Instruction handler;
+		Z32Bit	    data;
+		zuint8	    size;
+		zuint8	    pc_advance;
+		zuint8	    r_increment;
+		zuint8	    xy;
+	} BlockEntry;
+
+#	if DEFINED(USE_JIT)
+
+		typedef void (* NativeBlock)(Z80 *object, zsize cycles);
+
+		typedef struct {
+			zuint8* base;
+			zuint8* code;
+			zsize	size;
+			zsize	used;
+		} CodeArena;
+
+#	endif
+
+	typedef struct {
+		Instruction const* owner;
+		zuint16		   pc;
+		zuint16		   bank;
+		zuint32		   generation;
+		zuint8		   entry_count;
+		BlockEntry	   entries[BLOCK_MAXIMUM_SIZE];
+
+#		if DEFINED(USE_JIT)
+			NativeBlock code;
+			zuint16	    hits;
+#		endif
+	} Block;
+
+	typedef struct SharedROM SharedROM;
+
+	struct SharedROM {
+		SharedROM* next;
+		zuint8	   content[BANK_SIZE];
+		Block*	   blocks[BANK_SIZE];
+	};
+
+	struct Z80BlockCache {
+		zsize	    bank_count;
+		zuint32*    generations;
+		SharedROM** roms;
+		Block	    blocks[BLOCK_CACHE_SIZE];
+
+#		if DEFINED(USE_JIT)
+			CodeArena code;
+#		endif
+	};
+
+#endif
+
 
 /* MARK: - Macros: External */
 
@@ -61,16 +130,61 @@ typedef zuint8 (* Instruction)(Z80 *object);
 #	define CB_OBJECT(name) object->cb_context
 #endif
 
-#define READ_8(address)		CB_ACTION(read	  )(CB_OBJECT(read    ), (address)	   )
-#define WRITE_8(address, value) CB_ACTION(write   )(CB_OBJECT(write   ), (address), (value))
-#define IN(port)		CB_ACTION(in	  )(CB_OBJECT(in      ), (port   )	   )
-#define OUT(port, value)        CB_ACTION(out	  )(CB_OBJECT(out     ), (port   ), (value))
+/*------------------------------------------------------------------.
+| A file can compile its own copy of the core with the memory and   |
+| I/O accesses of a machine inlined, by defining CPU_Z80_INLINE_*   |
+| before including this file (see "ZX Spectrum 48K CPU.c").         |
+'------------------------------------------------------------------*/
+#if DEFINED(INLINE_READ_8)
+#	define READ_8(address) CPU_Z80_INLINE_READ_8(CB_OBJECT(read), (zuint16)(address))
+#else
+#	define READ_8(address) CB_ACTION(read)(CB_OBJECT(read), (address))
+#endif
+
+#if DEFINED(INLINE_WRITE_8)
+#	define WRITE_8(address, value) CPU_Z80_INLINE_WRITE_8(CB_OBJECT(write), (zuint16)(address), (zuint8)(value))
+#else
+#	define WRITE_8(address, value) CB_ACTION(write)(CB_OBJECT(write), (address), (value))
+#endif
+
+#if DEFINED(INLINE_IN)
+#	define IN(port) CPU_Z80_INLINE_IN(CB_OBJECT(in), (zuint16)(port))
+#else
+#	define IN(port) CB_ACTION(in)(CB_OBJECT(in), (port))
+#endif
+
+#if DEFINED(INLINE_OUT)
+#	define OUT(port, value) CPU_Z80_INLINE_OUT(CB_OBJECT(out), (zuint16)(port), (zuint8)(value))
+#else
+#	define OUT(port, value) CB_ACTION(out)(CB_OBJECT(out), (port), (value))
+#endif
+
 #define INT_DATA		CB_ACTION(int_data)(CB_OBJECT(int_data)			   )
 #define READ_OFFSET(address)	(zint8)READ_8(address)
 #define SET_HALT		if (CB_ACTION(halt) != NULL) CB_ACTION(halt)(CB_OBJECT(halt), TRUE )
 #define CLEAR_HALT		if (CB_ACTION(halt) != NULL) CB_ACTION(halt)(CB_OBJECT(halt), FALSE)
 
 
+#if DEFINED(USE_BLOCK_CACHE)
+
+	/*---------------------------------------------------------------.
+	| Every write bumps the generation of the 256 byte page it lands |
+	| in, which invalidates the blocks decoded from that page.       |
+	'---------------------------------------------------------------*/
+	Z_INLINE void write_8bit(Z80 *object, zuint16 address, zuint8 value)
+		{
+		WRITE_8(address, value);
+
+		if (object->block_cache != NULL) object->block_cache->generations
+			[PAGE_INDEX(object->bank[address >> 14], address)]++;
+		}
+
+#	undef  WRITE_8
+#	define WRITE_8(address, value) write_8bit(object, (address), (value))
+
+#endif
+
+
 Z_INLINE zuint16 read_16bit(Z80 *object, zuint16 address)
 	{return (READ_8(address) | READ_8(address + 1) << 8);}
 
@@ -178,6 +292,82 @@ Z_INLINE void write_16bit(Z80 *object, zuint16 address, zuint16 value)
 #define ZF_ZERO(value) (!(value) << 6)
 
 
+/* MARK: - Lazy Flags
+.----------------------------------------------------------------------------.
+| Most of the flags set by an ALU instruction are overwritten by the next    |
+| one before anything reads them. In this mode the 8 bit arithmetic,         |
+| logical, INC and DEC instructions only record the operation and its        |
+| operands, and F is computed from them the first time it is accessed. The   |
+| carry alone, which ADC, SBC, RL, RR, INC and DEC need, is cheaper to get   |
+| than the whole register. F is always up to date when z80_run returns and   |
+| when a trap is called.                                                     |
+'----------------------------------------------------------------------------*/
+
+#if DEFINED(USE_LAZY_FLAGS)
+
+#	define LAZY_FLAGS_NONE 0
+#	define LAZY_FLAGS_ADD  1
+#	define LAZY_FLAGS_ADC  2
+#	define LAZY_FLAGS_SUB  3
+#	define LAZY_FLAGS_SBC  4
+#	define LAZY_FLAGS_AND  5
+#	define LAZY_FLAGS_XOR  6
+#	define LAZY_FLAGS_OR   7
+#	define LAZY_FLAGS_CP   8
+#	define LAZY_FLAGS_INC  9
+#	define LAZY_FLAGS_DEC 10
+
+#	define LAZY object->lazy_flags
+
+	Z_PRIVATE void resolve_flags(Z80 *object);
+
+
+	Z_INLINE zuint8 *flags(Z80 *object)
+		{
+		if (LAZY.operation) resolve_flags(object);
+		return &object->state.Z_Z80_STATE_MEMBER_F;
+		}
+
+
+	Z_INLINE zuint16 *accumulator_and_flags(Z80 *object)
+		{
+		if (LAZY.operation) resolve_flags(object);
+		return &object->state.Z_Z80_STATE_MEMBER_AF;
+		}
+
+
+	Z_INLINE zuint8 lazy_carry(Z80 *object)
+		{
+		switch (LAZY.operation)
+			{
+			case LAZY_FLAGS_ADD: return LAZY.x + LAZY.y > 255;
+			case LAZY_FLAGS_ADC: return LAZY.x + LAZY.y + LAZY.carry > 255;
+			case LAZY_FLAGS_SUB:
+			case LAZY_FLAGS_CP:  return LAZY.x < LAZY.y;
+			case LAZY_FLAGS_SBC: return LAZY.x - LAZY.y - LAZY.carry < 0;
+			case LAZY_FLAGS_AND:
+			case LAZY_FLAGS_XOR:
+			case LAZY_FLAGS_OR:  return 0;
+			case LAZY_FLAGS_INC:
+			case LAZY_FLAGS_DEC: return LAZY.carry;
+			default:	     return object->state.Z_Z80_STATE_MEMBER_F & CF;
+			}
+		}
+
+#	undef  AF
+#	undef  F
+#	undef  F_C
+#	define AF  (*accumulator_and_flags(object))
+#	define F   (*flags(object))
+#	define F_C lazy_carry(object)
+
+#	define RESOLVE_FLAGS if (LAZY.operation) resolve_flags(object)
+
+#else
+#	define RESOLVE_FLAGS
+#endif
+
+
 /* MARK: - P/V Flag Computation */
 
 static zuint8 const pf_parity_table[256] = {
@@ -228,7 +418,10 @@ VF(adc, 16, 32, +, -32768, 32767)
 VF(sbc, 16, 32, -, -32768, 32767)
 
 
-/* MARK: - 8 Bit Register Resolution
+/* MARK: - 8 Bit Register Names
+
+   Handlers are generated once for each operand, so the register fields of
+   the opcodes are resolved when the tables are written, not at run time.
 
    .----------.   .---------.   .-----------.   .-----------.
    | 76543210 |   |  X / Y  |   |   J / K   |   |   P / Q   |
@@ -242,42 +435,21 @@ VF(sbc, 16, 32, -, -32768, 32767)
    '----------'   | 111 = a |   | 111 = a   |   | 111 = a   |
 		  '---------'   '-----------'   '----------*/
 
-static zuint8 const x_y_table[8] = {
-	O(state.Z_Z80_STATE_MEMBER_B),
-	O(state.Z_Z80_STATE_MEMBER_C),
-	O(state.Z_Z80_STATE_MEMBER_D),
-	O(state.Z_Z80_STATE_MEMBER_E),
-	O(state.Z_Z80_STATE_MEMBER_H),
-	O(state.Z_Z80_STATE_MEMBER_L),
-	0,
-	O(state.Z_Z80_STATE_MEMBER_A)
-};
-
-static zuint8 const j_k_p_q_table[8] = {
-	O(state.Z_Z80_STATE_MEMBER_B),
-	O(state.Z_Z80_STATE_MEMBER_C),
-	O(state.Z_Z80_STATE_MEMBER_D),
-	O(state.Z_Z80_STATE_MEMBER_E),
-	O(xy.values_uint8.index1    ),
-	O(xy.values_uint8.index0    ),
-	0,
-	O(state.Z_Z80_STATE_MEMBER_A)
-};
-
-#define R_8(name, table, offset, mask, shift) \
-Z_INLINE zuint8 *name(Z80 *object)	      \
-	{return ((zuint8 *)object) + table[(BYTE(offset) & mask) shift];}
+#define XYH object->xy.values_uint8.index1
+#define XYL object->xy.values_uint8.index0
 
-R_8(__xxx___0,	   x_y_table, 0, 56, >> 3)
-R_8(__xxx___1,	   x_y_table, 1, 56, >> 3)
-R_8(_____yyy0,	   x_y_table, 0,  7,	 )
-R_8(_____yyy1,	   x_y_table, 1,  7,	 )
-R_8(_____yyy3,	   x_y_table, 3,  7,	 )
-R_8(__jjj___ , j_k_p_q_table, 1, 56, >> 3)
-R_8(_____kkk , j_k_p_q_table, 1,  7,	 )
+#define R8_b   B
+#define R8_c   C
+#define R8_d   D
+#define R8_e   E
+#define R8_h   H
+#define R8_l   L
+#define R8_a   A
+#define R8_xyh XYH
+#define R8_xyl XYL
 
 
-/* MARK: - 16 Bit Register Resolution
+/* MARK: - 16 Bit Register Names
 
    .----------.   .---------.	.---------.   .---------.
    | 76543210 |   |    S    |	|    T    |   |    W    |
@@ -288,37 +460,15 @@ R_8(_____kkk , j_k_p_q_table, 1,  7,	 )
 		  | 11 = sp |	| 11 = af |   | 11 = sp |
 		  '---------'	'---------'   '--------*/
 
-static zuint8 const s_table[4] = {
-	O(state.Z_Z80_STATE_MEMBER_BC),
-	O(state.Z_Z80_STATE_MEMBER_DE),
-	O(state.Z_Z80_STATE_MEMBER_HL),
-	O(state.Z_Z80_STATE_MEMBER_SP)
-};
-
-static zuint8 const t_table[4] = {
-	O(state.Z_Z80_STATE_MEMBER_BC),
-	O(state.Z_Z80_STATE_MEMBER_DE),
-	O(state.Z_Z80_STATE_MEMBER_HL),
-	O(state.Z_Z80_STATE_MEMBER_AF)
-};
-
-static zuint8 const w_table[4] = {
-	O(state.Z_Z80_STATE_MEMBER_BC),
-	O(state.Z_Z80_STATE_MEMBER_DE),
-	O(xy			     ),
-	O(state.Z_Z80_STATE_MEMBER_SP)
-};
-
-#define R_16(name, table, offset)   \
-Z_INLINE zuint16 *name(Z80 *object) \
-	{return Z_BOP(zuint16 *, object, table[(BYTE(offset) & 48) >> 4]);}
+#define R16_bc BC
+#define R16_de DE
+#define R16_hl HL
+#define R16_sp SP
+#define R16_af AF
+#define R16_xy XY
 
-R_16(__ss____0, s_table, 0)
-R_16(__ss____1, s_table, 1)
-R_16(__tt____ , t_table, 0)
 
-
-/* MARK: - Condition Resolution
+/* MARK: - Condition Names
 
    .----------.   .----------.
    | 76543210 |   |     Z    |
@@ -333,19 +483,17 @@ R_16(__tt____ , t_table, 0)
 		  | 111 = m  |
 		  '---------*/
 
-static zuint8 const z_table[8] = {ZF, ZF, CF, CF, PF, PF, SF, SF};
-
-Z_INLINE zboolean __zzz___(Z80 *object)
-	{
-	zuint8 z = (BYTE0 & 56) >> 3;
-
-	return (F & (z_table[z]))
-		?  (z & 1)  /* Flag is 1 */
-		: !(z & 1); /* Flag is 0 */
-	}
+#define CONDITION_nz !F_Z
+#define CONDITION_z   F_Z
+#define CONDITION_nc !F_C
+#define CONDITION_c   F_C
+#define CONDITION_po !F_P
+#define CONDITION_pe  F_P
+#define CONDITION_p  !F_S
+#define CONDITION_m   F_S
 
 
-/* MARK: - 8 Bit Arithmetic and Logical Operation Resolution and Execution
+/* MARK: - 8 Bit Arithmetic and Logical Operation Execution
 
    .----------.   .-----------.		.-------------------------------.
    | 76543210 |   |     U     |		| S | Z | Y | H | X | P | N | C |
@@ -371,102 +519,120 @@ Z_INLINE zboolean __zzz___(Z80 *object)
 				  | dec | S | Z |v.5| H |v.3| V | 1 | . |
 				  '------------------------------------*/
 
-static void __uuu___(Z80 *object, zuint8 offset, zuint8 value)
+#define U_SYXZ						       \
+	F =	(F & (HF | PF | NF | CF)) /* CF, NF, PF and HF already changed */ \
+		| A_SYX			  /* SF = A.7; YF = A.5; XF = A.3      */ \
+		| ZF_ZERO(A);		  /* ZF = !A			       */
+
+Z_INLINE void u_add(Z80 *object, zuint8 value)
 	{
-	zuint8 t;
+	zuint8 t = A + value;
 
-	switch ((object->data.array_uint8[offset] >> 3) & 7)
-		{
-		case 0:	/* ADD */
-		t = A + value;
-
-		F =	(A + value > 255)	     /* CF = Carry	*/
-			| pf_overflow_add8(A, value) /* PF = Overflow	*/
-			| ((A ^ value ^ t) & HF);    /* HF = Half-carry */
-		A = t;				     /* NF = 0		*/
-		break;
-
-		case 1:	/* ADC */
-		t = F_C;
-
-		F =	(A + value + t > 255)			  /* CF = Carry	     */
-			| pf_overflow_adc8(A, value, t)		  /* PF = Overflow   */
-			| (((A & 0xF) + (value & 0xF) + t) & HF); /* HF = Half-carry */
-								  /* NF = 0	     */
-		A += value + t;
-		break;
-
-		case 2:	/* SUB */
-		t = A - value;
-
-		F =	(A < value)		     /* CF = Borrow	 */
-			| NF			     /* NF = 1		 */
-			| pf_overflow_sub8(A, value) /* PF = Overflow    */
-			| ((A ^ value ^ t) & HF);    /* HF = Half-Borrow */
-		A = t;
-		break;
-
-		case 3: /* SBC */
-		t = F_C;
-
-		F =	(A - value - t < 0)			  /* CF = Borrow      */
-			| NF					  /* NF = 1	      */
-			| pf_overflow_sbc8(A, value, t)		  /* PF = Overflow    */
-			| (((A & 0xF) - (value & 0xF) - t) & HF); /* HF = Half-Borrow */
-
-		A -= value + t;
-		break;
-
-		case 4: /* AND */
-		A &= value;
-		F = HF | PF_PARITY(A); /* HF = 1; PF = Parity */
-		break;		       /* NF, CF = 0	      */
-
-		case 5: /* XOR */
-		A ^= value;
-		F = PF_PARITY(A); /* PF = Parity    */
-		break;		  /* HF, NF, CF = 0 */
-
-		case 6: /* OR */
-		A |= value;
-		F = PF_PARITY(A); /* PF = Parity    */
-		break;		  /* HF, NF, CF = 0 */
-
-		case 7: /* CP */
-		t = A - value;
-
-		F =	(A < value)		     /* CF = Borrow	   */
-			| NF			     /* NF = 1		   */
-			| pf_overflow_sub8(A, value) /* PF = Overflow	   */
-			| ((A ^ value ^ t) & HF)     /* HF = Half-Borrow   */
-			| (value & YXF)		     /* YF = v.5, XF = v.3 */
-			| ZF_ZERO(t)		     /* ZF = !(A - v)	   */
-			| (t & SF);		     /* SF = (A - v).7	   */
-		return;
-		}
+	F =	(A + value > 255)	     /* CF = Carry	*/
+		| pf_overflow_add8(A, value) /* PF = Overflow	*/
+		| ((A ^ value ^ t) & HF);    /* HF = Half-carry */
+	A = t;				     /* NF = 0		*/
+	U_SYXZ
+	}
 
-	F =	(F & (HF | PF | NF | CF)) /* CF, NF, PF and HF already changed */
-		| A_SYX			  /* SF = A.7; YF = A.5; XF = A.3      */
-		| ZF_ZERO(A);		  /* ZF = !A			       */
+
+Z_INLINE void u_adc(Z80 *object, zuint8 value)
+	{
+	zuint8 t = F_C;
+
+	F =	(A + value + t > 255)			  /* CF = Carry	     */
+		| pf_overflow_adc8(A, value, t)		  /* PF = Overflow   */
+		| (((A & 0xF) + (value & 0xF) + t) & HF); /* HF = Half-carry */
+							  /* NF = 0	     */
+	A += value + t;
+	U_SYXZ
 	}
 
 
-static zuint8 _____vvv(Z80 *object, zuint8 offset, zuint8 value)
+Z_INLINE void u_sub(Z80 *object, zuint8 value)
 	{
-	zuint8 t, pn;
+	zuint8 t = A - value;
 
-	/* DEC */
-	if (object->data.array_uint8[offset] & 1)
-		{			      /* PF = Overflow */
-		pn = value == 128 ? PNF : NF; /* NF = 1	       */
-		t = value - 1;
-		}
+	F =	(A < value)		     /* CF = Borrow	 */
+		| NF			     /* NF = 1		 */
+		| pf_overflow_sub8(A, value) /* PF = Overflow    */
+		| ((A ^ value ^ t) & HF);    /* HF = Half-Borrow */
+	A = t;
+	U_SYXZ
+	}
 
-	/* INC */
-	else	{			    /* PF = Overflow */
-		pn = value == 127 ? PF : 0; /* NF = 0	     */
-		t = value + 1;
-		}
+
+Z_INLINE void u_sbc(Z80 *object, zuint8 value)
+	{
+	zuint8 t = F_C;
+
+	F =	(A - value - t < 0)			  /* CF = Borrow      */
+		| NF					  /* NF = 1	      */
+		| pf_overflow_sbc8(A, value, t)		  /* PF = Overflow    */
+		| (((A & 0xF) - (value & 0xF) - t) & HF); /* HF = Half-Borrow */
+
+	A -= value + t;
+	U_SYXZ
+	}
+
+
+Z_INLINE void u_and(Z80 *object, zuint8 value)
+	{
+	A &= value;
+	F = HF | PF_PARITY(A); /* HF = 1; PF = Parity */
+	U_SYXZ		       /* NF, CF = 0	      */
+	}
+
+
+Z_INLINE void u_xor(Z80 *object, zuint8 value)
+	{
+	A ^= value;
+	F = PF_PARITY(A); /* PF = Parity    */
+	U_SYXZ		  /* HF, NF, CF = 0 */
+	}
+
+
+Z_INLINE void u_or(Z80 *object, zuint8 value)
+	{
+	A |= value;
+	F = PF_PARITY(A); /* PF = Parity    */
+	U_SYXZ		  /* HF, NF, CF = 0 */
+	}
+
+
+Z_INLINE void u_cp(Z80 *object, zuint8 value)
+	{
+	zuint8 t = A - value;
+
+	F =	(A < value)		     /* CF = Borrow	   */
+		| NF			     /* NF = 1		   */
+		| pf_overflow_sub8(A, value) /* PF = Overflow	   */
+		| ((A ^ value ^ t) & HF)     /* HF = Half-Borrow   */
+		| (value & YXF)		     /* YF = v.5, XF = v.3 */
+		| ZF_ZERO(t)		     /* ZF = !(A - v)	   */
+		| (t & SF);		     /* SF = (A - v).7	   */
+	}
+
+
+Z_INLINE zuint8 v_inc(Z80 *object, zuint8 value)
+	{
+	zuint8 t = value + 1;
+	zuint8 pn = value == 127 ? PF : 0; /* PF = Overflow; NF = 0 */
+
+	F =	(F & CF)		 /* CF unchanged		 */
+		| pn			 /* PF and NF already calculated */
+		| (t & SYXF)		 /* SF = v.7; YF = v.5; XF = v.3 */
+		| ((value ^ 1 ^ t) & HF) /* HF = Half-Borrow		 */
+		| ZF_ZERO(t);		 /* ZF = !v			 */
+
+	return t;
+	}
+
+
+Z_INLINE zuint8 v_dec(Z80 *object, zuint8 value)
+	{
+	zuint8 t = value - 1;
+	zuint8 pn = value == 128 ? PNF : NF; /* PF = Overflow; NF = 1 */
 
 	F =	(F & CF)		 /* CF unchanged		 */
 		| pn			 /* PF and NF already calculated */
@@ -478,7 +644,7 @@ static zuint8 _____vvv(Z80 *object, zuint8 offset, zuint8 value)
 	}
 
 
-/* MARK: - Rotation and Shift Operation Resolution and Execution
+/* MARK: - Rotation and Shift Operation Execution
 
    .----------.   .-----------.
    | 76543210 |   |     G     |
@@ -493,268 +659,552 @@ static zuint8 _____vvv(Z80 *object, zuint8 offset, zuint8 value)
 		  | 111 = srl |
 		  '----------*/
 
-static zuint8 __ggg___(Z80 *object, zuint8 offset, zuint8 value)
+#define G_SYXZP(c)	   \
+	F =	(value & SYXF)	   \
+		| ZF_ZERO(value)   \
+		| PF_PARITY(value) \
+		| (c);		   \
+				   \
+	return value;
+
+/* RLC		 .----------------.
+	.----.   |  .---------.   |
+	| CF |<-----| 7 <-- 0 |<--'
+	'----'	    '--------*/
+Z_INLINE zuint8 g_rlc(Z80 *object, zuint8 value)
 	{
-	zuint8 c;
+	ROL(value);
+G_SYXZP(value & CF)
+	}
 
-	switch ((object->data.array_uint8[offset] >> 3) & 7)
-		{
-		/* RLC		 .----------------.
-			.----.   |  .---------.   |
-			| CF |<-----| 7 <-- 0 |<--'
-			'----'	    '--------*/
-		case 0:
-		ROL(value);
-		c = value & CF;
-		break;
-
-		/* RRC	.----------------.
-			|   .---------.  |   .----.
-			'-->| 7 --> 0 |----->| CF |
-			    '---------'      '---*/
-		case 1:
-		c = value & CF;
-		ROR(value);
-		break;
-
-		/* RL	.-------------------------.
-			|  .----.   .---------.   |
-			'--| CF |<--| 7 <-- 0 |<--'
-			   '----'   '--------*/
-		case 2:
-		c = value >> 7;
-		value = (value << 1) | F_C;
-		break;
-
-		/* RR	.-------------------------.
-			|   .---------.   .----.  |
-			'-->| 7 --> 0 |-->| CF |--'
-			    '---------'   '---*/
-		case 3:
-		c = value & CF;
-		value = (value >> 1) | (F_C << 7);
-		break;
-
-		/* SLA	.----.	 .---------.
-			| CF |<--| 7 <-- 0 |<-- 0
-			'----'	 '--------*/
-		case 4:
-		c = value >> 7;
-		value <<= 1;
-		break;
-
-		/* SRA	    .---------.   .----.
-			.-->| 7 --> 0 |-->| CF |
-			|   '---------'   '----'
-			|     |
-			'----*/
-		case 5:
-		c = value & CF;
-		value = (value & 128) | (value >> 1);
-		break;
-
-		/* SLL	.----.	 .---------.
-			| CF |<--| 7 <-- 0 |<-- 1
-			'----'	 '--------*/
-		case 6:
-		c = value >> 7;
-		value = (value << 1) & 1;
-		break;
-
-		/* SRL	     .---------.   .----.
-			0 -->| 7 --> 0 |-->| CF |
-			     '---------'   '---*/
-		case 7:
-		c = value & CF;
-		value >>= 1;
-		break;
-
-		/* Uncoment to Avoid a compiler warning */
-		/*default: c = 0; break;*/
-		}
 
-	F =	(value & SYXF)
-		| ZF_ZERO(value)
-		| PF_PARITY(value)
-		| c;
+/* RRC	.----------------.
+	|   .---------.  |   .----.
+	'-->| 7 --> 0 |----->| CF |
+	    '---------'      '---*/
+Z_INLINE zuint8 g_rrc(Z80 *object, zuint8 value)
+	{
+	zuint8 c = value & CF;
 
-	return value;
+	ROR(value);
+G_SYXZP(c)
 	}
 
 
-/* MARK: - Bit Set and Reset Operation Resolution and Execution
-
-   .----------.   .---------.
-   | 76543210 |   |    M    |
-   |----------|   |---------|
-   | _m______ |   | 0 = res |
-   '----------'   | 1 = set |
-		  '--------*/
-
-Z_INLINE zuint8 _m______(Z80 *object, zuint8 offset, zuint8 value)
+/* RL	.-------------------------.
+	|  .----.   .---------.   |
+	'--| CF |<--| 7 <-- 0 |<--'
+	   '----'   '--------*/
+Z_INLINE zuint8 g_rl(Z80 *object, zuint8 value)
 	{
-	zuint8 t = object->data.array_uint8[offset];
+	zuint8 c = value >> 7;
 
-	return (t & 64)
-		? value |  (1 << ((t & 56) >> 3))  /* SET */
-		: value & ~(1 << ((t & 56) >> 3)); /* RES */
+	value = (value << 1) | F_C;
+G_SYXZP(c)
 	}
 
 
-/* MARK: - Macros: Shortening */
+/* RR	.-------------------------.
+	|   .---------.   .----.  |
+	'-->| 7 --> 0 |-->| CF |--'
+	    '---------'   '---*/
+Z_INLINE zuint8 g_rr(Z80 *object, zuint8 value)
+	{
+	zuint8 c = value & CF;
 
-#define N(x)	  ((BYTE##x & 56) >> 3)
-#define X0	  (*__xxx___0(object))
-#define X1	  (*__xxx___1(object))
-#define Y0	  (*_____yyy0(object))
-#define Y1	  (*_____yyy1(object))
-#define Y3	  (*_____yyy3(object))
-#define JP	  (*__jjj___ (object))
-#define KQ	  (*_____kkk (object))
-#define SS0	  (*__ss____0(object))
-#define SS1	  (*__ss____1(object))
-#define TT	  (*__tt____ (object))
-#define Z	    __zzz___ (object)
-#define U0(value)   __uuu___ (object, 0, value)
-#define U1(value)   __uuu___ (object, 1, value)
-#define V0(value)   _____vvv (object, 0, value)
-#define V1(value)   _____vvv (object, 1, value)
-#define G1(value)   __ggg___ (object, 1, value)
-#define G3(value)   __ggg___ (object, 3, value)
-#define M1(value)   _m______ (object, 1, value)
-#define M3(value)   _m______ (object, 3, value)
-#define WW	  (*Z_BOP(zuint16 *, object, w_table[(BYTE1 >> 4) & 3]))
+	value = (value >> 1) | (F_C << 7);
+G_SYXZP(c)
+	}
 
 
-/* MARK: - Macros & Functions: Reusable Code */
+/* SLA	.----.	 .---------.
+	| CF |<--| 7 <-- 0 |<-- 0
+	'----'	 '--------*/
+Z_INLINE zuint8 g_sla(Z80 *object, zuint8 value)
+	{
+	zuint8 c = value >> 7;
 
-#define INSTRUCTION(name) static zuint8 name(Z80 *object)
-#define EXIT_HALT	  if (HALT) {PC++; HALT = FALSE; CLEAR_HALT;}
-#define PUSH(value)	  WRITE_16(SP -= 2, value)
+	value <<= 1;
+G_SYXZP(c)
+	}
 
 
-#define LD_A_I_LD_A_R	      /* HF = 0 / NF = 0	      */ \
-	F =	A_SYX	      /* SF = A.7; YF = A.5; XF = A.3 */ \
-		| ZF_ZERO(A)  /* ZF = !A		      */ \
-		| (IFF2 << 2) /* PF = IFF2		      */ \
-		| F_C;	      /* CF unchanged		      */
+/* SRA	    .---------.   .----.
+	.-->| 7 --> 0 |-->| CF |
+	|   '---------'   '----'
+	|     |
+	'----*/
+Z_INLINE zuint8 g_sra(Z80 *object, zuint8 value)
+	{
+	zuint8 c = value & CF;
 
+	value = (value & 128) | (value >> 1);
+G_SYXZP(c)
+	}
 
-#define EX(a, b) t = a; a = b; b = t;
 
+/* SLL	.----.	 .---------.
+	| CF |<--| 7 <-- 0 |<-- 1
+	'----'	 '--------*/
+Z_INLINE zuint8 g_sll(Z80 *object, zuint8 value)
+	{
+	zuint8 c = value >> 7;
 
-#define EX_VSP_X(register)	   \
-	zuint16 tmp = READ_16(SP); \
-	WRITE_16(SP, register);	   \
-	register = tmp;
+	value = (value << 1) & 1;
+G_SYXZP(c)
+	}
 
 
-#define LDX(sign)							  \
-	zuint8 n = READ_8(HL sign);					  \
-	WRITE_8(DE sign, n);						  \
-	n += A;								  \
-				     /* HF = 0, NF = 0		       */ \
-	F =	(F & (SF | ZF | CF)) /* SF, ZF, CF unchanged	       */ \
-		| ((n & 2) << 4)     /* YF = ([HL] + A).1	       */ \
-		| (n & XF)	     /* XF = ([HL] + A).3	       */ \
-		| (!!(--BC) << 2);   /* PF = 1 if BC != 0, else PF = 0 */
+/* SRL	     .---------.   .----.
+	0 -->| 7 --> 0 |-->| CF |
+	     '---------'   '---*/
+Z_INLINE zuint8 g_srl(Z80 *object, zuint8 value)
+	{
+	zuint8 c = value & CF;
 
+	value >>= 1;
+G_SYXZP(c)
+	}
 
-#define LDXR(sign)	    \
-	LDX(sign)	    \
-	if (!BC) return 16; \
-	PC -= 2;	    \
-	return 21;
 
+/* MARK: - Bit Set and Reset Operation Execution
 
-#define CPX(sign)						   \
-	zuint8 v = READ_8(HL sign);				   \
-	zuint8 n0 = A - v;					   \
-	zuint8 n1 = n0 - !!F_H;					   \
-								   \
-	F =	(n0 & SF)	      /* SF = (A - [HL]).7	*/ \
-		| ZF_ZERO(n0)	      /* ZF = !(A - [HL])	*/ \
-		| ((A ^ v ^ n0) & HF) /* HF = borrow from bit 5 */ \
-		| ((n1 & 2) << 4)     /* YF = (A - [HL] - HF).1 */ \
-		| (n1 & XF)	      /* XF = (A - [HL] - HF).3 */ \
-		| (!!(--BC) << 2)     /* PF = !!BC		*/ \
-		| NF		      /* NF = 1			*/ \
-		| F_C;		      /* CF unchanged		*/
+   .----------.   .---------.
+   | 76543210 |   |    M    |
+   |----------|   |---------|
+   | _m______ |   | 0 = res |
+   '----------'   | 1 = set |
+		  '--------*/
 
+#define m_res(n, value) ((value) & ~(1 << (n)))
+#define m_set(n, value) ((value) |  (1 << (n)))
 
-#define CPXR(sign)		   \
-	CPX(sign)		   \
-	if (!BC || !n0) return 16; \
-	PC -= 2;		   \
-	return 21;
 
+/* MARK: - Deferred Flag Computation */
 
-Z_INLINE void add_RR_NN(Z80 *object, zuint16 *r, zuint16 v)
-	{
-	zuint16 t = *r + v;
+#if DEFINED(USE_LAZY_FLAGS)
 
-	F =	F_SZP			     /* SF, ZF, PF unchanged   */
-		| ((t >> 8) & YXF)	     /* YF = RR.13; XF = RR.11 */
-		| (((*r ^ v ^ t) >> 8) & HF) /* HF = RRh half-carry    */
-		| (*r + v > 65535);	     /* CF = Carry	       */
-	*r = t;				     /* NF = 0		       */
-	}
+	/*-----------------------------------------------------------------.
+	| The flags are produced by the same functions the eager core      |
+	| uses, replaying the recorded operation on its original operands. |
+	'-----------------------------------------------------------------*/
+	Z_PRIVATE void resolve_flags(Z80 *object)
+		{
+		zuint8 operation = LAZY.operation, a = A;
 
+		LAZY.operation = LAZY_FLAGS_NONE;
+		F = LAZY.carry;
+		A = LAZY.x;
 
-#define ADD_RR_NN(register, value) \
-	add_RR_NN(object, (zuint16 *)&register, value);
+		switch (operation)
+			{
+			case LAZY_FLAGS_ADD: u_add(object, LAZY.y); break;
+			case LAZY_FLAGS_ADC: u_adc(object, LAZY.y); break;
+			case LAZY_FLAGS_SUB: u_sub(object, LAZY.y); break;
+			case LAZY_FLAGS_SBC: u_sbc(object, LAZY.y); break;
+			case LAZY_FLAGS_AND: u_and(object, LAZY.y); break;
+			case LAZY_FLAGS_XOR: u_xor(object, LAZY.y); break;
+			case LAZY_FLAGS_OR:  u_or (object, LAZY.y); break;
+			case LAZY_FLAGS_CP:  u_cp (object, LAZY.y); break;
+			case LAZY_FLAGS_INC: v_inc(object, LAZY.x); break;
+			case LAZY_FLAGS_DEC: v_dec(object, LAZY.x); break;
+			}
 
+		A = a;
+		}
 
-#define ADC_SBC_HL_SS(function, sign, cf_test, set_nf)								\
-	zuint8 c = F_C;												\
-	zuint16 v = SS1, t = HL sign v sign c;									\
-														\
-	F =	((t >> 8) & SYXF)				       /* SF = HL.15; YF = HL.13; XF = HL.11 */	\
-		| ZF_ZERO(t)					       /* ZF = !HL			     */	\
-		| ((((HL & 0xFFF) sign (v & 0xFFF) sign c) >> 8) & HF) /* HF = Half-carry of H		     */	\
-		| pf_overflow_##function##16(HL, v, c)		       /* PF = Overflow			     */	\
-		| (cf_test)					       /* CF = Carry			     */	\
-		set_nf;						       /* ADC: NF = 0; SBC: NF = 1	     */	\
-														\
-	HL = t;													\
-	return 15;
 
+#	define DEFER_FLAGS(name, x_, y_, carry_)          \
+		LAZY.operation = LAZY_FLAGS_##name;       \
+		LAZY.x	       = x_;			  \
+		LAZY.y	       = y_;			  \
+		LAZY.carry     = carry_;
 
-#define RXA						  \
-	F =	F_SZP  /* SF, ZF, PF unchanged	       */ \
-		| A_YX /* YF = A.5; XF = A.3	       */ \
-		| c;   /* CF = pA.7 (rla) / pA.0 (rra) */
+	Z_INLINE void lazy_add(Z80 *object, zuint8 value) {DEFER_FLAGS(ADD, A, value, 0) A += value;}
+	Z_INLINE void lazy_sub(Z80 *object, zuint8 value) {DEFER_FLAGS(SUB, A, value, 0) A -= value;}
+	Z_INLINE void lazy_and(Z80 *object, zuint8 value) {DEFER_FLAGS(AND, A, value, 0) A &= value;}
+	Z_INLINE void lazy_xor(Z80 *object, zuint8 value) {DEFER_FLAGS(XOR, A, value, 0) A ^= value;}
+	Z_INLINE void lazy_or (Z80 *object, zuint8 value) {DEFER_FLAGS(OR,  A, value, 0) A |= value;}
+	Z_INLINE void lazy_cp (Z80 *object, zuint8 value) {DEFER_FLAGS(CP,  A, value, 0)}
 
 
-#define RXD(a, b, c)						  \
-	zuint8 t = READ_8(HL);					  \
-								  \
-	WRITE_8(HL, (t a 4) | (A b));				  \
-	A = (A & 0xF0) | (t c);					  \
-								  \
-	F =	A_SYX	       /* SF = A.7; YF = A.5; XF = A.3 */ \
-		| ZF_ZERO(A)   /* ZF = !A		       */ \
-		| PF_PARITY(A) /* PF = Parity of A	       */ \
-		| F_C;	       /* CF unchanged		       */ \
-			       /* HF = 0, NF = 0;	       */
+	Z_INLINE void lazy_adc(Z80 *object, zuint8 value)
+		{
+		zuint8 c = F_C;
 
+		DEFER_FLAGS(ADC, A, value, c)
+		A += value + c;
+		}
 
-#define BIT_N_VALUE(value)						   \
-	zuint8 n = value & (1 << N(1));	/* SF = value.N && N == 7	*/ \
-					/* ZF, PF = !value.N		*/ \
-	F =	(n ? n & SYXF : ZPF)	/* YF = value.N && N == 5	*/ \
-		| HF			/* HF = 1; NF = 0; CF unchanged	*/ \
-		| F_C;			/* XF = value.N && N == 3	*/
 
+	Z_INLINE void lazy_sbc(Z80 *object, zuint8 value)
+		{
+		zuint8 c = F_C;
 
-#define BIT_N_VADDRESS(address)					   \
-	Z16Bit a;						   \
-	zuint8 n = READ_8(a.value_uint16 = address) & (1 << N(3)); \
-								   \
-	F =	(n ? (n & SF) : ZPF)				   \
-		| (a.values_uint8.index1 & YXF)			   \
-		| HF						   \
-		| F_C;
+		DEFER_FLAGS(SBC, A, value, c)
+		A -= value + c;
+		}
+
+
+	Z_INLINE zuint8 lazy_inc(Z80 *object, zuint8 value)
+		{
+		zuint8 c = F_C;
+
+		DEFER_FLAGS(INC, value, 0, c)
+		return value + 1;
+		}
+
+
+	Z_INLINE zuint8 lazy_dec(Z80 *object, zuint8 value)
+		{
+		zuint8 c = F_C;
+
+		DEFER_FLAGS(DEC, value, 0, c)
+		return value - 1;
+		}
+
+#endif
+
+
+/* MARK: - Macros: Shortening */
+
+#define R8(name)	  R8_##name
+#define R16(name)	  R16_##name
+#define Z(name)		  CONDITION_##name
+
+#if DEFINED(USE_LAZY_FLAGS)
+#	define U(name, value) lazy_##name(object, value)
+#	define V(name, value) lazy_##name(object, value)
+#else
+#	define U(name, value) u_##name(object, value)
+#	define V(name, value) v_##name(object, value)
+#endif
+
+#define G(name, value)	  g_##name(object, value)
+#define M(name, n, value) m_##name(n, value)
+
+
+/* MARK: - Macros: Handler Generation
+
+   The handlers of each instruction group are written once as a template
+   macro, which is then instantiated for every operand of the opcodes the
+   template covers. EACH_Y and EACH_KQ expand a template for every register
+   operand of a row of the opcode tables. */
+
+#define EACH_Y(template, ...)				  \
+	template(__VA_ARGS__, b) template(__VA_ARGS__, c) \
+	template(__VA_ARGS__, d) template(__VA_ARGS__, e) \
+	template(__VA_ARGS__, h) template(__VA_ARGS__, l) \
+	template(__VA_ARGS__, a)
+
+#define EACH_KQ(template, ...)				      \
+	template(__VA_ARGS__, b	 ) template(__VA_ARGS__, c  ) \
+	template(__VA_ARGS__, d	 ) template(__VA_ARGS__, e  ) \
+	template(__VA_ARGS__, xyh) template(__VA_ARGS__, xyl) \
+	template(__VA_ARGS__, a	 )
+
+
+/* MARK: - Bulk Execution of Block Instructions
+.----------------------------------------------------------------------------.
+| Repeating block instructions can run several iterations per call. An      |
+| iteration is only run ahead when the interpreter would have run it too:   |
+| the counter does not reach zero, the iteration starts before the budget   |
+| is consumed and no interrupt is pending. Transfers and searches in pages  |
+| the machine maps with direct pointers are done with memcpy/memchr, all    |
+| but the last iteration, which still goes through the callbacks and sets   |
+| the final flags. I/O transfers keep calling the port callbacks, but loop  |
+| inside the handler with CYCLES and R as they would be at each call.       |
+'----------------------------------------------------------------------------*/
+
+#if DEFINED(USE_BULK_TRANSFERS)
+
+#	include <string.h>
+
+#	define PAGE_OFFSET(address) ((zsize)(address) & 16383)
+#	define MINIMUM(a, b)	    ((a) < (b) ? (a) : (b))
+
+
+	Z_INLINE zsize bulk_count(Z80 *object, zsize counter)
+		{
+		zsize cycles = CYCLES + object->prefix_cycles;
+
+		if (NMI || (INT && IFF1) || cycles + 21 >= object->cycle_limit) return 0;
+		return MINIMUM(counter - 1, (object->cycle_limit - cycles - 1) / 21);
+		}
+
+
+	/*--------------------------------------------------------------.
+	| The cycles of a DD/FD prefix in front of the instruction are  |
+	| still pending (see XY_illegal) and belong to the iteration it |
+	| started with, which is the first one run ahead.               |
+	'--------------------------------------------------------------*/
+	Z_INLINE void bulk_advance(Z80 *object, zsize count)
+		{
+		R      += (zuint8)(count * 2);
+		CYCLES += count * 21 + object->prefix_cycles;
+		object->prefix_cycles = 0;
+		}
+
+
+	/*-------------------------------------------------------------.
+	| I/O transfers write memory through the callbacks, so they can |
+	| overwrite the instruction: it is fetched again, as it would.  |
+	'-------------------------------------------------------------*/
+	Z_INLINE zboolean bulk_next_iteration(Z80 *object)
+		{
+		if (	NMI || (INT && IFF1)						||
+			CYCLES + object->prefix_cycles + 21 >= object->cycle_limit	||
+			READ_8(PC - 2) != 0xED						||
+			READ_8(PC - 1) != BYTE1
+		)
+			return FALSE;
+
+		bulk_advance(object, 1);
+		return TRUE;
+		}
+
+
+	Z_PRIVATE void ldxr_bulk(Z80 *object)
+		{
+		zsize count = bulk_count(object, BC ? BC : 65536), index;
+		zuint8 *source = object->read_pages[HL >> 14], *target = object->write_pages[DE >> 14];
+
+		if (!count || source == NULL || target == NULL) return;
+
+		/*--------------------------------------------------------------.
+		| The copy stays inside the source and target pages, and stops  |
+		| before the instruction is overwritten, as every iteration     |
+		| fetches it again. Overlapping ranges are copied byte by byte, |
+		| in the order of the instruction, to replicate patterns.       |
+		'--------------------------------------------------------------*/
+		if (BYTE1 & 8)
+			{
+			count = MINIMUM(count, MINIMUM(PAGE_OFFSET(HL), PAGE_OFFSET(DE)) + 1);
+			count = MINIMUM(count, MINIMUM((zuint16)(DE - PC + 2), (zuint16)(DE - PC + 1)));
+			if (!count) return;
+			source += PAGE_OFFSET(HL) + 1 - count;
+			target += PAGE_OFFSET(DE) + 1 - count;
+			HL     -= (zuint16)count;
+			DE     -= (zuint16)count;
+
+			if (target < source + count && source < target + count)
+				{for (index = count; index;) {index--; target[index] = source[index];}}
+
+			else memcpy(target, source, count);
+			}
+
+		else	{
+			count = MINIMUM(count, MINIMUM(16384 - PAGE_OFFSET(HL), 16384 - PAGE_OFFSET(DE)));
+			count = MINIMUM(count, MINIMUM((zuint16)(PC - 2 - DE), (zuint16)(PC - 1 - DE)));
+			if (!count) return;
+			source += PAGE_OFFSET(HL);
+			target += PAGE_OFFSET(DE);
+			HL     += (zuint16)count;
+			DE     += (zuint16)count;
+
+			if (target < source + count && source < target + count)
+				{for (index = 0; index < count; index++) target[index] = source[index];}
+
+			else memcpy(target, source, count);
+			}
+
+#		if DEFINED(USE_BLOCK_CACHE)
+			if (object->block_cache != NULL)
+				{
+				zuint16 address = BYTE1 & 8 ? DE + 1 : DE - (zuint16)count;
+				zuint16 bank = object->bank[address >> 14];
+				zsize page = PAGE_INDEX(bank, address), last = PAGE_INDEX(bank, address + count - 1);
+
+				while (page <= last) object->block_cache->generations[page++]++;
+				}
+#		endif
+
+		BC -= (zuint16)count;
+		bulk_advance(object, count);
+		}
+
+
+	/*-----------------------------------------------------------------.
+	| Each comparison takes HF from the previous one, so the flags of  |
+	| the last iteration run in bulk are left for the final iteration. |
+	'-----------------------------------------------------------------*/
+	Z_PRIVATE void cpxr_bulk(Z80 *object)
+		{
+		zsize count = bulk_count(object, BC ? BC : 65536), index;
+		zuint8 const *source = object->read_pages[HL >> 14], *match;
+		zuint8 v;
+
+		if (!count || source == NULL) return;
+		source += PAGE_OFFSET(HL);
+
+		if (BYTE1 & 8)
+			{
+			count = MINIMUM(count, PAGE_OFFSET(HL) + 1);
+			for (index = 0; index < count && *(source - index) != A; index++);
+			if (!index) return;
+			v = *(source - (index - 1));
+			HL -= (zuint16)index;
+			}
+
+		else	{
+			count = MINIMUM(count, 16384 - PAGE_OFFSET(HL));
+			index = (match = memchr(source, A, count)) == NULL ? count : (zsize)(match - source);
+			if (!index) return;
+			v = source[index - 1];
+			HL += (zuint16)index;
+			}
+
+		F = (F & ~HF) | ((A ^ v ^ (zuint8)(A - v)) & HF);
+		BC -= (zuint16)index;
+		bulk_advance(object, index);
+		}
+
+
+#	define LDXR_BULK	 ldxr_bulk(object);
+#	define CPXR_BULK	 cpxr_bulk(object);
+#	define IOXR_LOOP(body)	 for (;;) {body if (!B) return 16; if (!bulk_next_iteration(object)) break;}
+
+#	undef PAGE_OFFSET
+#	undef MINIMUM
+
+#else
+#	define LDXR_BULK
+#	define CPXR_BULK
+#	define IOXR_LOOP(body) body if (!B) return 16;
+#endif
+
+
+/* MARK: - Macros & Functions: Reusable Code */
+
+#define INSTRUCTION(name) static zuint8 name(Z80 *object)
+#define EXIT_HALT	  if (HALT) {PC++; HALT = FALSE; CLEAR_HALT;}
+#define PUSH(value)	  WRITE_16(SP -= 2, value)
+
+
+#define LD_A_I_LD_A_R	      /* HF = 0 / NF = 0	      */ \
+	F =	A_SYX	      /* SF = A.7; YF = A.5; XF = A.3 */ \
+		| ZF_ZERO(A)  /* ZF = !A		      */ \
+		| (IFF2 << 2) /* PF = IFF2		      */ \
+		| F_C;	      /* CF unchanged		      */
+
+
+#define EX(a, b) t = a; a = b; b = t;
+
+
+#define EX_VSP_X(register)	   \
+	zuint16 tmp = READ_16(SP); \
+	WRITE_16(SP, register);	   \
+	register = tmp;
+
+
+#define LDX(sign)							  \
+	zuint8 n = READ_8(HL sign);					  \
+	WRITE_8(DE sign, n);						  \
+	n += A;								  \
+				     /* HF = 0, NF = 0		       */ \
+	F =	(F & (SF | ZF | CF)) /* SF, ZF, CF unchanged	       */ \
+		| ((n & 2) << 4)     /* YF = ([HL] + A).1	       */ \
+		| (n & XF)	     /* XF = ([HL] + A).3	       */ \
+		| (!!(--BC) << 2);   /* PF = 1 if BC != 0, else PF = 0 */
+
+
+#define LDXR(sign)	    \
+	LDXR_BULK	    \
+	LDX(sign)	    \
+	if (!BC) return 16; \
+	PC -= 2;	    \
+	return 21;
+
+
+#define CPX(sign)						   \
+	zuint8 v = READ_8(HL sign);				   \
+	zuint8 n0 = A - v;					   \
+	zuint8 n1 = n0 - !!F_H;					   \
+								   \
+	F =	(n0 & SF)	      /* SF = (A - [HL]).7	*/ \
+		| ZF_ZERO(n0)	      /* ZF = !(A - [HL])	*/ \
+		| ((A ^ v ^ n0) & HF) /* HF = borrow from bit 5 */ \
+		| ((n1 & 2) << 4)     /* YF = (A - [HL] - HF).1 */ \
+		| (n1 & XF)	      /* XF = (A - [HL] - HF).3 */ \
+		| (!!(--BC) << 2)     /* PF = !!BC		*/ \
+		| NF		      /* NF = 1			*/ \
+		| F_C;		      /* CF unchanged		*/
+
+
+#define CPXR(sign)		   \
+	CPXR_BULK		   \
+	CPX(sign)		   \
+	if (!BC || !n0) return 16; \
+	PC -= 2;		   \
+	return 21;
+
+
+Z_INLINE void add_RR_NN(Z80 *object, zuint16 *r, zuint16 v)
+	{
+	zuint16 t = *r + v;
+
+	F =	F_SZP			     /* SF, ZF, PF unchanged   */
+		| ((t >> 8) & YXF)	     /* YF = RR.13; XF = RR.11 */
+		| (((*r ^ v ^ t) >> 8) & HF) /* HF = RRh half-carry    */
+		| (*r + v > 65535);	     /* CF = Carry	       */
+	*r = t;				     /* NF = 0		       */
+	}
+
+
+#define ADD_RR_NN(register, value) \
+	add_RR_NN(object, (zuint16 *)&register, value);
+
+
+#define ADC_SBC_HL_SS(value, function, sign, cf_test, set_nf)							\
+	zuint8 c = F_C;												\
+	zuint16 v = value, t = HL sign v sign c;								\
+														\
+	F =	((t >> 8) & SYXF)				       /* SF = HL.15; YF = HL.13; XF = HL.11 */	\
+		| ZF_ZERO(t)					       /* ZF = !HL			     */	\
+		| ((((HL & 0xFFF) sign (v & 0xFFF) sign c) >> 8) & HF) /* HF = Half-carry of H		     */	\
+		| pf_overflow_##function##16(HL, v, c)		       /* PF = Overflow			     */	\
+		| (cf_test)					       /* CF = Carry			     */	\
+		set_nf;						       /* ADC: NF = 0; SBC: NF = 1	     */	\
+														\
+	HL = t;													\
+	return 15;
+
+
+#define RXA						  \
+	F =	F_SZP  /* SF, ZF, PF unchanged	       */ \
+		| A_YX /* YF = A.5; XF = A.3	       */ \
+		| c;   /* CF = pA.7 (rla) / pA.0 (rra) */
+
+
+#define RXD(a, b, c)						  \
+	zuint8 t = READ_8(HL);					  \
+								  \
+	WRITE_8(HL, (t a 4) | (A b));				  \
+	A = (A & 0xF0) | (t c);					  \
+								  \
+	F =	A_SYX	       /* SF = A.7; YF = A.5; XF = A.3 */ \
+		| ZF_ZERO(A)   /* ZF = !A		       */ \
+		| PF_PARITY(A) /* PF = Parity of A	       */ \
+		| F_C;	       /* CF unchanged		       */ \
+			       /* HF = 0, NF = 0;	       */
+
+
+#define BIT_N_VALUE(bit, value)					   \
+	zuint8 n = value & (1 << bit);	/* SF = value.N && N == 7	*/ \
+					/* ZF, PF = !value.N		*/ \
+	F =	(n ? n & SYXF : ZPF)	/* YF = value.N && N == 5	*/ \
+		| HF			/* HF = 1; NF = 0; CF unchanged	*/ \
+		| F_C;			/* XF = value.N && N == 3	*/
+
+
+#define BIT_N_VADDRESS(bit, address)				   \
+	Z16Bit a;						   \
+	zuint8 n = READ_8(a.value_uint16 = address) & (1 << bit);  \
+								   \
+	F =	(n ? (n & SF) : ZPF)				   \
+		| (a.values_uint8.index1 & YXF)			   \
+		| HF						   \
+		| F_C;
 
 
 #define IN_VC		       \
@@ -782,7 +1232,7 @@ Z_INLINE void add_RR_NN(Z80 *object, zuint16 *r, zuint16 v)
 	if (t > 255) F |= HCF;
 
 
-#define INXR(sign) INX(sign); if (!B) return 16; PC -= 2; return 21;
+#define INXR(sign) IOXR_LOOP(INX(sign);) PC -= 2; return 21;
 
 
 #define OUTX(sign)										    \
@@ -801,7 +1251,7 @@ Z_INLINE void add_RR_NN(Z80 *object, zuint16 *r, zuint16 v)
 					       /* if (L + (HL) > 255) CF = 1; else CF = 0	 */
 
 
-#define OTXR(sign) OUTX(sign); if (!B) return 16; PC -= 2; return 21;
+#define OTXR(sign) IOXR_LOOP(OUTX(sign);) PC -= 2; return 21;
 #define RET PC = READ_16(SP); SP += 2;
 
 
@@ -837,14 +1287,32 @@ Z_INLINE void add_RR_NN(Z80 *object, zuint16 *r, zuint16 v)
 |  ld r,a		<  ED  ><  4F  >		  ........  2 / 9   |
 '--------------------------------------------------------------------------*/
 
-INSTRUCTION(ld_X_Y)	       {PC++; X0 = Y0;						    return  4;}
-INSTRUCTION(ld_JP_KQ)	       {PC += 2; JP = KQ;					    return  8;}
-INSTRUCTION(ld_X_BYTE)	       {X0 = READ_8((PC += 2) - 1);				    return  7;}
-INSTRUCTION(ld_JP_BYTE)	       {JP = READ_8((PC += 3) - 1);				    return 11;}
-INSTRUCTION(ld_X_vhl)	       {PC++; X0 = READ_8(HL);					    return  7;}
-INSTRUCTION(ld_X_vXYOFFSET)    {X1 = READ_8(XY + READ_OFFSET((PC += 3) - 1));		    return 19;}
-INSTRUCTION(ld_vhl_Y)	       {PC++; WRITE_8(HL, Y0);					    return  7;}
-INSTRUCTION(ld_vXYOFFSET_Y)    {WRITE_8(XY + READ_OFFSET((PC += 3) - 1), Y1);		    return 19;}
+#define LD_X_Y(x, y)		INSTRUCTION(ld_##x##_##y)	{PC++; R8(x) = R8(y);					return  4;}
+#define LD_JP_KQ(j, k)		INSTRUCTION(ld_##j##_##k)	{PC += 2; R8(j) = R8(k);				return  8;}
+#define LD_X_BYTE(x)		INSTRUCTION(ld_##x##_BYTE)	{R8(x) = READ_8((PC += 2) - 1);				return  7;}
+#define LD_JP_BYTE(j)		INSTRUCTION(ld_##j##_BYTE)	{R8(j) = READ_8((PC += 3) - 1);				return 11;}
+#define LD_X_VHL(x)		INSTRUCTION(ld_##x##_vhl)	{PC++; R8(x) = READ_8(HL);				return  7;}
+#define LD_X_VXYOFFSET(x)	INSTRUCTION(ld_##x##_vXYOFFSET)	{R8(x) = READ_8(XY + READ_OFFSET((PC += 3) - 1));	return 19;}
+#define LD_VHL_Y(y)		INSTRUCTION(ld_vhl_##y)		{PC++; WRITE_8(HL, R8(y));				return  7;}
+#define LD_VXYOFFSET_Y(y)	INSTRUCTION(ld_vXYOFFSET_##y)	{WRITE_8(XY + READ_OFFSET((PC += 3) - 1), R8(y));	return 19;}
+
+EACH_Y(LD_X_Y, b) EACH_Y(LD_X_Y, c) EACH_Y(LD_X_Y, d) EACH_Y(LD_X_Y, e)
+EACH_Y(LD_X_Y, h) EACH_Y(LD_X_Y, l) EACH_Y(LD_X_Y, a)
+
+LD_JP_KQ(b, xyh) LD_JP_KQ(c, xyh) LD_JP_KQ(d, xyh) LD_JP_KQ(e, xyh) LD_JP_KQ(a, xyh)
+LD_JP_KQ(b, xyl) LD_JP_KQ(c, xyl) LD_JP_KQ(d, xyl) LD_JP_KQ(e, xyl) LD_JP_KQ(a, xyl)
+EACH_KQ(LD_JP_KQ, xyh) EACH_KQ(LD_JP_KQ, xyl)
+
+LD_X_BYTE(b) LD_X_BYTE(c) LD_X_BYTE(d) LD_X_BYTE(e) LD_X_BYTE(h) LD_X_BYTE(l) LD_X_BYTE(a)
+LD_X_VHL(b) LD_X_VHL(c) LD_X_VHL(d) LD_X_VHL(e) LD_X_VHL(h) LD_X_VHL(l) LD_X_VHL(a)
+LD_VHL_Y(b) LD_VHL_Y(c) LD_VHL_Y(d) LD_VHL_Y(e) LD_VHL_Y(h) LD_VHL_Y(l) LD_VHL_Y(a)
+LD_JP_BYTE(xyh) LD_JP_BYTE(xyl)
+
+LD_X_VXYOFFSET(b) LD_X_VXYOFFSET(c) LD_X_VXYOFFSET(d) LD_X_VXYOFFSET(e)
+LD_X_VXYOFFSET(h) LD_X_VXYOFFSET(l) LD_X_VXYOFFSET(a)
+LD_VXYOFFSET_Y(b) LD_VXYOFFSET_Y(c) LD_VXYOFFSET_Y(d) LD_VXYOFFSET_Y(e)
+LD_VXYOFFSET_Y(h) LD_VXYOFFSET_Y(l) LD_VXYOFFSET_Y(a)
+
 INSTRUCTION(ld_vhl_BYTE)       {WRITE_8(HL, READ_8((PC += 2) - 1));			    return 10;}
 INSTRUCTION(ld_vXYOFFSET_BYTE) {PC += 4; WRITE_8(XY + READ_OFFSET(PC - 2), READ_8(PC - 1)); return 19;}
 INSTRUCTION(ld_a_vbc)	       {PC++; A = READ_8(BC);					    return  7;}
@@ -886,19 +1354,26 @@ INSTRUCTION(ld_r_a)	       {PC += 2; R = R7 = A;					    return  9;}
 |  pop iy		<  FD  ><  E1  >		  ........  4 / 14  |
 '--------------------------------------------------------------------------*/
 
-INSTRUCTION(ld_SS_WORD)	 {SS0 = READ_16((PC += 3) - 2);		 return 10;}
+#define LD_SS_WORD(ss)	INSTRUCTION(ld_##ss##_WORD)	{R16(ss) = READ_16((PC += 3) - 2);		return 10;}
+#define LD_SS_VWORD(ss)	INSTRUCTION(ed_ld_##ss##_vWORD)	{R16(ss) = READ_16(READ_16((PC += 4) - 2));	return 20;}
+#define LD_VWORD_SS(ss)	INSTRUCTION(ed_ld_vWORD_##ss)	{WRITE_16(READ_16((PC += 4) - 2), R16(ss));	return 20;}
+#define PUSH_TT(tt)	INSTRUCTION(push_##tt)		{PC++; WRITE_16(SP -= 2, R16(tt));		return 11;}
+#define POP_TT(tt)	INSTRUCTION(pop_##tt)		{PC++; R16(tt) = READ_16(SP); SP += 2;		return 10;}
+
+LD_SS_WORD(bc) LD_SS_WORD(de) LD_SS_WORD(hl) LD_SS_WORD(sp)
+LD_SS_VWORD(bc) LD_SS_VWORD(de) LD_SS_VWORD(hl) LD_SS_VWORD(sp)
+LD_VWORD_SS(bc) LD_VWORD_SS(de) LD_VWORD_SS(hl) LD_VWORD_SS(sp)
+PUSH_TT(bc) PUSH_TT(de) PUSH_TT(hl) PUSH_TT(af)
+POP_TT(bc) POP_TT(de) POP_TT(hl) POP_TT(af)
+
 INSTRUCTION(ld_XY_WORD)	 {XY  = READ_16((PC += 4) - 2);		 return 14;}
 INSTRUCTION(ld_hl_vWORD) {HL  = READ_16(READ_16((PC += 3) - 2)); return 16;}
-INSTRUCTION(ld_SS_vWORD) {SS1 = READ_16(READ_16((PC += 4) - 2)); return 20;}
 INSTRUCTION(ld_XY_vWORD) {XY  = READ_16(READ_16((PC += 4) - 2)); return 20;}
 INSTRUCTION(ld_vWORD_hl) {WRITE_16(READ_16((PC += 3) - 2), HL);	 return 16;}
-INSTRUCTION(ld_vWORD_SS) {WRITE_16(READ_16((PC += 4) - 2), SS1); return 20;}
 INSTRUCTION(ld_vWORD_XY) {WRITE_16(READ_16((PC += 4) - 2), XY);	 return 20;}
 INSTRUCTION(ld_sp_hl)	 {PC++; SP = HL;			 return  6;}
 INSTRUCTION(ld_sp_XY)	 {PC += 2; SP = XY;			 return 10;}
-INSTRUCTION(push_TT)	 {PC++; WRITE_16(SP -= 2, TT);		 return 11;}
 INSTRUCTION(push_XY)	 {PC += 2; WRITE_16(SP -= 2, XY);	 return 15;}
-INSTRUCTION(pop_TT)	 {PC++; TT = READ_16(SP); SP += 2;	 return 10;}
 INSTRUCTION(pop_XY)	 {PC += 2; XY = READ_16(SP); SP += 2;	 return 14;}
 
 
@@ -958,15 +1433,34 @@ INSTRUCTION(cpdr)      {PC += 2; CPXR(--)					    }
 |  V (iy+OFFSET)	<  FD  >00110vvv<OFFSET>	  sz5h3v*.  6 / 23  |
 '--------------------------------------------------------------------------*/
 
-INSTRUCTION(U_a_Y)	   {PC++; U0(Y0);							    return  4;}
-INSTRUCTION(U_a_KQ)	   {PC += 2; U1(KQ);							    return  8;}
-INSTRUCTION(U_a_BYTE)	   {U0(READ_8((PC += 2) - 1));						    return  7;}
-INSTRUCTION(U_a_vhl)	   {PC++; U0(READ_8(HL));						    return  7;}
-INSTRUCTION(U_a_vXYOFFSET) {U1(READ_8(XY + READ_OFFSET((PC += 3) - 1)));			    return 19;}
-INSTRUCTION(V_X)	   {PC++;    zuint8 *r = __xxx___0(object); *r = V0(*r);		    return  4;}
-INSTRUCTION(V_JP)	   {PC += 2; zuint8 *r = __jjj___ (object); *r = V1(*r);		    return  8;}
-INSTRUCTION(V_vhl)	   {PC++; WRITE_8(HL, V0(READ_8(HL)));					    return 11;}
-INSTRUCTION(V_vXYOFFSET)   {zuint16 a = XY + READ_OFFSET((PC += 3) - 1); WRITE_8(a, V1(READ_8(a))); return 23;}
+#define U_A_Y(u, y)		INSTRUCTION(u##_a_##y)		{PC++; U(u, R8(y));								return  4;}
+#define U_A_KQ(u, k)		INSTRUCTION(u##_a_##k)		{PC += 2; U(u, R8(k));								return  8;}
+#define U_A_BYTE(u)		INSTRUCTION(u##_a_BYTE)		{U(u, READ_8((PC += 2) - 1));							return  7;}
+#define U_A_VHL(u)		INSTRUCTION(u##_a_vhl)		{PC++; U(u, READ_8(HL));							return  7;}
+#define U_A_VXYOFFSET(u)	INSTRUCTION(u##_a_vXYOFFSET)	{U(u, READ_8(XY + READ_OFFSET((PC += 3) - 1)));					return 19;}
+#define V_X(v, x)		INSTRUCTION(v##_##x)		{PC++; R8(x) = V(v, R8(x));							return  4;}
+#define V_JP(v, j)		INSTRUCTION(v##_##j)		{PC += 2; R8(j) = V(v, R8(j));							return  8;}
+#define V_VHL(v)		INSTRUCTION(v##_vhl)		{PC++; WRITE_8(HL, V(v, READ_8(HL)));						return 11;}
+#define V_VXYOFFSET(v)		INSTRUCTION(v##_vXYOFFSET)	{zuint16 a = XY + READ_OFFSET((PC += 3) - 1); WRITE_8(a, V(v, READ_8(a)));	return 23;}
+
+EACH_Y(U_A_Y, add) EACH_Y(U_A_Y, adc) EACH_Y(U_A_Y, sub) EACH_Y(U_A_Y, sbc)
+EACH_Y(U_A_Y, and) EACH_Y(U_A_Y, xor) EACH_Y(U_A_Y, or) EACH_Y(U_A_Y, cp)
+
+U_A_KQ(add, xyh) U_A_KQ(adc, xyh) U_A_KQ(sub, xyh) U_A_KQ(sbc, xyh)
+U_A_KQ(and, xyh) U_A_KQ(xor, xyh) U_A_KQ(or, xyh) U_A_KQ(cp, xyh)
+U_A_KQ(add, xyl) U_A_KQ(adc, xyl) U_A_KQ(sub, xyl) U_A_KQ(sbc, xyl)
+U_A_KQ(and, xyl) U_A_KQ(xor, xyl) U_A_KQ(or, xyl) U_A_KQ(cp, xyl)
+
+U_A_BYTE(add) U_A_BYTE(adc) U_A_BYTE(sub) U_A_BYTE(sbc)
+U_A_BYTE(and) U_A_BYTE(xor) U_A_BYTE(or) U_A_BYTE(cp)
+U_A_VHL(add) U_A_VHL(adc) U_A_VHL(sub) U_A_VHL(sbc)
+U_A_VHL(and) U_A_VHL(xor) U_A_VHL(or) U_A_VHL(cp)
+U_A_VXYOFFSET(add) U_A_VXYOFFSET(adc) U_A_VXYOFFSET(sub) U_A_VXYOFFSET(sbc)
+U_A_VXYOFFSET(and) U_A_VXYOFFSET(xor) U_A_VXYOFFSET(or) U_A_VXYOFFSET(cp)
+
+EACH_Y(V_X, inc) EACH_Y(V_X, dec)
+V_JP(inc, xyh) V_JP(inc, xyl) V_JP(dec, xyh) V_JP(dec, xyl)
+V_VHL(inc) V_VHL(dec) V_VXYOFFSET(inc) V_VXYOFFSET(dec)
 
 
 /* MARK: - Instructions: General-Purpose Arithmetic and CPU Control Group
@@ -1107,14 +1601,22 @@ INSTRUCTION(scf)
 |  dec iy		<  FD  ><  2B  >		  ........  2 / 10  |
 '--------------------------------------------------------------------------*/
 
-INSTRUCTION(add_hl_SS) {PC++;	 ADD_RR_NN(HL, SS0)			    return 11;}
-INSTRUCTION(adc_hl_SS) {PC += 2; ADC_SBC_HL_SS(adc, +, HL + v + c > 65535,)	      }
-INSTRUCTION(sbc_hl_SS) {PC += 2; ADC_SBC_HL_SS(sbc, -, HL < v + c, | NF)	      }
-INSTRUCTION(add_XY_WW) {PC += 2; ADD_RR_NN(XY, WW)			    return 15;}
-INSTRUCTION(inc_SS)    {PC++;	 SS0++;					    return  6;}
-INSTRUCTION(inc_XY)    {PC += 2; XY++;					    return 10;}
-INSTRUCTION(dec_SS)    {PC++;	 SS0--;					    return  6;}
-INSTRUCTION(dec_XY)    {PC += 2; XY--;					    return 15;}
+#define ADD_HL_SS(ss)	INSTRUCTION(add_hl_##ss)	{PC++;	 ADD_RR_NN(HL, R16(ss))					return 11;}
+#define ADC_HL_SS(ss)	INSTRUCTION(adc_hl_##ss)	{PC += 2; ADC_SBC_HL_SS(R16(ss), adc, +, HL + v + c > 65535,)		   }
+#define SBC_HL_SS(ss)	INSTRUCTION(sbc_hl_##ss)	{PC += 2; ADC_SBC_HL_SS(R16(ss), sbc, -, HL < v + c, | NF)		   }
+#define ADD_XY_WW(ww)	INSTRUCTION(add_xy_##ww)	{PC += 2; ADD_RR_NN(XY, R16(ww))				return 15;}
+#define INC_SS(ss)	INSTRUCTION(inc_##ss)		{PC++;	 R16(ss)++;						return  6;}
+#define DEC_SS(ss)	INSTRUCTION(dec_##ss)		{PC++;	 R16(ss)--;						return  6;}
+
+ADD_HL_SS(bc) ADD_HL_SS(de) ADD_HL_SS(hl) ADD_HL_SS(sp)
+ADC_HL_SS(bc) ADC_HL_SS(de) ADC_HL_SS(hl) ADC_HL_SS(sp)
+SBC_HL_SS(bc) SBC_HL_SS(de) SBC_HL_SS(hl) SBC_HL_SS(sp)
+ADD_XY_WW(bc) ADD_XY_WW(de) ADD_XY_WW(xy) ADD_XY_WW(sp)
+INC_SS(bc) INC_SS(de) INC_SS(hl) INC_SS(sp)
+DEC_SS(bc) DEC_SS(de) DEC_SS(hl) DEC_SS(sp)
+
+INSTRUCTION(inc_XY) {PC += 2; XY++; return 10;}
+INSTRUCTION(dec_XY) {PC += 2; XY--; return 15;}
 
 
 /* MARK: - Instructions: Rotate and Shift Group
@@ -1140,13 +1642,25 @@ INSTRUCTION(rlca)	   {PC++; ROL(A); F = F_SZP | (A & YXCF);		    return  4;}
 INSTRUCTION(rla)	   {PC++; zuint8 c = A >> 7; A = (A << 1) | F_C; RXA	    return  4;}
 INSTRUCTION(rrca)	   {PC++; ROR(A); F = F_SZP | A_YX | (A >> 7);		    return  4;}
 INSTRUCTION(rra)	   {PC++; zuint8 c = A & 1; A = (A >> 1) | (F << 7); RXA    return  4;}
-INSTRUCTION(G_Y)	   {zuint8 *r = _____yyy1(object); *r = G1(*r);		    return  8;}
-INSTRUCTION(G_vhl)	   {WRITE_8(HL, G1(READ_8(HL)));			    return 15;}
-INSTRUCTION(G_vXYOFFSET)   {zuint16 a = XY_ADDRESS; WRITE_8(a,	    G3(READ_8(a))); return 23;}
-INSTRUCTION(G_vXYOFFSET_Y) {zuint16 a = XY_ADDRESS; WRITE_8(a, Y3 = G3(READ_8(a))); return 23;}
 INSTRUCTION(rld)	   {PC += 2; RXD(<<, & 0xF, >> 4)			    return 18;}
 INSTRUCTION(rrd)	   {PC += 2; RXD(>>, << 4, & 0xF)			    return 18;}
 
+#define G_Y(g, y)		INSTRUCTION(g##_##y)		{R8(y) = G(g, R8(y));						return  8;}
+#define G_VHL(g)		INSTRUCTION(g##_vhl)		{WRITE_8(HL, G(g, READ_8(HL)));					return 15;}
+#define G_VXYOFFSET(g)		INSTRUCTION(g##_vXYOFFSET)	{zuint16 a = XY_ADDRESS; WRITE_8(a,	  G(g, READ_8(a)));	return 23;}
+#define G_VXYOFFSET_Y(g, y)	INSTRUCTION(g##_vXYOFFSET_##y)	{zuint16 a = XY_ADDRESS; WRITE_8(a, R8(y) = G(g, READ_8(a)));	return 23;}
+
+EACH_Y(G_Y, rlc) EACH_Y(G_Y, rrc) EACH_Y(G_Y, rl) EACH_Y(G_Y, rr)
+EACH_Y(G_Y, sla) EACH_Y(G_Y, sra) EACH_Y(G_Y, sll) EACH_Y(G_Y, srl)
+
+G_VHL(rlc) G_VHL(rrc) G_VHL(rl) G_VHL(rr) G_VHL(sla) G_VHL(sra) G_VHL(sll) G_VHL(srl)
+
+G_VXYOFFSET(rlc) G_VXYOFFSET(rrc) G_VXYOFFSET(rl) G_VXYOFFSET(rr)
+G_VXYOFFSET(sla) G_VXYOFFSET(sra) G_VXYOFFSET(sll) G_VXYOFFSET(srl)
+
+EACH_Y(G_VXYOFFSET_Y, rlc) EACH_Y(G_VXYOFFSET_Y, rrc) EACH_Y(G_VXYOFFSET_Y, rl) EACH_Y(G_VXYOFFSET_Y, rr)
+EACH_Y(G_VXYOFFSET_Y, sla) EACH_Y(G_VXYOFFSET_Y, sra) EACH_Y(G_VXYOFFSET_Y, sll) EACH_Y(G_VXYOFFSET_Y, srl)
+
 
 /* MARK: - Instructions: Bit Set, Reset and Test Group
 .---------------------------------------------------------------------------.
@@ -1165,13 +1679,41 @@ INSTRUCTION(rrd)	   {PC += 2; RXD(>>, << 4, & 0xF)			    return 18;}
 |  M N,(iy+OFFSET),Y	<  FD  ><  CB  ><OFFSET>1mnnnyyy  ........  6 / 23  |
 '--------------------------------------------------------------------------*/
 
-INSTRUCTION(bit_N_Y)	     {BIT_N_VALUE(Y1)					      return  8;}
-INSTRUCTION(bit_N_vhl)	     {BIT_N_VALUE(READ_8(HL))				      return 12;}
-INSTRUCTION(bit_N_vXYOFFSET) {BIT_N_VADDRESS(XY_ADDRESS)			      return 20;}
-INSTRUCTION(M_N_Y)	     {zuint8 *t = _____yyy1(object); *t = M1(*t);	      return  8;}
-INSTRUCTION(M_N_vhl)	     {WRITE_8(HL, M1(READ_8(HL)));			      return 15;}
-INSTRUCTION(M_N_vXYOFFSET)   {zuint16 a = XY_ADDRESS; WRITE_8(a,      M3(READ_8(a))); return 23;}
-INSTRUCTION(M_N_vXYOFFSET_Y) {zuint16 a = XY_ADDRESS; WRITE_8(a, Y3 = M3(READ_8(a))); return 23;}
+#define BIT_N_Y(n, y)			INSTRUCTION(bit_##n##_##y)		{BIT_N_VALUE(n, R8(y))							return  8;}
+#define BIT_N_VHL(n)			INSTRUCTION(bit_##n##_vhl)		{BIT_N_VALUE(n, READ_8(HL))						return 12;}
+#define BIT_N_VXYOFFSET(n)		INSTRUCTION(bit_##n##_vXYOFFSET)	{BIT_N_VADDRESS(n, XY_ADDRESS)						return 20;}
+#define M_N_Y(m, n, y)			INSTRUCTION(m##_##n##_##y)		{R8(y) = M(m, n, R8(y));						return  8;}
+#define M_N_VHL(m, n)			INSTRUCTION(m##_##n##_vhl)		{WRITE_8(HL, M(m, n, READ_8(HL)));					return 15;}
+#define M_N_VXYOFFSET(m, n)		INSTRUCTION(m##_##n##_vXYOFFSET)	{zuint16 a = XY_ADDRESS; WRITE_8(a,	     M(m, n, READ_8(a)));	return 23;}
+#define M_N_VXYOFFSET_Y(m, n, y)	INSTRUCTION(m##_##n##_vXYOFFSET_##y)	{zuint16 a = XY_ADDRESS; WRITE_8(a, R8(y) = M(m, n, READ_8(a)));	return 23;}
+
+EACH_Y(BIT_N_Y, 0) EACH_Y(BIT_N_Y, 1) EACH_Y(BIT_N_Y, 2) EACH_Y(BIT_N_Y, 3)
+EACH_Y(BIT_N_Y, 4) EACH_Y(BIT_N_Y, 5) EACH_Y(BIT_N_Y, 6) EACH_Y(BIT_N_Y, 7)
+
+BIT_N_VHL(0) BIT_N_VHL(1) BIT_N_VHL(2) BIT_N_VHL(3) BIT_N_VHL(4) BIT_N_VHL(5) BIT_N_VHL(6) BIT_N_VHL(7)
+
+BIT_N_VXYOFFSET(0) BIT_N_VXYOFFSET(1) BIT_N_VXYOFFSET(2) BIT_N_VXYOFFSET(3)
+BIT_N_VXYOFFSET(4) BIT_N_VXYOFFSET(5) BIT_N_VXYOFFSET(6) BIT_N_VXYOFFSET(7)
+
+EACH_Y(M_N_Y, res, 0) EACH_Y(M_N_Y, res, 1) EACH_Y(M_N_Y, res, 2) EACH_Y(M_N_Y, res, 3)
+EACH_Y(M_N_Y, res, 4) EACH_Y(M_N_Y, res, 5) EACH_Y(M_N_Y, res, 6) EACH_Y(M_N_Y, res, 7)
+EACH_Y(M_N_Y, set, 0) EACH_Y(M_N_Y, set, 1) EACH_Y(M_N_Y, set, 2) EACH_Y(M_N_Y, set, 3)
+EACH_Y(M_N_Y, set, 4) EACH_Y(M_N_Y, set, 5) EACH_Y(M_N_Y, set, 6) EACH_Y(M_N_Y, set, 7)
+
+M_N_VHL(res, 0) M_N_VHL(res, 1) M_N_VHL(res, 2) M_N_VHL(res, 3)
+M_N_VHL(res, 4) M_N_VHL(res, 5) M_N_VHL(res, 6) M_N_VHL(res, 7)
+M_N_VHL(set, 0) M_N_VHL(set, 1) M_N_VHL(set, 2) M_N_VHL(set, 3)
+M_N_VHL(set, 4) M_N_VHL(set, 5) M_N_VHL(set, 6) M_N_VHL(set, 7)
+
+M_N_VXYOFFSET(res, 0) M_N_VXYOFFSET(res, 1) M_N_VXYOFFSET(res, 2) M_N_VXYOFFSET(res, 3)
+M_N_VXYOFFSET(res, 4) M_N_VXYOFFSET(res, 5) M_N_VXYOFFSET(res, 6) M_N_VXYOFFSET(res, 7)
+M_N_VXYOFFSET(set, 0) M_N_VXYOFFSET(set, 1) M_N_VXYOFFSET(set, 2) M_N_VXYOFFSET(set, 3)
+M_N_VXYOFFSET(set, 4) M_N_VXYOFFSET(set, 5) M_N_VXYOFFSET(set, 6) M_N_VXYOFFSET(set, 7)
+
+EACH_Y(M_N_VXYOFFSET_Y, res, 0) EACH_Y(M_N_VXYOFFSET_Y, res, 1) EACH_Y(M_N_VXYOFFSET_Y, res, 2) EACH_Y(M_N_VXYOFFSET_Y, res, 3)
+EACH_Y(M_N_VXYOFFSET_Y, res, 4) EACH_Y(M_N_VXYOFFSET_Y, res, 5) EACH_Y(M_N_VXYOFFSET_Y, res, 6) EACH_Y(M_N_VXYOFFSET_Y, res, 7)
+EACH_Y(M_N_VXYOFFSET_Y, set, 0) EACH_Y(M_N_VXYOFFSET_Y, set, 1) EACH_Y(M_N_VXYOFFSET_Y, set, 2) EACH_Y(M_N_VXYOFFSET_Y, set, 3)
+EACH_Y(M_N_VXYOFFSET_Y, set, 4) EACH_Y(M_N_VXYOFFSET_Y, set, 5) EACH_Y(M_N_VXYOFFSET_Y, set, 6) EACH_Y(M_N_VXYOFFSET_Y, set, 7)
 
 
 /* MARK: - Instructions: Jump Group
@@ -1190,13 +1732,17 @@ INSTRUCTION(M_N_vXYOFFSET_Y) {zuint16 a = XY_ADDRESS; WRITE_8(a, Y3 = M3(READ_8(
 '------------------------------------------------------------------------------*/
 
 INSTRUCTION(jp_WORD)	 {PC = READ_16(PC + 1);							return 10;}
-INSTRUCTION(jp_Z_WORD)	 {PC = Z ? READ_16(PC + 1) : PC + 3;					return 10;}
 INSTRUCTION(jr_OFFSET)	 {PC += (2 + READ_OFFSET(PC + 1));					return 12;}
-INSTRUCTION(jr_Z_OFFSET) {BYTE0 &= 223; PC += 2; if (Z) {PC += READ_OFFSET(PC - 1); return 12;} return	7;}
 INSTRUCTION(jp_hl)	 {PC = HL;								return	4;}
 INSTRUCTION(jp_XY)	 {PC = XY;								return	8;}
 INSTRUCTION(djnz_OFFSET) {PC += 2; if (--B) {PC += READ_OFFSET(PC - 1); return 13;}		return	8;}
 
+#define JP_Z_WORD(z)	INSTRUCTION(jp_##z##_WORD)	{PC = Z(z) ? READ_16(PC + 1) : PC + 3;				return 10;}
+#define JR_Z_OFFSET(z)	INSTRUCTION(jr_##z##_OFFSET)	{PC += 2; if (Z(z)) {PC += READ_OFFSET(PC - 1); return 12;}	return  7;}
+
+JP_Z_WORD(nz) JP_Z_WORD(z) JP_Z_WORD(nc) JP_Z_WORD(c) JP_Z_WORD(po) JP_Z_WORD(pe) JP_Z_WORD(p) JP_Z_WORD(m)
+JR_Z_OFFSET(nz) JR_Z_OFFSET(z) JR_Z_OFFSET(nc) JR_Z_OFFSET(c)
+
 
 /* MARK: - Instructions: Call and Return Group
 .--------------------------------------------------------------------------------.
@@ -1219,12 +1765,17 @@ INSTRUCTION(djnz_OFFSET) {PC += 2; if (--B) {PC += READ_OFFSET(PC - 1); return 1
 '-------------------------------------------------------------------------------*/
 
 INSTRUCTION(call_WORD)	 {PUSH(PC + 3); PC = READ_16(PC + 1);	    return 17;}
-INSTRUCTION(call_Z_WORD) {if (Z) return call_WORD(object); PC += 3; return 10;}
 INSTRUCTION(ret)	 {RET;					    return 10;}
-INSTRUCTION(ret_Z)	 {if (Z) {RET; return 11;} PC++;	    return  5;}
 INSTRUCTION(reti)	 {IFF1 = IFF2; RET;			    return 14;}
 INSTRUCTION(retn)	 {IFF1 = IFF2; RET;			    return 14;}
-INSTRUCTION(rst_N)	 {PUSH(PC + 1); PC = BYTE0 & 56;	    return 11;}
+
+#define CALL_Z_WORD(z)	INSTRUCTION(call_##z##_WORD)	{if (Z(z)) return call_WORD(object); PC += 3;	return 10;}
+#define RET_Z(z)	INSTRUCTION(ret_##z)		{if (Z(z)) {RET; return 11;} PC++;		return  5;}
+#define RST_N(n)	INSTRUCTION(rst_##n)		{PUSH(PC + 1); PC = 0x##n;			return 11;}
+
+CALL_Z_WORD(nz) CALL_Z_WORD(z) CALL_Z_WORD(nc) CALL_Z_WORD(c) CALL_Z_WORD(po) CALL_Z_WORD(pe) CALL_Z_WORD(p) CALL_Z_WORD(m)
+RET_Z(nz) RET_Z(z) RET_Z(nc) RET_Z(c) RET_Z(po) RET_Z(pe) RET_Z(p) RET_Z(m)
+RST_N(00) RST_N(08) RST_N(10) RST_N(18) RST_N(20) RST_N(28) RST_N(30) RST_N(38)
 
 
 /* MARK: - Instructions: Input and Output Group
@@ -1249,20 +1800,24 @@ INSTRUCTION(rst_N)	 {PUSH(PC + 1); PC = BYTE0 & 56;	    return 11;}
 '-------------------------------------------------------------------------------*/
 
 INSTRUCTION(in_a_BYTE)	 {A = IN((A << 8) | READ_8((PC += 2) - 1)); return 11;}
-INSTRUCTION(in_X_vc)	 {PC += 2; IN_VC; X1 = t;		    return 12;}
 INSTRUCTION(in_0_vc)	 {PC += 2; IN_VC;			    return 16;}
 INSTRUCTION(ini)	 {PC += 2; INX(++)			    return 16;}
 INSTRUCTION(inir)	 {PC += 2; INXR(++)				      }
 INSTRUCTION(ind)	 {PC += 2; INX(--)			    return 16;}
 INSTRUCTION(indr)	 {PC += 2; INXR(--)				      }
 INSTRUCTION(out_vBYTE_a) {OUT((A << 8) | READ_8((PC += 2) - 1), A); return 11;}
-INSTRUCTION(out_vc_X)	 {PC += 2; OUT(BC, X1);			    return 12;}
 INSTRUCTION(out_vc_0)	 {PC += 2; OUT(BC, 0);			    return 12;}
 INSTRUCTION(outi)	 {PC += 2; OUTX(++)			    return 16;}
 INSTRUCTION(otir)	 {PC += 2; OTXR(++)				      }
 INSTRUCTION(outd)	 {PC += 2; OUTX(--)			    return 16;}
 INSTRUCTION(otdr)	 {PC += 2; OTXR(--)				      }
 
+#define IN_X_VC(x)	INSTRUCTION(in_##x##_vc)	{PC += 2; IN_VC; R8(x) = t;	return 12;}
+#define OUT_VC_X(x)	INSTRUCTION(out_vc_##x)		{PC += 2; OUT(BC, R8(x));	return 12;}
+
+IN_X_VC(b) IN_X_VC(c) IN_X_VC(d) IN_X_VC(e) IN_X_VC(h) IN_X_VC(l) IN_X_VC(a)
+OUT_VC_X(b) OUT_VC_X(c) OUT_VC_X(d) OUT_VC_X(e) OUT_VC_X(h) OUT_VC_X(l) OUT_VC_X(a)
+
 
 /* MARK: - Opcode Selector Prototypes */
 
@@ -1278,103 +1833,103 @@ INSTRUCTION(XY_illegal);
 /* MARK: - Instruction Function Tables */
 
 static Instruction const instruction_table[256] = {
-/*	0	     1		 2	      3		   4		5	  6	       7	 8	      9		 A	      B		 C	      D		 E	    F */
-/* 0 */ nop,	     ld_SS_WORD, ld_vbc_a,    inc_SS,	   V_X,		V_X,	  ld_X_BYTE,   rlca,	 ex_af_af_,   add_hl_SS, ld_a_vbc,    dec_SS,	 V_X,	      V_X,	 ld_X_BYTE, rrca,
-/* 1 */ djnz_OFFSET, ld_SS_WORD, ld_vde_a,    inc_SS,	   V_X,		V_X,	  ld_X_BYTE,   rla,	 jr_OFFSET,   add_hl_SS, ld_a_vde,    dec_SS,	 V_X,	      V_X,	 ld_X_BYTE, rra,
-/* 2 */ jr_Z_OFFSET, ld_SS_WORD, ld_vWORD_hl, inc_SS,	   V_X,		V_X,	  ld_X_BYTE,   daa,	 jr_Z_OFFSET, add_hl_SS, ld_hl_vWORD, dec_SS,	 V_X,	      V_X,	 ld_X_BYTE, cpl,
-/* 3 */ jr_Z_OFFSET, ld_SS_WORD, ld_vWORD_a,  inc_SS,	   V_vhl,	V_vhl,	  ld_vhl_BYTE, scf,	 jr_Z_OFFSET, add_hl_SS, ld_a_vWORD,  dec_SS,	 V_X,	      V_X,	 ld_X_BYTE, ccf,
-/* 4 */ ld_X_Y,	     ld_X_Y,	 ld_X_Y,      ld_X_Y,	   ld_X_Y,	ld_X_Y,	  ld_X_vhl,    ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_vhl,  ld_X_Y,
-/* 5 */ ld_X_Y,	     ld_X_Y,	 ld_X_Y,      ld_X_Y,	   ld_X_Y,	ld_X_Y,	  ld_X_vhl,    ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_vhl,  ld_X_Y,
-/* 6 */ ld_X_Y,	     ld_X_Y,	 ld_X_Y,      ld_X_Y,	   ld_X_Y,	ld_X_Y,	  ld_X_vhl,    ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_vhl,  ld_X_Y,
-/* 7 */ ld_vhl_Y,    ld_vhl_Y,	 ld_vhl_Y,    ld_vhl_Y,	   ld_vhl_Y,	ld_vhl_Y, halt,	       ld_vhl_Y, ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_Y,      ld_X_Y,	 ld_X_vhl,  ld_X_Y,
-/* 8 */ U_a_Y,	     U_a_Y,	 U_a_Y,	      U_a_Y,	   U_a_Y,	U_a_Y,	  U_a_vhl,     U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_vhl,   U_a_Y,
-/* 9 */ U_a_Y,	     U_a_Y,	 U_a_Y,	      U_a_Y,	   U_a_Y,	U_a_Y,	  U_a_vhl,     U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_vhl,   U_a_Y,
-/* A */ U_a_Y,	     U_a_Y,	 U_a_Y,	      U_a_Y,	   U_a_Y,	U_a_Y,	  U_a_vhl,     U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_vhl,   U_a_Y,
-/* B */ U_a_Y,	     U_a_Y,	 U_a_Y,	      U_a_Y,	   U_a_Y,	U_a_Y,	  U_a_vhl,     U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_Y,	      U_a_Y,	 U_a_vhl,   U_a_Y,
-/* C */ ret_Z,	     pop_TT,	 jp_Z_WORD,   jp_WORD,	   call_Z_WORD,	push_TT,  U_a_BYTE,    rst_N,	 ret_Z,	      ret,	 jp_Z_WORD,   CB,	 call_Z_WORD, call_WORD, U_a_BYTE,  rst_N,
-/* D */ ret_Z,	     pop_TT,	 jp_Z_WORD,   out_vBYTE_a, call_Z_WORD,	push_TT,  U_a_BYTE,    rst_N,	 ret_Z,	      exx,	 jp_Z_WORD,   in_a_BYTE, call_Z_WORD, DD,	 U_a_BYTE,  rst_N,
-/* E */ ret_Z,	     pop_TT,	 jp_Z_WORD,   ex_vsp_hl,   call_Z_WORD,	push_TT,  U_a_BYTE,    rst_N,	 ret_Z,	      jp_hl,	 jp_Z_WORD,   ex_de_hl,	 call_Z_WORD, ED,	 U_a_BYTE,  rst_N,
-/* F */ ret_Z,	     pop_TT,	 jp_Z_WORD,   di,	   call_Z_WORD,	push_TT,  U_a_BYTE,    rst_N,	 ret_Z,	      ld_sp_hl,	 jp_Z_WORD,   ei,	 call_Z_WORD, FD,	 U_a_BYTE,  rst_N
+/*	0		1		2		3		4		5		6		7		8		9		A		B		C		D		E		F */
+/* 0 */ nop,		ld_bc_WORD,	ld_vbc_a,	inc_bc,		inc_b,		dec_b,		ld_b_BYTE,	rlca,		ex_af_af_,	add_hl_bc,	ld_a_vbc,	dec_bc,		inc_c,		dec_c,		ld_c_BYTE,	rrca,
+/* 1 */ djnz_OFFSET,	ld_de_WORD,	ld_vde_a,	inc_de,		inc_d,		dec_d,		ld_d_BYTE,	rla,		jr_OFFSET,	add_hl_de,	ld_a_vde,	dec_de,		inc_e,		dec_e,		ld_e_BYTE,	rra,
+/* 2 */ jr_nz_OFFSET,	ld_hl_WORD,	ld_vWORD_hl,	inc_hl,		inc_h,		dec_h,		ld_h_BYTE,	daa,		jr_z_OFFSET,	add_hl_hl,	ld_hl_vWORD,	dec_hl,		inc_l,		dec_l,		ld_l_BYTE,	cpl,
+/* 3 */ jr_nc_OFFSET,	ld_sp_WORD,	ld_vWORD_a,	inc_sp,		inc_vhl,	dec_vhl,	ld_vhl_BYTE,	scf,		jr_c_OFFSET,	add_hl_sp,	ld_a_vWORD,	dec_sp,		inc_a,		dec_a,		ld_a_BYTE,	ccf,
+/* 4 */ ld_b_b,		ld_b_c,		ld_b_d,		ld_b_e,		ld_b_h,		ld_b_l,		ld_b_vhl,	ld_b_a,		ld_c_b,		ld_c_c,		ld_c_d,		ld_c_e,		ld_c_h,		ld_c_l,		ld_c_vhl,	ld_c_a,
+/* 5 */ ld_d_b,		ld_d_c,		ld_d_d,		ld_d_e,		ld_d_h,		ld_d_l,		ld_d_vhl,	ld_d_a,		ld_e_b,		ld_e_c,		ld_e_d,		ld_e_e,		ld_e_h,		ld_e_l,		ld_e_vhl,	ld_e_a,
+/* 6 */ ld_h_b,		ld_h_c,		ld_h_d,		ld_h_e,		ld_h_h,		ld_h_l,		ld_h_vhl,	ld_h_a,		ld_l_b,		ld_l_c,		ld_l_d,		ld_l_e,		ld_l_h,		ld_l_l,		ld_l_vhl,	ld_l_a,
+/* 7 */ ld_vhl_b,	ld_vhl_c,	ld_vhl_d,	ld_vhl_e,	ld_vhl_h,	ld_vhl_l,	halt,		ld_vhl_a,	ld_a_b,		ld_a_c,		ld_a_d,		ld_a_e,		ld_a_h,		ld_a_l,		ld_a_vhl,	ld_a_a,
+/* 8 */ add_a_b,	add_a_c,	add_a_d,	add_a_e,	add_a_h,	add_a_l,	add_a_vhl,	add_a_a,	adc_a_b,	adc_a_c,	adc_a_d,	adc_a_e,	adc_a_h,	adc_a_l,	adc_a_vhl,	adc_a_a,
+/* 9 */ sub_a_b,	sub_a_c,	sub_a_d,	sub_a_e,	sub_a_h,	sub_a_l,	sub_a_vhl,	sub_a_a,	sbc_a_b,	sbc_a_c,	sbc_a_d,	sbc_a_e,	sbc_a_h,	sbc_a_l,	sbc_a_vhl,	sbc_a_a,
+/* A */ and_a_b,	and_a_c,	and_a_d,	and_a_e,	and_a_h,	and_a_l,	and_a_vhl,	and_a_a,	xor_a_b,	xor_a_c,	xor_a_d,	xor_a_e,	xor_a_h,	xor_a_l,	xor_a_vhl,	xor_a_a,
+/* B */ or_a_b,		or_a_c,		or_a_d,		or_a_e,		or_a_h,		or_a_l,		or_a_vhl,	or_a_a,		cp_a_b,		cp_a_c,		cp_a_d,		cp_a_e,		cp_a_h,		cp_a_l,		cp_a_vhl,	cp_a_a,
+/* C */ ret_nz,		pop_bc,		jp_nz_WORD,	jp_WORD,	call_nz_WORD,	push_bc,	add_a_BYTE,	rst_00,		ret_z,		ret,		jp_z_WORD,	CB,		call_z_WORD,	call_WORD,	adc_a_BYTE,	rst_08,
+/* D */ ret_nc,		pop_de,		jp_nc_WORD,	out_vBYTE_a,	call_nc_WORD,	push_de,	sub_a_BYTE,	rst_10,		ret_c,		exx,		jp_c_WORD,	in_a_BYTE,	call_c_WORD,	DD,		sbc_a_BYTE,	rst_18,
+/* E */ ret_po,		pop_hl,		jp_po_WORD,	ex_vsp_hl,	call_po_WORD,	push_hl,	and_a_BYTE,	rst_20,		ret_pe,		jp_hl,		jp_pe_WORD,	ex_de_hl,	call_pe_WORD,	ED,		xor_a_BYTE,	rst_28,
+/* F */ ret_p,		pop_af,		jp_p_WORD,	di,		call_p_WORD,	push_af,	or_a_BYTE,	rst_30,		ret_m,		ld_sp_hl,	jp_m_WORD,	ei,		call_m_WORD,	FD,		cp_a_BYTE,	rst_38
 };
 
 static Instruction const instruction_table_CB[256] = {
-/*	0	 1	  2	   3	    4	     5	      6		 7	  8	   9	    A	     B	      C	       D	E	   F */
-/* 0 */ G_Y,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_vhl,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_Y,     G_Y,	G_vhl,	   G_Y,
-/* 1 */ G_Y,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_vhl,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_Y,     G_Y,	G_vhl,	   G_Y,
-/* 2 */ G_Y,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_vhl,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_Y,     G_Y,	G_vhl,	   G_Y,
-/* 3 */ G_Y,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_vhl,	 G_Y,	  G_Y,	   G_Y,	    G_Y,     G_Y,     G_Y,     G_Y,	G_vhl,	   G_Y,
-/* 4 */ bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y,
-/* 5 */ bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y,
-/* 6 */ bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y,
-/* 7 */ bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_Y, bit_N_vhl, bit_N_Y,
-/* 8 */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y,
-/* 9 */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y,
-/* A */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y,
-/* B */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y,
-/* C */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y,
-/* D */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y,
-/* E */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y,
-/* F */ M_N_Y,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_vhl,	 M_N_Y,	  M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,   M_N_Y,	M_N_vhl,   M_N_Y
+/*	0		1		2		3		4		5		6		7		8		9		A		B		C		D		E		F */
+/* 0 */ rlc_b,		rlc_c,		rlc_d,		rlc_e,		rlc_h,		rlc_l,		rlc_vhl,	rlc_a,		rrc_b,		rrc_c,		rrc_d,		rrc_e,		rrc_h,		rrc_l,		rrc_vhl,	rrc_a,
+/* 1 */ rl_b,		rl_c,		rl_d,		rl_e,		rl_h,		rl_l,		rl_vhl,		rl_a,		rr_b,		rr_c,		rr_d,		rr_e,		rr_h,		rr_l,		rr_vhl,		rr_a,
+/* 2 */ sla_b,		sla_c,		sla_d,		sla_e,		sla_h,		sla_l,		sla_vhl,	sla_a,		sra_b,		sra_c,		sra_d,		sra_e,		sra_h,		sra_l,		sra_vhl,	sra_a,
+/* 3 */ sll_b,		sll_c,		sll_d,		sll_e,		sll_h,		sll_l,		sll_vhl,	sll_a,		srl_b,		srl_c,		srl_d,		srl_e,		srl_h,		srl_l,		srl_vhl,	srl_a,
+/* 4 */ bit_0_b,	bit_0_c,	bit_0_d,	bit_0_e,	bit_0_h,	bit_0_l,	bit_0_vhl,	bit_0_a,	bit_1_b,	bit_1_c,	bit_1_d,	bit_1_e,	bit_1_h,	bit_1_l,	bit_1_vhl,	bit_1_a,
+/* 5 */ bit_2_b,	bit_2_c,	bit_2_d,	bit_2_e,	bit_2_h,	bit_2_l,	bit_2_vhl,	bit_2_a,	bit_3_b,	bit_3_c,	bit_3_d,	bit_3_e,	bit_3_h,	bit_3_l,	bit_3_vhl,	bit_3_a,
+/* 6 */ bit_4_b,	bit_4_c,	bit_4_d,	bit_4_e,	bit_4_h,	bit_4_l,	bit_4_vhl,	bit_4_a,	bit_5_b,	bit_5_c,	bit_5_d,	bit_5_e,	bit_5_h,	bit_5_l,	bit_5_vhl,	bit_5_a,
+/* 7 */ bit_6_b,	bit_6_c,	bit_6_d,	bit_6_e,	bit_6_h,	bit_6_l,	bit_6_vhl,	bit_6_a,	bit_7_b,	bit_7_c,	bit_7_d,	bit_7_e,	bit_7_h,	bit_7_l,	bit_7_vhl,	bit_7_a,
+/* 8 */ res_0_b,	res_0_c,	res_0_d,	res_0_e,	res_0_h,	res_0_l,	res_0_vhl,	res_0_a,	res_1_b,	res_1_c,	res_1_d,	res_1_e,	res_1_h,	res_1_l,	res_1_vhl,	res_1_a,
+/* 9 */ res_2_b,	res_2_c,	res_2_d,	res_2_e,	res_2_h,	res_2_l,	res_2_vhl,	res_2_a,	res_3_b,	res_3_c,	res_3_d,	res_3_e,	res_3_h,	res_3_l,	res_3_vhl,	res_3_a,
+/* A */ res_4_b,	res_4_c,	res_4_d,	res_4_e,	res_4_h,	res_4_l,	res_4_vhl,	res_4_a,	res_5_b,	res_5_c,	res_5_d,	res_5_e,	res_5_h,	res_5_l,	res_5_vhl,	res_5_a,
+/* B */ res_6_b,	res_6_c,	res_6_d,	res_6_e,	res_6_h,	res_6_l,	res_6_vhl,	res_6_a,	res_7_b,	res_7_c,	res_7_d,	res_7_e,	res_7_h,	res_7_l,	res_7_vhl,	res_7_a,
+/* C */ set_0_b,	set_0_c,	set_0_d,	set_0_e,	set_0_h,	set_0_l,	set_0_vhl,	set_0_a,	set_1_b,	set_1_c,	set_1_d,	set_1_e,	set_1_h,	set_1_l,	set_1_vhl,	set_1_a,
+/* D */ set_2_b,	set_2_c,	set_2_d,	set_2_e,	set_2_h,	set_2_l,	set_2_vhl,	set_2_a,	set_3_b,	set_3_c,	set_3_d,	set_3_e,	set_3_h,	set_3_l,	set_3_vhl,	set_3_a,
+/* E */ set_4_b,	set_4_c,	set_4_d,	set_4_e,	set_4_h,	set_4_l,	set_4_vhl,	set_4_a,	set_5_b,	set_5_c,	set_5_d,	set_5_e,	set_5_h,	set_5_l,	set_5_vhl,	set_5_a,
+/* F */ set_6_b,	set_6_c,	set_6_d,	set_6_e,	set_6_h,	set_6_l,	set_6_vhl,	set_6_a,	set_7_b,	set_7_c,	set_7_d,	set_7_e,	set_7_h,	set_7_l,	set_7_vhl,	set_7_a
 };
 
 static Instruction const instruction_table_XY_CB[256] = {
-/*	0		 1		  2		   3		    4		     5		      6		       7		8		 9		  A		   B		    C		     D		      E		       F */
-/* 0 */ G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,	G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,
-/* 1 */ G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,	G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,
-/* 2 */ G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,	G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,
-/* 3 */ G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,	G_vXYOFFSET_Y,	 G_vXYOFFSET_Y,	  G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET_Y,   G_vXYOFFSET,     G_vXYOFFSET_Y,
-/* 4 */ bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET,
-/* 5 */ bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET,
-/* 6 */ bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET,
-/* 7 */ bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET, bit_N_vXYOFFSET,
-/* 8 */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y,
-/* 9 */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y,
-/* A */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y,
-/* B */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y,
-/* C */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y,
-/* D */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y,
-/* E */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y,
-/* F */ M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET_Y, M_N_vXYOFFSET,   M_N_vXYOFFSET_Y
+/*	0			1			2			3			4			5			6			7			8			9			A			B			C			D			E			F */
+/* 0 */ rlc_vXYOFFSET_b,	rlc_vXYOFFSET_c,	rlc_vXYOFFSET_d,	rlc_vXYOFFSET_e,	rlc_vXYOFFSET_h,	rlc_vXYOFFSET_l,	rlc_vXYOFFSET,		rlc_vXYOFFSET_a,	rrc_vXYOFFSET_b,	rrc_vXYOFFSET_c,	rrc_vXYOFFSET_d,	rrc_vXYOFFSET_e,	rrc_vXYOFFSET_h,	rrc_vXYOFFSET_l,	rrc_vXYOFFSET,		rrc_vXYOFFSET_a,
+/* 1 */ rl_vXYOFFSET_b,		rl_vXYOFFSET_c,		rl_vXYOFFSET_d,		rl_vXYOFFSET_e,		rl_vXYOFFSET_h,		rl_vXYOFFSET_l,		rl_vXYOFFSET,		rl_vXYOFFSET_a,		rr_vXYOFFSET_b,		rr_vXYOFFSET_c,		rr_vXYOFFSET_d,		rr_vXYOFFSET_e,		rr_vXYOFFSET_h,		rr_vXYOFFSET_l,		rr_vXYOFFSET,		rr_vXYOFFSET_a,
+/* 2 */ sla_vXYOFFSET_b,	sla_vXYOFFSET_c,	sla_vXYOFFSET_d,	sla_vXYOFFSET_e,	sla_vXYOFFSET_h,	sla_vXYOFFSET_l,	sla_vXYOFFSET,		sla_vXYOFFSET_a,	sra_vXYOFFSET_b,	sra_vXYOFFSET_c,	sra_vXYOFFSET_d,	sra_vXYOFFSET_e,	sra_vXYOFFSET_h,	sra_vXYOFFSET_l,	sra_vXYOFFSET,		sra_vXYOFFSET_a,
+/* 3 */ sll_vXYOFFSET_b,	sll_vXYOFFSET_c,	sll_vXYOFFSET_d,	sll_vXYOFFSET_e,	sll_vXYOFFSET_h,	sll_vXYOFFSET_l,	sll_vXYOFFSET,		sll_vXYOFFSET_a,	srl_vXYOFFSET_b,	srl_vXYOFFSET_c,	srl_vXYOFFSET_d,	srl_vXYOFFSET_e,	srl_vXYOFFSET_h,	srl_vXYOFFSET_l,	srl_vXYOFFSET,		srl_vXYOFFSET_a,
+/* 4 */ bit_0_vXYOFFSET,	bit_0_vXYOFFSET,	bit_0_vXYOFFSET,	bit_0_vXYOFFSET,	bit_0_vXYOFFSET,	bit_0_vXYOFFSET,	bit_0_vXYOFFSET,	bit_0_vXYOFFSET,	bit_1_vXYOFFSET,	bit_1_vXYOFFSET,	bit_1_vXYOFFSET,	bit_1_vXYOFFSET,	bit_1_vXYOFFSET,	bit_1_vXYOFFSET,	bit_1_vXYOFFSET,	bit_1_vXYOFFSET,
+/* 5 */ bit_2_vXYOFFSET,	bit_2_vXYOFFSET,	bit_2_vXYOFFSET,	bit_2_vXYOFFSET,	bit_2_vXYOFFSET,	bit_2_vXYOFFSET,	bit_2_vXYOFFSET,	bit_2_vXYOFFSET,	bit_3_vXYOFFSET,	bit_3_vXYOFFSET,	bit_3_vXYOFFSET,	bit_3_vXYOFFSET,	bit_3_vXYOFFSET,	bit_3_vXYOFFSET,	bit_3_vXYOFFSET,	bit_3_vXYOFFSET,
+/* 6 */ bit_4_vXYOFFSET,	bit_4_vXYOFFSET,	bit_4_vXYOFFSET,	bit_4_vXYOFFSET,	bit_4_vXYOFFSET,	bit_4_vXYOFFSET,	bit_4_vXYOFFSET,	bit_4_vXYOFFSET,	bit_5_vXYOFFSET,	bit_5_vXYOFFSET,	bit_5_vXYOFFSET,	bit_5_vXYOFFSET,	bit_5_vXYOFFSET,	bit_5_vXYOFFSET,	bit_5_vXYOFFSET,	bit_5_vXYOFFSET,
+/* 7 */ bit_6_vXYOFFSET,	bit_6_vXYOFFSET,	bit_6_vXYOFFSET,	bit_6_vXYOFFSET,	bit_6_vXYOFFSET,	bit_6_vXYOFFSET,	bit_6_vXYOFFSET,	bit_6_vXYOFFSET,	bit_7_vXYOFFSET,	bit_7_vXYOFFSET,	bit_7_vXYOFFSET,	bit_7_vXYOFFSET,	bit_7_vXYOFFSET,	bit_7_vXYOFFSET,	bit_7_vXYOFFSET,	bit_7_vXYOFFSET,
+/* 8 */ res_0_vXYOFFSET_b,	res_0_vXYOFFSET_c,	res_0_vXYOFFSET_d,	res_0_vXYOFFSET_e,	res_0_vXYOFFSET_h,	res_0_vXYOFFSET_l,	res_0_vXYOFFSET,	res_0_vXYOFFSET_a,	res_1_vXYOFFSET_b,	res_1_vXYOFFSET_c,	res_1_vXYOFFSET_d,	res_1_vXYOFFSET_e,	res_1_vXYOFFSET_h,	res_1_vXYOFFSET_l,	res_1_vXYOFFSET,	res_1_vXYOFFSET_a,
+/* 9 */ res_2_vXYOFFSET_b,	res_2_vXYOFFSET_c,	res_2_vXYOFFSET_d,	res_2_vXYOFFSET_e,	res_2_vXYOFFSET_h,	res_2_vXYOFFSET_l,	res_2_vXYOFFSET,	res_2_vXYOFFSET_a,	res_3_vXYOFFSET_b,	res_3_vXYOFFSET_c,	res_3_vXYOFFSET_d,	res_3_vXYOFFSET_e,	res_3_vXYOFFSET_h,	res_3_vXYOFFSET_l,	res_3_vXYOFFSET,	res_3_vXYOFFSET_a,
+/* A */ res_4_vXYOFFSET_b,	res_4_vXYOFFSET_c,	res_4_vXYOFFSET_d,	res_4_vXYOFFSET_e,	res_4_vXYOFFSET_h,	res_4_vXYOFFSET_l,	res_4_vXYOFFSET,	res_4_vXYOFFSET_a,	res_5_vXYOFFSET_b,	res_5_vXYOFFSET_c,	res_5_vXYOFFSET_d,	res_5_vXYOFFSET_e,	res_5_vXYOFFSET_h,	res_5_vXYOFFSET_l,	res_5_vXYOFFSET,	res_5_vXYOFFSET_a,
+/* B */ res_6_vXYOFFSET_b,	res_6_vXYOFFSET_c,	res_6_vXYOFFSET_d,	res_6_vXYOFFSET_e,	res_6_vXYOFFSET_h,	res_6_vXYOFFSET_l,	res_6_vXYOFFSET,	res_6_vXYOFFSET_a,	res_7_vXYOFFSET_b,	res_7_vXYOFFSET_c,	res_7_vXYOFFSET_d,	res_7_vXYOFFSET_e,	res_7_vXYOFFSET_h,	res_7_vXYOFFSET_l,	res_7_vXYOFFSET,	res_7_vXYOFFSET_a,
+/* C */ set_0_vXYOFFSET_b,	set_0_vXYOFFSET_c,	set_0_vXYOFFSET_d,	set_0_vXYOFFSET_e,	set_0_vXYOFFSET_h,	set_0_vXYOFFSET_l,	set_0_vXYOFFSET,	set_0_vXYOFFSET_a,	set_1_vXYOFFSET_b,	set_1_vXYOFFSET_c,	set_1_vXYOFFSET_d,	set_1_vXYOFFSET_e,	set_1_vXYOFFSET_h,	set_1_vXYOFFSET_l,	set_1_vXYOFFSET,	set_1_vXYOFFSET_a,
+/* D */ set_2_vXYOFFSET_b,	set_2_vXYOFFSET_c,	set_2_vXYOFFSET_d,	set_2_vXYOFFSET_e,	set_2_vXYOFFSET_h,	set_2_vXYOFFSET_l,	set_2_vXYOFFSET,	set_2_vXYOFFSET_a,	set_3_vXYOFFSET_b,	set_3_vXYOFFSET_c,	set_3_vXYOFFSET_d,	set_3_vXYOFFSET_e,	set_3_vXYOFFSET_h,	set_3_vXYOFFSET_l,	set_3_vXYOFFSET,	set_3_vXYOFFSET_a,
+/* E */ set_4_vXYOFFSET_b,	set_4_vXYOFFSET_c,	set_4_vXYOFFSET_d,	set_4_vXYOFFSET_e,	set_4_vXYOFFSET_h,	set_4_vXYOFFSET_l,	set_4_vXYOFFSET,	set_4_vXYOFFSET_a,	set_5_vXYOFFSET_b,	set_5_vXYOFFSET_c,	set_5_vXYOFFSET_d,	set_5_vXYOFFSET_e,	set_5_vXYOFFSET_h,	set_5_vXYOFFSET_l,	set_5_vXYOFFSET,	set_5_vXYOFFSET_a,
+/* F */ set_6_vXYOFFSET_b,	set_6_vXYOFFSET_c,	set_6_vXYOFFSET_d,	set_6_vXYOFFSET_e,	set_6_vXYOFFSET_h,	set_6_vXYOFFSET_l,	set_6_vXYOFFSET,	set_6_vXYOFFSET_a,	set_7_vXYOFFSET_b,	set_7_vXYOFFSET_c,	set_7_vXYOFFSET_d,	set_7_vXYOFFSET_e,	set_7_vXYOFFSET_h,	set_7_vXYOFFSET_l,	set_7_vXYOFFSET,	set_7_vXYOFFSET_a
 };
 
 static Instruction const instruction_table_XY[256] = {
-/*	0		1		2		3		4		5		6		   7		   8	       9	   A		B	    C		D	    E		    F */
-/* 0 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	   XY_illegal,	   XY_illegal, add_XY_WW,  XY_illegal,	XY_illegal, XY_illegal, XY_illegal, XY_illegal,	    XY_illegal,
-/* 1 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	   XY_illegal,	   XY_illegal, add_XY_WW,  XY_illegal,	XY_illegal, XY_illegal, XY_illegal, XY_illegal,	    XY_illegal,
-/* 2 */ XY_illegal,	ld_XY_WORD,	ld_vWORD_XY,	inc_XY,		V_JP,		V_JP,		ld_JP_BYTE,	   XY_illegal,	   XY_illegal, add_XY_WW,  ld_XY_vWORD, dec_XY,	    V_JP,	V_JP,	    ld_JP_BYTE,	    XY_illegal,
-/* 3 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	V_vXYOFFSET,	V_vXYOFFSET,	ld_vXYOFFSET_BYTE, XY_illegal,	   XY_illegal, add_XY_WW,  XY_illegal,	XY_illegal, XY_illegal, XY_illegal, XY_illegal,	    XY_illegal,
-/* 4 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	ld_JP_KQ,	ld_JP_KQ,	ld_X_vXYOFFSET,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_illegal, ld_JP_KQ,	ld_JP_KQ,   ld_X_vXYOFFSET, XY_illegal,
-/* 5 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	ld_JP_KQ,	ld_JP_KQ,	ld_X_vXYOFFSET,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_illegal, ld_JP_KQ,	ld_JP_KQ,   ld_X_vXYOFFSET, XY_illegal,
-/* 6 */ ld_JP_KQ,	ld_JP_KQ,	ld_JP_KQ,	ld_JP_KQ,	ld_JP_KQ,	ld_JP_KQ,	ld_X_vXYOFFSET,	   ld_JP_KQ,	   ld_JP_KQ,   ld_JP_KQ,   ld_JP_KQ,	ld_JP_KQ,   ld_JP_KQ,	ld_JP_KQ,   ld_X_vXYOFFSET, ld_JP_KQ,
-/* 7 */ ld_vXYOFFSET_Y, ld_vXYOFFSET_Y, ld_vXYOFFSET_Y, ld_vXYOFFSET_Y, ld_vXYOFFSET_Y, ld_vXYOFFSET_Y, XY_illegal,	   ld_vXYOFFSET_Y, XY_illegal, XY_illegal, XY_illegal,	XY_illegal, ld_JP_KQ,	ld_JP_KQ,   ld_X_vXYOFFSET, XY_illegal,
-/* 8 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	U_a_KQ,		U_a_KQ,		U_a_vXYOFFSET,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_illegal, U_a_KQ,	U_a_KQ,	    U_a_vXYOFFSET,  XY_illegal,
-/* 9 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	U_a_KQ,		U_a_KQ,		U_a_vXYOFFSET,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_illegal, U_a_KQ,	U_a_KQ,	    U_a_vXYOFFSET,  XY_illegal,
-/* A */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	U_a_KQ,		U_a_KQ,		U_a_vXYOFFSET,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_illegal, U_a_KQ,	U_a_KQ,	    U_a_vXYOFFSET,  XY_illegal,
-/* B */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	U_a_KQ,		U_a_KQ,		U_a_vXYOFFSET,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_illegal, U_a_KQ,	U_a_KQ,	    U_a_vXYOFFSET,  XY_illegal,
-/* C */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_CB,	    XY_illegal, XY_illegal, XY_illegal,	    XY_illegal,
-/* D */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	   XY_illegal,	   XY_illegal, XY_illegal, XY_illegal,	XY_illegal, XY_illegal, XY_illegal, XY_illegal,	    XY_illegal,
-/* E */ XY_illegal,	pop_XY,		XY_illegal,	ex_vsp_XY,	XY_illegal,	push_XY,	XY_illegal,	   XY_illegal,	   XY_illegal, jp_XY,	   XY_illegal,	XY_illegal, XY_illegal, XY_illegal, XY_illegal,	    XY_illegal,
-/* F */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	   XY_illegal,	   XY_illegal, ld_sp_XY,   XY_illegal,	XY_illegal, XY_illegal, XY_illegal, XY_illegal,	    XY_illegal
+/*	0		1		2		3		4		5		6			7		8		9		A		B		C		D		E			F */
+/* 0 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,	XY_illegal,	add_xy_bc,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,
+/* 1 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,	XY_illegal,	add_xy_de,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,
+/* 2 */ XY_illegal,	ld_XY_WORD,	ld_vWORD_XY,	inc_XY,		inc_xyh,	dec_xyh,	ld_xyh_BYTE,		XY_illegal,	XY_illegal,	add_xy_xy,	ld_XY_vWORD,	dec_XY,		inc_xyl,	dec_xyl,	ld_xyl_BYTE,		XY_illegal,
+/* 3 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	inc_vXYOFFSET,	dec_vXYOFFSET,	ld_vXYOFFSET_BYTE,	XY_illegal,	XY_illegal,	add_xy_sp,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,
+/* 4 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	ld_b_xyh,	ld_b_xyl,	ld_b_vXYOFFSET,		XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	ld_c_xyh,	ld_c_xyl,	ld_c_vXYOFFSET,		XY_illegal,
+/* 5 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	ld_d_xyh,	ld_d_xyl,	ld_d_vXYOFFSET,		XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	ld_e_xyh,	ld_e_xyl,	ld_e_vXYOFFSET,		XY_illegal,
+/* 6 */ ld_xyh_b,	ld_xyh_c,	ld_xyh_d,	ld_xyh_e,	ld_xyh_xyh,	ld_xyh_xyl,	ld_h_vXYOFFSET,		ld_xyh_a,	ld_xyl_b,	ld_xyl_c,	ld_xyl_d,	ld_xyl_e,	ld_xyl_xyh,	ld_xyl_xyl,	ld_l_vXYOFFSET,		ld_xyl_a,
+/* 7 */ ld_vXYOFFSET_b,	ld_vXYOFFSET_c,	ld_vXYOFFSET_d,	ld_vXYOFFSET_e,	ld_vXYOFFSET_h,	ld_vXYOFFSET_l,	XY_illegal,		ld_vXYOFFSET_a,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	ld_a_xyh,	ld_a_xyl,	ld_a_vXYOFFSET,		XY_illegal,
+/* 8 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	add_a_xyh,	add_a_xyl,	add_a_vXYOFFSET,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	adc_a_xyh,	adc_a_xyl,	adc_a_vXYOFFSET,	XY_illegal,
+/* 9 */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	sub_a_xyh,	sub_a_xyl,	sub_a_vXYOFFSET,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	sbc_a_xyh,	sbc_a_xyl,	sbc_a_vXYOFFSET,	XY_illegal,
+/* A */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	and_a_xyh,	and_a_xyl,	and_a_vXYOFFSET,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	xor_a_xyh,	xor_a_xyl,	xor_a_vXYOFFSET,	XY_illegal,
+/* B */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	or_a_xyh,	or_a_xyl,	or_a_vXYOFFSET,		XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	cp_a_xyh,	cp_a_xyl,	cp_a_vXYOFFSET,		XY_illegal,
+/* C */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_CB,		XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,
+/* D */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,
+/* E */ XY_illegal,	pop_XY,		XY_illegal,	ex_vsp_XY,	XY_illegal,	push_XY,	XY_illegal,		XY_illegal,	XY_illegal,	jp_XY,		XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,
+/* F */ XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal,	XY_illegal,	ld_sp_XY,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,	XY_illegal,		XY_illegal
 };
 
 static Instruction const instruction_table_ED[256] = {
-/*	0	    1		2	    3		 4	     5		 6	     7		 8	     9		 A	     B		  C	      D		  E	      F */
-/* 0 */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* 1 */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* 2 */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* 3 */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* 4 */ in_X_vc,    out_vc_X,	sbc_hl_SS,  ld_vWORD_SS, neg,	     retn,	 im_0,	     ld_i_a,	 in_X_vc,    out_vc_X,	 adc_hl_SS,  ld_SS_vWORD, neg,	      reti,	  im_0,	      ld_r_a,
-/* 5 */ in_X_vc,    out_vc_X,	sbc_hl_SS,  ld_vWORD_SS, neg,	     retn,	 im_1,	     ld_a_i,	 in_X_vc,    out_vc_X,	 adc_hl_SS,  ld_SS_vWORD, neg,	      retn,	  im_2,	      ld_a_r,
-/* 6 */ in_X_vc,    out_vc_X,	sbc_hl_SS,  ld_vWORD_SS, neg,	     retn,	 im_0,	     rrd,	 in_X_vc,    out_vc_X,	 adc_hl_SS,  ld_SS_vWORD, neg,	      retn,	  im_0,	      rld,
-/* 7 */ in_0_vc,    out_vc_0,	sbc_hl_SS,  ld_vWORD_SS, neg,	     retn,	 im_1,	     ED_illegal, in_X_vc,    out_vc_X,	 adc_hl_SS,  ld_SS_vWORD, neg,	      retn,	  im_2,	      ED_illegal,
-/* 8 */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* 9 */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* A */ ldi,	    cpi,	ini,	    outi,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ldd,	     cpd,	 ind,	     outd,	  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* B */ ldir,	    cpir,	inir,	    otir,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, lddr,	     cpdr,	 indr,	     otdr,	  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* C */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* D */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* E */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal,
-/* F */ ED_illegal, ED_illegal, ED_illegal, ED_illegal,	 ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal, ED_illegal,  ED_illegal, ED_illegal, ED_illegal, ED_illegal
+/*	0		1		2		3		4		5		6		7		8		9		A		B		C		D		E		F */
+/* 0 */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* 1 */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* 2 */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* 3 */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* 4 */ in_b_vc,	out_vc_b,	sbc_hl_bc,	ed_ld_vWORD_bc,	neg,		retn,		im_0,		ld_i_a,		in_c_vc,	out_vc_c,	adc_hl_bc,	ed_ld_bc_vWORD,	neg,		reti,		im_0,		ld_r_a,
+/* 5 */ in_d_vc,	out_vc_d,	sbc_hl_de,	ed_ld_vWORD_de,	neg,		retn,		im_1,		ld_a_i,		in_e_vc,	out_vc_e,	adc_hl_de,	ed_ld_de_vWORD,	neg,		retn,		im_2,		ld_a_r,
+/* 6 */ in_h_vc,	out_vc_h,	sbc_hl_hl,	ed_ld_vWORD_hl,	neg,		retn,		im_0,		rrd,		in_l_vc,	out_vc_l,	adc_hl_hl,	ed_ld_hl_vWORD,	neg,		retn,		im_0,		rld,
+/* 7 */ in_0_vc,	out_vc_0,	sbc_hl_sp,	ed_ld_vWORD_sp,	neg,		retn,		im_1,		ED_illegal,	in_a_vc,	out_vc_a,	adc_hl_sp,	ed_ld_sp_vWORD,	neg,		retn,		im_2,		ED_illegal,
+/* 8 */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* 9 */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* A */ ldi,		cpi,		ini,		outi,		ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ldd,		cpd,		ind,		outd,		ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* B */ ldir,		cpir,		inir,		otir,		ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	lddr,		cpdr,		indr,		otdr,		ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* C */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* D */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* E */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,
+/* F */ ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal,	ED_illegal
 };
 
 
@@ -1406,20 +1961,811 @@ INSTRUCTION(XY_CB)
 
 /* MARK: - Illegal Instruction Handling */
 
-INSTRUCTION(XY_illegal) {PC += 1; return instruction_table[BYTE0 = BYTE1](object) + 4;}
+/*------------------------------------------------------------------.
+| An illegal DD/FD prefix costs 4 cycles, which are added once the  |
+| instruction that follows it has run, so the callbacks of that one |
+| see CYCLES without them. With bulk transfers, they are kept       |
+| pending meanwhile, so that a transfer that runs iterations ahead  |
+| can add them to the first one (see bulk_advance).                 |
+'------------------------------------------------------------------*/
+#if DEFINED(USE_BULK_TRANSFERS)
+
+	INSTRUCTION(XY_illegal)
+		{
+		zuint8 cycles;
+
+		PC += 1;
+		object->prefix_cycles += 4;
+		cycles = instruction_table[BYTE0 = BYTE1](object);
+		if (object->prefix_cycles) {object->prefix_cycles -= 4; cycles += 4;}
+		return cycles;
+		}
+
+#else
+	INSTRUCTION(XY_illegal) {PC += 1; return instruction_table[BYTE0 = BYTE1](object) + 4;}
+#endif
+
 INSTRUCTION(ED_illegal) {PC += 2; return 8;}
 
 
+/* MARK: - Block Cache
+.----------------------------------------------------------------------------.
+| Straight-line runs of code are decoded once into blocks of entries that    |
+| hold the final handler (prefix chains already resolved), the opcode bytes  |
+| the handler expects in BYTE0-BYTE3, and what the prefix selectors would    |
+| have done before calling it (PC advance, R increment and IX/IY select).    |
+| Only the fetch and decoding of the opcode and its prefixes are saved: the  |
+| operands (immediates and displacements, except that of DD/FD CB, which is  |
+| part of the opcode bytes) are not in the entries, and the handlers still   |
+| read them from memory as they run, as they do outside the cache.           |
+|                                                                            |
+| A block never crosses a 256 byte page, so it can be validated against a    |
+| single write generation counter. Blocks of RAM banks live in a direct      |
+| mapped table owned by each CPU; blocks of ROM banks are decoded once and   |
+| shared by every CPU of the process, keyed by the content of the ROM.       |
+'----------------------------------------------------------------------------*/
+
+#if DEFINED(USE_BLOCK_CACHE)
+
+#	include <stdlib.h>
+#	include <string.h>
+#	include <pthread.h>
+
+#	define EOB	128 /* Ends the block */
+#	define SIZE(info) ((info) & 7)
+
+	static zuint8 const instruction_info_table[256] = {
+	/*	0       1       2       3       4       5       6       7       8       9       A       B       C       D       E       F */
+	/* 0 */ 1,      3,      1,      1,      1,      1,      2,      1,      1,      1,      1,      1,      1,      1,      2,      1,
+	/* 1 */ 2|EOB,  3,      1,      1,      1,      1,      2,      1,      2|EOB,  1,      1,      1,      1,      1,      2,      1,
+	/* 2 */ 2|EOB,  3,      3,      1,      1,      1,      2,      1,      2|EOB,  1,      3,      1,      1,      1,      2,      1,
+	/* 3 */ 2|EOB,  3,      3,      1,      1,      1,      2,      1,      2|EOB,  1,      3,      1,      1,      1,      2,      1,
+	/* 4 */ 1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* 5 */ 1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* 6 */ 1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* 7 */ 1,      1,      1,      1,      1,      1,      1|EOB,  1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* 8 */ 1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* 9 */ 1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* A */ 1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* B */ 1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,      1,
+	/* C */ 1|EOB,  1,      3|EOB,  3|EOB,  3|EOB,  1,      2,      1|EOB,  1|EOB,  1|EOB,  3|EOB,  0,      3|EOB,  3|EOB,  2,      1|EOB,
+	/* D */ 1|EOB,  1,      3|EOB,  2,      3|EOB,  1,      2,      1|EOB,  1|EOB,  1,      3|EOB,  2,      3|EOB,  0,      2,      1|EOB,
+	/* E */ 1|EOB,  1,      3|EOB,  1,      3|EOB,  1,      2,      1|EOB,  1|EOB,  1|EOB,  3|EOB,  1,      3|EOB,  0,      2,      1|EOB,
+	/* F */ 1|EOB,  1,      3|EOB,  1,      3|EOB,  1,      2,      1|EOB,  1|EOB,  1,      3|EOB,  1,      3|EOB,  0,      2,      1|EOB
+	};
+
+
+	/*-----------------------------------------------------------------.
+	| Decodes the instruction at address into entry and returns its    |
+	| info (size and end-of-block flag), or 0 if it can't be cached.    |
+	| Illegal DD/FD prefixes are left to the interpreter.              |
+	'-----------------------------------------------------------------*/
+	Z_PRIVATE zuint8 decode_instruction(Z80 *object, zuint16 address, BlockEntry *entry)
+		{
+		zuint8 info, byte;
+
+		entry->data.value_uint32 = 0;
+		entry->pc_advance	 = 0;
+		entry->r_increment	 = 2;
+		entry->xy		 = 0;
+
+		switch (entry->data.array_uint8[0] = byte = READ_8(address))
+			{
+			case 0xCB:
+			entry->handler = instruction_table_CB[entry->data.array_uint8[1] = READ_8(address + 1)];
+			entry->pc_advance = 2;
+			return 2;
+
+			case 0xED:
+			entry->handler = instruction_table_ED[byte = entry->data.array_uint8[1] = READ_8(address + 1)];
+			if ((byte & 0xC7) == 0x43) return 4;
+			return (byte & 0xC7) == 0x45 || (byte & 0xF4) == 0xB0 ? 2 | EOB : 2;
+
+			case 0xDD:
+			case 0xFD:
+			entry->xy = byte == 0xDD ? 1 : 2;
+			byte = entry->data.array_uint8[1] = READ_8(address + 1);
+
+			if (byte == 0xCB)
+				{
+				entry->data.array_uint8[2] = READ_8(address + 2);
+				entry->handler = instruction_table_XY_CB[entry->data.array_uint8[3] = READ_8(address + 3)];
+				entry->pc_advance = 4;
+				return 4;
+				}
+
+			if ((entry->handler = instruction_table_XY[byte]) == XY_illegal) return 0;
+			info = instruction_info_table[byte] + 1;
+
+			/*-----------------------------------.
+			| Instructions with an (XY+OFFSET)   |
+			| operand carry an extra byte.       |
+			'-----------------------------------*/
+			if (	(byte >= 0x34 && byte <= 0x36) ||
+				((byte & 0xC7) == 0x46 && byte != 0x76) ||
+				(byte >= 0x70 && byte <= 0x77 && byte != 0x76) ||
+				(byte & 0xC7) == 0x86
+			)
+				info++;
+
+			return info;
+
+			default:
+			entry->handler	   = instruction_table[byte];
+			entry->r_increment = 1;
+			return instruction_info_table[byte];
+			}
+		}
+
+
+	Z_PRIVATE void decode_block(Z80 *object, zuint16 pc, Block *block)
+		{
+		zuint8 info, count = 0;
+		BlockEntry *entry = block->entries;
+
+		while (count < BLOCK_MAXIMUM_SIZE)
+			{
+			info = decode_instruction(object, pc, entry);
+
+			if (!info || (pc & 0xFF) + SIZE(info) > 256) break;
+			(entry++)->size = SIZE(info);
+			pc += SIZE(info);
+			count++;
+			if ((info & EOB) || !(pc & 0xFF)) break;
+			}
+
+		block->entry_count = count;
+		block->owner	   = instruction_table;
+		}
+
+
+	/*------------------------------------------------------------------.
+	| Shared ROMs are registered once per distinct content and are kept |
+	| for the lifetime of the process. Their blocks are only inserted,  |
+	| never replaced, so a CAS on the slot is enough to publish them.   |
+	'------------------------------------------------------------------*/
+	static SharedROM*	shared_roms	  = NULL;
+	static pthread_mutex_t	shared_roms_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+	Z_PRIVATE Block *rom_block(Z80 *object, SharedROM *rom, zuint16 pc, zuint16 bank)
+		{
+		Block **slot = &rom->blocks[pc & (BANK_SIZE - 1)];
+		Block *block = __atomic_load_n(slot, __ATOMIC_ACQUIRE), *expected = NULL;
+
+		/*--------------------------------------------------------------.
+		| A copy of the core compiled for a specific machine can share |
+		| the ROM with the generic core, but not the decoded handlers. |
+		'--------------------------------------------------------------*/
+		if (block != NULL) return block->owner == instruction_table ? block : NULL;
+		if ((block = malloc(sizeof(Block))) == NULL) return NULL;
+		block->pc	  = pc;
+		block->bank	  = bank;
+		block->generation = 0;
+		decode_block(object, pc, block);
+
+#		if DEFINED(USE_JIT)
+			block->code = NULL;
+			block->hits = 0;
+#		endif
+
+		if (!__atomic_compare_exchange_n(slot, &expected, block, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+			free(block);
+			block = expected->owner == instruction_table ? expected : NULL;
+			}
+
+		return block;
+		}
+
+
+	/*-------------------------------------------------------------------------.
+	| Blocks that keep being run are translated into x86-64 code. The native  |
+	| code does exactly what run_block does for each entry: it sets up the    |
+	| instruction data, calls the handler directly (no dispatch and no table  |
+	| lookups) and checks the exit conditions inline. Everything it needs is  |
+	| known when the block is compiled: the handler addresses, the PC of each |
+	| entry, and the bank token and write generation of the page. The flags   |
+	| of the internal state are located at run time, so the generator works   |
+	| whether the state uses bit fields or not.                               |
+	'-------------------------------------------------------------------------*/
+
+#	if DEFINED(USE_JIT)
+
+#		include <sys/mman.h>
+#		include <sys/syscall.h>
+#		include <fcntl.h>
+#		include <unistd.h>
+#		include <stdio.h>
+
+#		ifndef CPU_Z80_JIT_THRESHOLD
+#			define CPU_Z80_JIT_THRESHOLD 16
+#		endif
+
+#		define CODE_ARENA_SIZE		  (4 * 1024 * 1024)
+#		define SHARED_CODE_ARENA_SIZE	  (8 * 1024 * 1024)
+#		define NATIVE_BLOCK_MAXIMUM_SIZE  4096
+#		define STATE_OFFSET(member)	  O(state.Z_Z80_STATE_MEMBER_##member)
+
+#		define CODE(bytes)	 p = emit_code (p, bytes, sizeof(bytes) - 1)
+#		define VALUE(size, value) p = emit_value(p, size, (zuint64)(value))
+#		define JUMP(opcode)	 CODE(opcode); VALUE(4, (zint32)(epilogue - (p + 4)))
+
+		typedef struct {
+			zuint32 offset;
+			zuint8	mask;
+		} Flag;
+
+		static Flag	      nmi_flag, int_flag, iff1_flag, ei_flag;
+		static CodeArena      shared_code;
+		static pthread_once_t jit_once = PTHREAD_ONCE_INIT;
+
+
+		Z_PRIVATE zuint8 *emit_code(zuint8 *p, char const *bytes, zsize size)
+			{
+			while (size--) *p++ = (zuint8)*bytes++;
+			return p;
+			}
+
+
+		Z_PRIVATE zuint8 *emit_value(zuint8 *p, zuint size, zuint64 value)
+			{
+			for (; size; size--, value >>= 8) *p++ = (zuint8)value;
+			return p;
+			}
+
+
+		Z_PRIVATE void locate_flag(Z80 const *probe, Flag *flag)
+			{
+			zuint8 const *bytes = (zuint8 const *)probe;
+
+			for (flag->offset = 0; !bytes[flag->offset]; flag->offset++);
+			flag->mask = bytes[flag->offset];
+			}
+
+
+		/*------------------------------------------------------------------.
+		| No page of an arena is ever writable and executable at once: the  |
+		| same memory is mapped twice, read-write at base for the compiler  |
+		| and read-execute at code for running it. Toggling a single        |
+		| mapping with mprotect would not do for the shared arena, whose    |
+		| pages other machines may be running while a block is added.       |
+		'------------------------------------------------------------------*/
+		Z_PRIVATE int code_arena_file(void)
+			{
+#			if defined(__linux__) && defined(SYS_memfd_create)
+				return (int)syscall(SYS_memfd_create, "Z80 JIT", 1 /* MFD_CLOEXEC */);
+#			else
+				static zuint counter = 0;
+				char name[64];
+				int file;
+
+				snprintf(name, sizeof(name), "/Z80 JIT %ld %u",
+					 (long)getpid(), __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED));
+
+				if ((file = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600)) != -1) shm_unlink(name);
+				return file;
+#			endif
+			}
+
+
+		Z_PRIVATE void code_arena_initialize(CodeArena *object, zsize size)
+			{
+			void *base = MAP_FAILED, *code = MAP_FAILED;
+			int file = code_arena_file();
+
+			if (file != -1)
+				{
+				if (!ftruncate(file, (off_t)size))
+					{
+					base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+					code = mmap(NULL, size, PROT_READ | PROT_EXEC,	MAP_SHARED, file, 0);
+					}
+
+				close(file);
+				}
+
+			if (base == MAP_FAILED || code == MAP_FAILED)
+				{
+				if (base != MAP_FAILED) munmap(base, size);
+				if (code != MAP_FAILED) munmap(code, size);
+				base = code = NULL;
+				}
+
+			object->base = base;
+			object->code = code;
+			object->size = base == NULL ? 0 : size;
+			object->used = 0;
+			}
+
+
+		Z_PRIVATE void code_arena_destroy(CodeArena *object)
+			{
+			if (object->base != NULL)
+				{
+				munmap(object->base, object->size);
+				munmap(object->code, object->size);
+				}
+			}
+
+
+		Z_PRIVATE void initialize_jit(void)
+			{
+			Z80 probe, *object = &probe;
+
+			memset(object, 0, sizeof(Z80)); NMI  = TRUE; locate_flag(object, &nmi_flag );
+			memset(object, 0, sizeof(Z80)); INT  = TRUE; locate_flag(object, &int_flag );
+			memset(object, 0, sizeof(Z80)); IFF1 = TRUE; locate_flag(object, &iff1_flag);
+			memset(object, 0, sizeof(Z80)); EI   = TRUE; locate_flag(object, &ei_flag  );
+			code_arena_initialize(&shared_code, SHARED_CODE_ARENA_SIZE);
+			}
+
+
+		/*-----------------------------------------------------------------.
+		| Register usage: RBX holds the object and R12 the cycle budget.   |
+		| The epilogue is emitted first, so every exit is a backward jump  |
+		| to a known address. The code is written through the writable     |
+		| view; it only holds jumps relative to itself, so it runs from    |
+		| the executable one unchanged.                                    |
+		'-----------------------------------------------------------------*/
+		Z_PRIVATE NativeBlock compile_block(CodeArena *arena, Block const *block, zuint32 const *generation)
+			{
+			BlockEntry const *entry = block->entries, *end = entry + block->entry_count;
+			zuint16 pc = block->pc;
+			zuint32 xy_offset = 0;
+			zuint8 *p, *epilogue;
+			NativeBlock code;
+
+			if (arena->size - arena->used < NATIVE_BLOCK_MAXIMUM_SIZE) return NULL;
+			epilogue = p = arena->base + arena->used;
+
+			/*--------------------------------------------------.
+			| add rsp, 8 / pop r12 / pop rbx / ret              |
+			'--------------------------------------------------*/
+			CODE("\x48\x83\xC4\x08" "\x41\x5C" "\x5B" "\xC3");
+			code = (NativeBlock)(void *)(arena->code + (p - arena->base));
+
+			/*--------------------------------------------------------------.
+			| push rbx / push r12 / sub rsp, 8 / mov rbx, rdi / mov r12, rsi |
+			'--------------------------------------------------------------*/
+			CODE("\x53" "\x41\x54" "\x48\x83\xEC\x08" "\x48\x89\xFB" "\x49\x89\xF4");
+
+			for (;;)
+				{
+				/*---------------------------------------------.
+				| R += r_increment; EI = FALSE; data = bytes;  |
+				| PC += pc_advance;                            |
+				'---------------------------------------------*/
+				CODE("\x80\x83"); VALUE(4, STATE_OFFSET(R)); VALUE(1, entry->r_increment);
+				CODE("\x80\xA3"); VALUE(4, ei_flag.offset); VALUE(1, ~ei_flag.mask);
+				CODE("\xC7\x83"); VALUE(4, O(data)); VALUE(4, entry->data.value_uint32);
+
+				if (entry->pc_advance)
+					{CODE("\x66\x83\x83"); VALUE(4, STATE_OFFSET(PC)); VALUE(1, entry->pc_advance);}
+
+				if (entry->xy)
+					{
+					xy_offset = entry->xy == 1 ? STATE_OFFSET(IX) : STATE_OFFSET(IY);
+					CODE("\x0F\xB7\x83"); VALUE(4, xy_offset);
+					CODE("\x66\x89\x83"); VALUE(4, O(xy));
+					}
+
+				/*-------------------------------------------------.
+				| CYCLES += handler(object)                        |
+				'-------------------------------------------------*/
+				CODE("\x48\x89\xDF" "\x48\xB8"); VALUE(8, entry->handler);
+				CODE("\xFF\xD0" "\x0F\xB6\xC0" "\x48\x01\x83"); VALUE(4, O(cycles));
+
+				if (entry->xy)
+					{
+					CODE("\x0F\xB7\x83"); VALUE(4, O(xy));
+					CODE("\x66\x89\x83"); VALUE(4, xy_offset);
+					}
+
+				pc += entry->size;
+				if (++entry == end) break;
+
+				/*-----------------------------------------------.
+				| Exit if PC != pc or CYCLES >= cycles or NMI... |
+				'-----------------------------------------------*/
+				CODE("\x66\x81\xBB"); VALUE(4, STATE_OFFSET(PC)); VALUE(2, pc); JUMP("\x0F\x85");
+				CODE("\x4C\x39\xA3"); VALUE(4, O(cycles)); JUMP("\x0F\x83");
+				CODE("\xF6\x83"); VALUE(4, nmi_flag.offset); VALUE(1, nmi_flag.mask); JUMP("\x0F\x85");
+
+				/*-------------------------------------------------.
+				| ...or (INT && IFF1 && !EI)...                    |
+				'-------------------------------------------------*/
+				CODE("\xF6\x83"); VALUE(4, int_flag.offset ); VALUE(1, int_flag.mask ); CODE("\x74\x16");
+				CODE("\xF6\x83"); VALUE(4, iff1_flag.offset); VALUE(1, iff1_flag.mask); CODE("\x74\x0D");
+				CODE("\xF6\x83"); VALUE(4, ei_flag.offset  ); VALUE(1, ei_flag.mask  ); JUMP("\x0F\x84");
+
+				/*-------------------------------------------------.
+				| ...or the mapping or the code have changed.      |
+				'-------------------------------------------------*/
+				CODE("\x66\x81\xBB"); VALUE(4, O(bank) + 2 * (pc >> 14)); VALUE(2, block->bank); JUMP("\x0F\x85");
+
+				if (generation != NULL)
+					{
+					CODE("\x48\xB8"); VALUE(8, generation);
+					CODE("\x81\x38"); VALUE(4, block->generation); JUMP("\x0F\x85");
+					}
+				}
+
+			JUMP("\xE9");
+			arena->used = (zsize)(p - arena->base);
+			return code;
+			}
+
+
+		/*-----------------------------------------------------------------.
+		| RAM blocks are compiled into the arena of the cache; when it is  |
+		| full, all its native code is dropped and the arena starts over.  |
+		| ROM blocks are compiled once into the arena shared by the whole  |
+		| process, like the blocks themselves.                             |
+		'-----------------------------------------------------------------*/
+		Z_PRIVATE NativeBlock native_block(Z80BlockCache *cache, Block *block, zuint32 const *generation)
+			{
+			NativeBlock code;
+			zsize index;
+
+			pthread_once(&jit_once, initialize_jit);
+
+			if (generation == NULL)
+				{
+				pthread_mutex_lock(&shared_roms_mutex);
+
+				if ((code = block->code) == NULL && (code = compile_block(&shared_code, block, NULL)) != NULL)
+					__atomic_store_n(&block->code, code, __ATOMIC_RELEASE);
+
+				pthread_mutex_unlock(&shared_roms_mutex);
+				return code;
+				}
+
+			if (	(code = compile_block(&cache->code, block, generation)) == NULL &&
+				cache->code.base != NULL
+			)
+				{
+				for (index = BLOCK_CACHE_SIZE; index;) cache->blocks[--index].code = NULL;
+				cache->code.used = 0;
+				code = compile_block(&cache->code, block, generation);
+				}
+
+			return block->code = code;
+			}
+
+#		undef CODE
+#		undef VALUE
+#		undef JUMP
+
+#	endif
+
+
+	Z_PRIVATE void run_block(Z80 *object, zsize cycles)
+		{
+		Z80BlockCache *cache = object->block_cache;
+		zuint16 pc = PC, bank = object->bank[pc >> 14];
+		zuint32 *generation = NULL;
+		BlockEntry *entry, *end;
+		Block *block;
+
+		if (cache->roms[bank] == NULL || (block = rom_block(object, cache->roms[bank], pc, bank)) == NULL)
+			{
+			generation = &cache->generations[PAGE_INDEX(bank, pc)];
+			block = &cache->blocks[(pc ^ (bank << 5)) & (BLOCK_CACHE_SIZE - 1)];
+
+			if (	block->pc	  != pc		 ||
+				block->bank	  != bank	 ||
+				block->generation != *generation ||
+				block->owner	  != instruction_table
+			)
+				{
+				block->pc	  = pc;
+				block->bank	  = bank;
+				block->generation = *generation;
+				decode_block(object, pc, block);
+
+#				if DEFINED(USE_JIT)
+					block->code = NULL;
+					block->hits = 0;
+#				endif
+				}
+			}
+
+		/*------------------------------------------------------.
+		| Blocks that could not be built run one instruction in |
+		| the interpreter.                                      |
+		'------------------------------------------------------*/
+		if (block == NULL || !block->entry_count)
+			{
+			R++;
+			EI = FALSE;
+			CYCLES += instruction_table[BYTE0 = READ_8(PC)](object);
+			return;
+			}
+
+#		if DEFINED(USE_JIT)
+			{
+			NativeBlock code = __atomic_load_n(&block->code, __ATOMIC_ACQUIRE);
+
+			if (code == NULL && __atomic_add_fetch(&block->hits, 1, __ATOMIC_RELAXED) > CPU_Z80_JIT_THRESHOLD)
+				{
+				if ((code = native_block(cache, block, generation)) == NULL)
+					__atomic_store_n(&block->hits, 0, __ATOMIC_RELAXED);
+				}
+
+			/*-------------------------------------------------------.
+			| The native code of a shared ROM block checks the PC    |
+			| and the bank it was first decoded at; a machine that   |
+			| maps the ROM elsewhere interprets the block instead.   |
+			'-------------------------------------------------------*/
+			if (code != NULL && block->pc == pc && block->bank == bank)
+				{
+				code(object, cycles);
+				return;
+				}
+			}
+#		endif
+
+		for (entry = block->entries, end = entry + block->entry_count;;)
+			{
+			R += entry->r_increment;
+			EI = FALSE;
+			object->data = entry->data;
+			PC += entry->pc_advance;
+
+			switch (entry->xy)
+				{
+				case 0: CYCLES += entry->handler(object); break;
+				case 1: XY = IX; CYCLES += entry->handler(object); IX = XY; break;
+				case 2: XY = IY; CYCLES += entry->handler(object); IY = XY; break;
+				}
+
+			pc += entry->size;
+
+			/*---------------------------------------------------------.
+			| Leave on branches, on the end of the budget, on pending |
+			| interrupts and when the code or its mapping changes.    |
+			'---------------------------------------------------------*/
+			if (	++entry == end			       ||
+				PC != pc			       ||
+				CYCLES >= cycles		       ||
+				NMI || (INT && IFF1 && !EI)	       ||
+				object->bank[pc >> 14] != bank	       ||
+				(generation != NULL && *generation != block->generation)
+			)
+				return;
+			}
+		}
+
+
+	CPU_Z80_API Z80BlockCache *z80_block_cache_new(zsize bank_count)
+		{
+		Z80BlockCache *object;
+
+		if (bank_count < 4) bank_count = 4;
+		if ((object = malloc(sizeof(Z80BlockCache))) == NULL) return NULL;
+
+		object->bank_count  = bank_count;
+		object->generations = calloc(bank_count * PAGES_PER_BANK, sizeof(zuint32));
+		object->roms	    = calloc(bank_count, sizeof(SharedROM *));
+
+#		if DEFINED(USE_JIT)
+			pthread_once(&jit_once, initialize_jit);
+			code_arena_initialize(&object->code, CODE_ARENA_SIZE);
+#		endif
+
+		if (object->generations == NULL || object->roms == NULL)
+			{
+			z80_block_cache_destroy(object);
+			return NULL;
+			}
+
+		z80_block_cache_invalidate(object);
+		return object;
+		}
+
+
+	CPU_Z80_API void z80_block_cache_destroy(Z80BlockCache *object)
+		{
+#		if DEFINED(USE_JIT)
+			code_arena_destroy(&object->code);
+#		endif
+
+		free(object->generations);
+		free(object->roms);
+		free(object);
+		}
+
+
+	CPU_Z80_API void z80_block_cache_set_rom(Z80BlockCache *object, zuint16 bank, zuint8 const *content)
+		{
+		SharedROM *rom;
+
+		pthread_mutex_lock(&shared_roms_mutex);
+
+		for (rom = shared_roms; rom != NULL; rom = rom->next)
+			if (!memcmp(rom->content, content, BANK_SIZE)) break;
+
+		if (rom == NULL && (rom = calloc(1, sizeof(SharedROM))) != NULL)
+			{
+			memcpy(rom->content, content, BANK_SIZE);
+			rom->next = shared_roms;
+			shared_roms = rom;
+			}
+
+		pthread_mutex_unlock(&shared_roms_mutex);
+		object->roms[bank] = rom;
+		}
+
+
+	CPU_Z80_API void z80_block_cache_invalidate(Z80BlockCache *object)
+		{
+		zsize index = BLOCK_CACHE_SIZE;
+
+		while (index) object->blocks[--index].bank = 0xFFFF;
+
+#		if DEFINED(USE_JIT)
+			object->code.used = 0;
+#		endif
+		}
+
+#	undef EOB
+#	undef SIZE
+
+#endif
+
+
+/* MARK: - Idle Loop Skipping
+.----------------------------------------------------------------------------.
+| Short loops that only read memory and update registers are run once more  |
+| after a backward branch. If that iteration ends at the loop head with the |
+| same register values it started with, every further iteration will do    |
+| exactly the same until an interrupt arrives, so the whole iterations that |
+| fit in the budget are accounted for at once (cycles and R) and the        |
+| remainder is left to the interpreter. Ports are never considered pure:    |
+| what the machine returns may depend on the cycle or on the host.          |
+'----------------------------------------------------------------------------*/
+
+#if DEFINED(USE_IDLE_LOOP_SKIPPING)
+
+#	include <string.h>
+
+#	define IDLE_LOOP_MAXIMUM_SIZE	      16
+#	define IDLE_LOOP_MAXIMUM_INSTRUCTIONS 8
+
+	static zuint8 const pure_instruction_table[256] = {
+	/*	0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+	/* 0 */ 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 1 */ 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 2 */ 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 3 */ 1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 4 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 5 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 6 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 7 */ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 8 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 9 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* A */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* B */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* C */ 0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 0,
+	/* D */ 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0,
+	/* E */ 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0,
+	/* F */ 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0
+	};
+
+
+	/*-------------------------------------------------------------------.
+	| An instruction is pure if it writes neither memory nor ports, does |
+	| not touch the stack, and does not change the interrupt state. The  |
+	| IX/IY forms inherit the purity of the instruction they modify; of  |
+	| the CB groups only the register forms and BIT are pure.            |
+	'-------------------------------------------------------------------*/
+	Z_PRIVATE zboolean is_pure(Z80 *object, zuint16 address)
+		{
+		zuint8 byte = READ_8(address);
+
+		if (byte == 0xCB) return ((byte = READ_8(address + 1)) & 7) != 6 || (byte & 0xC0) == 0x40;
+
+		if (byte == 0xDD || byte == 0xFD)
+			{
+			if ((byte = READ_8(address + 1)) == 0xCB) return (READ_8(address + 3) & 0xC0) == 0x40;
+			if (byte == 0xDD || byte == 0xFD || byte == 0xCB) return FALSE;
+			}
+
+		return byte != 0xED && pure_instruction_table[byte];
+		}
+
+
+	Z_PRIVATE void skip_idle_loop(Z80 *object, zsize cycles)
+		{
+		zuint16 head = PC;
+		zsize iterations, iteration_cycles = CYCLES;
+		zuint8 iteration_r = R, count = 0;
+		ZZ80State state;
+
+		if (CYCLES >= cycles || NMI || (INT && IFF1)) return;
+
+		/*-------------------------------------------------------------.
+		| djnz $: B counts down to 1 in taken branches of 13 cycles.   |
+		'-------------------------------------------------------------*/
+		if (READ_8(head) == 0x10 && READ_8(head + 1) == 0xFE)
+			{
+			iteration_cycles = 13;
+			iteration_r	 = 1;
+			iterations	 = (cycles - CYCLES - 1) / 13;
+			if (iterations > (zuint8)(B - 1)) iterations = (zuint8)(B - 1);
+			B -= (zuint8)iterations;
+			}
+
+		/*-------------------------------------------------------------.
+		| Any other loop has to prove it is a fixed point by running   |
+		| one iteration of pure instructions back to the head.         |
+		'-------------------------------------------------------------*/
+		else	{
+			RESOLVE_FLAGS;
+			state = object->state;
+
+			do	{
+				if (CYCLES >= cycles || !is_pure(object, PC)) return;
+				R++;
+				EI = FALSE;
+				CYCLES += instruction_table[BYTE0 = READ_8(PC)](object);
+				if ((zuint16)(PC - head) >= IDLE_LOOP_MAXIMUM_SIZE) return;
+				}
+			while (PC != head && ++count < IDLE_LOOP_MAXIMUM_INSTRUCTIONS);
+
+			RESOLVE_FLAGS;
+			state.Z_Z80_STATE_MEMBER_R = R;
+
+			if (	PC != head	 ||
+				CYCLES >= cycles ||
+				memcmp(&state, &object->state, sizeof(ZZ80State))
+			)
+				return;
+
+			iteration_cycles = CYCLES - iteration_cycles;
+			iteration_r	 = R - iteration_r;
+			iterations	 = (cycles - CYCLES - 1) / iteration_cycles;
+			}
+
+		if (!iterations) return;
+		R      += (zuint8)(iterations * iteration_r);
+		CYCLES += iterations * iteration_cycles;
+		object->idle_loops.hits++;
+		object->idle_loops.cycles += iterations * iteration_cycles;
+		}
+
+#	define IDLE_LOOP_MARK  pc = PC
+#	define IDLE_LOOP_CHECK							     \
+		if ((zuint16)(pc - PC) < IDLE_LOOP_MAXIMUM_SIZE && CB_ACTION(trap) == NULL) \
+			skip_idle_loop(object, cycles)
+
+#else
+#	define IDLE_LOOP_MARK
+#	define IDLE_LOOP_CHECK
+#endif
+
+
 /* MARK: - Main Functions */
 
-CPU_Z80_API zsize z80_run(Z80 *object, zsize cycles)
+/*-------------------------------------------------------------------.
+| Executes until CYCLES reaches the limit, counting from its current |
+| value, so that a run can be split into several calls (see          |
+| "Z80 Batch.c").                                                    |
+'-------------------------------------------------------------------*/
+Z_INLINE zsize run(Z80 *object, zsize cycles)
 	{
 	zuint32 data;
+	zsize halts;
 
-	/*-------------.
-	| Clear cycles |
-	'-------------*/
-	CYCLES = 0;
+#	if DEFINED(USE_IDLE_LOOP_SKIPPING)
+		zuint16 pc;
+#	endif
+
+#	if DEFINED(USE_BULK_TRANSFERS)
+		object->cycle_limit   = cycles;
+		object->prefix_cycles = 0;
+#	endif
 
 	/*--------------.
 	| Backup R7 bit |
@@ -1511,6 +2857,43 @@ CPU_Z80_API zsize z80_run(Z80 *object, zsize cycles)
 			continue;
 			}
 
+		/*-------------------------------------------------------------.
+		| Let the machine handle the instruction at PC by itself; if it |
+		| does, the trap is responsible for leaving a coherent state.   |
+		'-------------------------------------------------------------*/
+		if (CB_ACTION(trap) != NULL)
+			{
+			RESOLVE_FLAGS;
+			if (CB_ACTION(trap)(CB_OBJECT(trap), PC)) continue;
+			}
+
+		/*-----------------------------------------------------------------.
+		| Fast-forward HALT: until an interrupt is accepted, nothing but R |
+		| and the cycle count would change, so the rest of the budget is   |
+		| consumed at once, rounded up to whole HALTs of 4 cycles.         |
+		'-----------------------------------------------------------------*/
+		if (HALT && READ_8(PC) == 0x76)
+			{
+			halts = (cycles - CYCLES + 3) / 4;
+			R += (zuint8)halts;
+			EI = FALSE;
+			CYCLES += halts * 4;
+			break;
+			}
+
+#		if DEFINED(USE_BLOCK_CACHE)
+			/*---------------------------------------------------.
+			| Run a predecoded block; traps need to see every PC |
+			'---------------------------------------------------*/
+			if (object->block_cache != NULL && CB_ACTION(trap) == NULL)
+				{
+				IDLE_LOOP_MARK;
+				run_block(object, cycles);
+				IDLE_LOOP_CHECK;
+				continue;
+				}
+#		endif
+
 		/*---------------------------------------.
 		| Consume memory refresh and update bits |
 		'---------------------------------------*/
@@ -1520,13 +2903,16 @@ CPU_Z80_API zsize z80_run(Z80 *object, zsize cycles)
 		/*-----------------------------------------------.
 		| Execute instruction and update consumed cycles |
 		'-----------------------------------------------*/
+		IDLE_LOOP_MARK;
 		CYCLES += instruction_table[BYTE0 = READ_8(PC)](object);
+		IDLE_LOOP_CHECK;
 		}
 
-	/*---------------.
-	| Restore R7 bit |
-	'---------------*/
+	/*--------------------------------------.
+	| Restore R7 bit and resolve lazy flags |
+	'--------------------------------------*/
 	R = R_ALL;
+	RESOLVE_FLAGS;
 
 	/*-----------------------.
 	| Return consumed cycles |
@@ -1535,6 +2921,17 @@ CPU_Z80_API zsize z80_run(Z80 *object, zsize cycles)
 	}
 
 
+CPU_Z80_API zsize z80_run(Z80 *object, zsize cycles)
+	{
+	/*-------------.
+	| Clear cycles |
+	'-------------*/
+	CYCLES = 0;
+
+	return run(object, cycles);
+	}
+
+
 CPU_Z80_API void z80_reset(Z80 *object)
 	{
 	PC   = Z_Z80_VALUE_AFTER_RESET_PC;
@@ -1601,7 +2998,7 @@ CPU_Z80_API void z80_int(Z80 *object, zboolean state) {INT = state;}
 
 #if DEFINED(BUILD_ABI) || DEFINED(BUILD_MODULE_ABI)
 
-	static void will_read_state(Z80 *object) {R  = R_ALL;}
+	static void will_read_state(Z80 *object) {R  = R_ALL; RESOLVE_FLAGS;}
 	static void did_write_state(Z80 *object) {R7 = R;    }
 
 	static ZCPUEmulatorExport const exports[7] = {
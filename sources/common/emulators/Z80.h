@@ -17,6 +17,14 @@ Released under the terms of the GNU General Public License v3. */
 #	include <Z/macros/slot.h>
 #endif
 
+#if defined(CPU_Z80_USE_JIT) && !defined(CPU_Z80_USE_BLOCK_CACHE)
+#	define CPU_Z80_USE_BLOCK_CACHE
+#endif
+
+#ifdef CPU_Z80_USE_BLOCK_CACHE
+	typedef struct Z80BlockCache Z80BlockCache;
+#endif
+
 typedef struct {
 	zsize	  cycles;
 	ZZ80State state;
@@ -31,6 +39,7 @@ typedef struct {
 			ZSlot(ZContext16BitAddressWrite8Bit) out;
 			ZSlot(ZContextRead32Bit		   ) int_data;
 			ZSlot(ZContextSwitch		   ) halt;
+			ZSlot(ZContext16BitAddressRead8Bit ) trap;
 		} cb;
 #	else
 		void* cb_context;
@@ -41,8 +50,35 @@ typedef struct {
 			ZContext16BitAddressWrite8Bit out;
 			ZContextRead32Bit	      int_data;
 			ZContextSwitch		      halt;
+			ZContext16BitAddressRead8Bit  trap;
 		} cb;
 #	endif
+
+#	ifdef CPU_Z80_USE_BLOCK_CACHE
+		Z80BlockCache* block_cache;
+		zuint16	       bank[4];
+#	endif
+
+#	ifdef CPU_Z80_USE_BULK_TRANSFERS
+		zsize	cycle_limit;
+		zuint8	prefix_cycles;
+		zuint8* read_pages [4];
+		zuint8* write_pages[4];
+#	endif
+
+#	ifdef CPU_Z80_USE_IDLE_LOOP_SKIPPING
+		struct {zsize hits;
+			zsize cycles;
+		} idle_loops;
+#	endif
+
+#	ifdef CPU_Z80_USE_LAZY_FLAGS
+		struct {zuint8 operation;
+			zuint8 x;
+			zuint8 y;
+			zuint8 carry;
+		} lazy_flags;
+#	endif
 } Z80;
 
 Z_C_SYMBOLS_BEGIN
@@ -78,6 +114,20 @@ CPU_Z80_API void  z80_nmi   (Z80*     object);
 CPU_Z80_API void  z80_int   (Z80*     object,
 			     zboolean state);
 
+#ifdef CPU_Z80_USE_BLOCK_CACHE
+
+	CPU_Z80_API Z80BlockCache* z80_block_cache_new	     (zsize	     bank_count);
+
+	CPU_Z80_API void	   z80_block_cache_destroy    (Z80BlockCache* object);
+
+	CPU_Z80_API void	   z80_block_cache_set_rom    (Z80BlockCache* object,
+							       zuint16	      bank,
+							       zuint8 const*  content);
+
+	CPU_Z80_API void	   z80_block_cache_invalidate (Z80BlockCache* object);
+
+#endif
+
 Z_C_SYMBOLS_END
 
 #endif /* __emulation_CPU_Z80_H__ */
@@ -0,0 +1,32 @@
+/* ZX Spectrum Emulator v1.0
+  ____    ____    ___ ___     ___
+ / __ \  / ___\  / __` __`\  / __`\
+/\ \/  \/\ \__/_/\ \/\ \/\ \/\  __/
+\ \__/\_\ \_____\ \_\ \_\ \_\ \____\
+ \/_/\/_/\/_____/\/_/\/_/\/_/\/____/
+Copyright © 2013 Manuel Sainz de Baranda y Goñi.
+Released under the terms of the GNU General Public License v3. */
+
+/*-------------------------------------------------------------------.
+| Copy of the Z80 core for the 16K/48K models: memory is accessed   |
+| directly instead of through the read and write callbacks. I/O     |
+| still goes through the callbacks, since it drives the ULA.        |
+'-------------------------------------------------------------------*/
+
+#define CPU_Z80_HIDE_API
+#define CPU_Z80_API static /* Z80.h is first included by "ZX Spectrum.h" */
+#define CPU_Z80_ABI
+
+#include "ZX Spectrum.h"
+
+#define CPU_Z80_INLINE_READ_8(context, address)	       zx_spectrum_48k_cpu_read ((ZXSpectrum *)(context), address)
+#define CPU_Z80_INLINE_WRITE_8(context, address, value) zx_spectrum_48k_cpu_write((ZXSpectrum *)(context), address, value)
+
+#include "Z80.c"
+
+
+zsize zx_spectrum_48k_cpu_run(Z80 *cpu, zsize cycles)
+	{return z80_run(cpu, cycles);}
+
+
+/* ZX Spectrum 48K CPU.c EOF */
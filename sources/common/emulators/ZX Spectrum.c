@@ -16,29 +16,10 @@ Released under the terms of the GNU General Public License v3. */
 #include <Z/hardware/machine/model/computer/ZX Spectrum/ZX Spectrum +3.h>
 #include <Z/hardware/machine/model/computer/ZX Spectrum/Inves Spectrum +.h>
 #include <Z/ABIs/generic/emulation.h>
+#include "ZX Spectrum.h"
 
 #define KB(amount) (1024 * amount)
 
-/* MARK: - Types */
-
-typedef struct {
-	zsize top;
-	zsize bottom;
-} ScreenBorder;
-
-typedef struct {
-	zsize per_int;
-	zsize per_scanline;
-	zsize per_frame;
-	zsize at_int;
-	zsize at_visible_top_border;
-	zsize at_paper_region;
-	zsize at_bottom_border;
-} Cycles;
-
-typedef struct {
-} Contention;
-
 /* MARK: - Constants */
 
 Z_PRIVATE ScreenBorder const zx_spectrum_screen_border = {
@@ -84,61 +65,43 @@ Z_PRIVATE Contention const zx_spectrum_plus_128k_contention = {
 
 
 
-#define ZX_SPECTRUM_VALUES				\
-	zuint8*			memory;			\
-	void*			cpu;			\
-	zsize*			cpu_cycles;		\
-	void*			video_output_buffer;	\
-	zuint8*			audio_input_buffer;	\
-	zint16*			audio_output_buffer;	\
-							\
-	struct {ZEmulatorRun	run;			\
-		ZEmulatorPower	power;			\
-		ZContextDo	reset;			\
-		ZContextSwitch	irq;			\
-	} cpu_abi;					\
-							\
-	zuint8			keyboard[8];		\
-	zuint32			border_color;		\
-	zsize			frame_cycles;		\
-	zsize			frames_since_flash;	\
-	zint16			current_audio_sample;	\
-	zsize			audio_sample_index;	\
-	zsize			audio_input_base_index;	\
-	zboolean		accurate;		\
-	ZZXSpectrumState	state;			\
-	const ScreenBorder*	screen_border;		\
-	const Cycles*		cycles;			\
-	const Contention*	contention;		\
-	zuint8			port_fe;		\
-	zuint8			port_fe_update_cycle;	\
-	zuint8*			vram;			\
-
-typedef struct {
-	ZX_SPECTRUM_VALUES
-} ZXSpectrum;
-
-typedef struct {
-	ZX_SPECTRUM_VALUES
-	zuint8*		memory_pages[4];
-	zuint8		port_7ffd;
-	zboolean	disable_bank_switching;
-	void*		psg;
-
-	struct {
-	} psg_abi;
-} ZXSpectrum128K;
-
 #define RAM_BANK(number) (object->memory + (1024 * 16 * 2) + (1024 * 16 * (number)))
 #define ROM_BANK(number) (object->memory + (1024 * 16 * (number)))
 
 
+/*--------------------------------------------------------------------.
+| The CPU block cache identifies each 16K bank by its position in the |
+| machine memory, which is unique for every ROM and RAM bank. Bulk    |
+| transfers access the banks through direct pointers; the ROM is      |
+| always paged at 0000h and is never writable, and the bank holding   |
+| the screen is written through the callbacks, which keep the lazily  |
+| drawn screen up to date.                                            |
+'--------------------------------------------------------------------*/
+#if defined(CPU_Z80_USE_BLOCK_CACHE)
+#	define MAP_CPU_BANK_TOKEN(index, pointer) \
+		object->cpu.bank[index] = (zuint16)(((pointer) - object->memory) / KB(16));
+#else
+#	define MAP_CPU_BANK_TOKEN(index, pointer)
+#endif
+
+#if defined(CPU_Z80_USE_BULK_TRANSFERS)
+#	define MAP_CPU_BANK_POINTERS(index, pointer)	  \
+		object->cpu.read_pages [index] = (pointer); \
+		object->cpu.write_pages[index] = (index) && (pointer) != object->vram ? (pointer) : NULL;
+#else
+#	define MAP_CPU_BANK_POINTERS(index, pointer)
+#endif
+
+#define MAP_CPU_BANK(index, pointer) \
+	MAP_CPU_BANK_TOKEN(index, pointer) MAP_CPU_BANK_POINTERS(index, pointer)
+
+
 #include <Z/macros/color.h>
 
-#define CPU_RUN(cycles)		object->cpu_abi.run(object->cpu, cycles)
-#define CPU_INT(state)		object->cpu_abi.irq(object->cpu, state)
-#define CPU_RESET		object->cpu_abi.reset(object->cpu)
-#define CPU_POWER(state)	object->cpu_abi.power(object->cpu, state)
+#define CPU_RUN(cycles)		object->cpu_abi.run(&object->cpu, cycles)
+#define CPU_INT(state)		z80_int(&object->cpu, state)
+#define CPU_RESET		z80_reset(&object->cpu)
+#define CPU_POWER(state)	z80_power(&object->cpu, state)
 #define RGBA			Z_RGBA32
 #define WAVE_HIGH		6550
 #define WAVE_LOW		-6550
@@ -172,6 +135,26 @@ Z_PRIVATE void update_audio_output(ZXSpectrum *object, zsize new_index)
 	}
 
 
+/*----------------------------------------------------------------.
+| Index of the audio sample at the current time. The samples per  |
+| cycle are kept as a 24.40 fixed-point value rounded up, which   |
+| gives the same index as dividing the cycle of the frame by the  |
+| cycles per sample for any cycle within the frame.               |
+'----------------------------------------------------------------*/
+#define AUDIO_SAMPLE_STEP_BITS 40
+
+Z_INLINE zuint64 audio_sample_step(Cycles const *cycles)
+	{return ((Z_UINT64(882) << AUDIO_SAMPLE_STEP_BITS) + cycles->per_frame - 1) / cycles->per_frame;}
+
+
+Z_INLINE zsize audio_index(ZXSpectrum *object)
+	{
+	return (zsize)(
+		((zx_spectrum_now(object) - object->frame_start) * object->audio_sample_step)
+		>> AUDIO_SAMPLE_STEP_BITS);
+	}
+
+
 Z_PRIVATE void draw_character_row(zuint8 *vram, zsize x, zsize y, zsize row, zboolean flash, zuint32 *output)
 	{
 	zuint8 character = *(vram + 2048 * (y / 8) + 32 * (y - 8 * (y / 8)) + 256 * row + x);
@@ -211,45 +194,258 @@ Z_PRIVATE void draw_character_row(zuint8 *vram, zsize x, zsize y, zsize row, zbo
 	}
 
 
-/* MARK: - CPU Callbacks: Memory Access */
+/* MARK: - Video */
 
 
-Z_PRIVATE zuint8 zx_spectrum_16k_cpu_read(ZXSpectrum *object, zuint16 address)
-	{return address < 0x8000 ? object->memory[address] : 0;}
+Z_PRIVATE zsize line_end_cycle(ZXSpectrum *object, zuint line)
+	{
+	Cycles const *cycles = object->cycles;
+	zuint top = (zuint)object->screen_border->top;
 
+	if (line < top) return cycles->at_visible_top_border + cycles->per_scanline * (line + 1);
+	line -= top;
 
-Z_PRIVATE void zx_spectrum_16k_cpu_write(
-	ZXSpectrum*	object,
-	zuint16		address,
-	zuint8		value
-)
-	{if (address > 0x3FFF && address < 0x8000) object->memory[address] = value;}
+	if (line < Z_ZX_SPECTRUM_SCREEN_PAPER_HEIGHT)
+		return cycles->at_paper_region + cycles->per_scanline * (line + 1);
 
+	return cycles->at_bottom_border
+		+ cycles->per_scanline * (line - Z_ZX_SPECTRUM_SCREEN_PAPER_HEIGHT + 1);
+	}
 
-Z_PRIVATE zuint8 zx_spectrum_48k_cpu_read(ZXSpectrum *object, zuint16 address)
-	{return object->memory[address];}
 
+Z_PRIVATE void draw_line(ZXSpectrum *object, zuint line)
+	{
+	zuint32 *p = (zuint32 *)object->video_output_buffer + Z_ZX_SPECTRUM_SCREEN_WIDTH * line, *e;
+	zuint32 border_color = object->border_color;
+	zuint top = (zuint)object->screen_border->top;
+	zsize cx, cy, row;
+
+	/*------------.
+	| Border only |
+	'------------*/
+	if (line < top || line >= top + Z_ZX_SPECTRUM_SCREEN_PAPER_HEIGHT)
+		{
+		for (e = p + Z_ZX_SPECTRUM_SCREEN_WIDTH; p != e; p++)
+			*p = border_color;
+
+		return;
+		}
+
+	/*-----------------.
+	| Border and paper |
+	'-----------------*/
+	for (e = p + Z_ZX_SPECTRUM_SCREEN_LEFT_BORDER_WIDTH; p != e; p++)
+		*p = border_color;
+
+	line -= top;
+
+	for (cx = 0, cy = line / 8, row = line % 8; cx < Z_ZX_SPECTRUM_SCREEN_PAPER_WIDTH / 8; cx++, p += 8)
+		draw_character_row(object->vram, cx, cy, row, object->state.flash, p);
+
+	for (e = p + Z_ZX_SPECTRUM_SCREEN_RIGHT_BORDER_WIDTH; p != e; p++)
+		*p = border_color;
+	}
+
+
+/*-----------------------------------------------------------.
+| Draws the scanlines that end at or before the given cycle. |
+'-----------------------------------------------------------*/
+Z_PRIVATE void draw_lines(ZXSpectrum *object, zuint64 cycle)
+	{
+	while (	object->screen.line < Z_ZX_SPECTRUM_SCREEN_HEIGHT &&
+		cycle >= object->screen.next_line_cycle
+	)
+		{
+		draw_line(object, object->screen.line);
+
+		object->screen.next_line_cycle = ++object->screen.line < Z_ZX_SPECTRUM_SCREEN_HEIGHT
+			? object->frame_start + line_end_cycle(object, object->screen.line)
+			: object->frame_start + object->cycles->per_frame;
+		}
+	}
+
+
+/*---------------------------------------------------------.
+| Called from the CPU callbacks, while the CPU is running. |
+'---------------------------------------------------------*/
+void zx_spectrum_update_screen(ZXSpectrum *object)
+	{draw_lines(object, zx_spectrum_now(object));}
+
+
+/* MARK: - Events */
+
+
+/*-------------------------------------------------------------.
+| The events are kept in a binary heap ordered by their cycle. |
+'-------------------------------------------------------------*/
+zboolean zx_spectrum_schedule(ZXSpectrum *object, zuint64 cycle, ZContextDo action)
+	{
+	ZXSpectrumEvent *heap = object->events.array;
+	zuint index, parent;
+
+	if (object->events.count == ZX_SPECTRUM_MAXIMUM_EVENTS) return FALSE;
+
+	for (index = object->events.count++; index; index = parent)
+		{
+		if (heap[parent = (index - 1) / 2].cycle <= cycle) break;
+		heap[index] = heap[parent];
+		}
+
+	heap[index].cycle  = cycle;
+	heap[index].action = action;
+	return TRUE;
+	}
+
+
+Z_PRIVATE ZXSpectrumEvent next_event(ZXSpectrum *object)
+	{
+	ZXSpectrumEvent *heap = object->events.array;
+	ZXSpectrumEvent event = heap[0], last = heap[--object->events.count];
+	zuint index = 0, child;
+
+	while ((child = index * 2 + 1) < object->events.count)
+		{
+		if (child + 1 < object->events.count && heap[child + 1].cycle < heap[child].cycle)
+			child++;
+
+		if (last.cycle <= heap[child].cycle) break;
+		heap[index] = heap[child];
+		index = child;
+		}
+
+	heap[index] = last;
+	return event;
+	}
+
+
+Z_PRIVATE void int_off(ZXSpectrum *object)
+	{CPU_INT(OFF);}
+
+
+Z_PRIVATE void int_on(ZXSpectrum *object)
+	{
+	CPU_INT(ON);
+	zx_spectrum_schedule(object, object->clock + object->cycles->per_int, (ZContextDo)int_off);
+	}
 
-Z_PRIVATE void zx_spectrum_48k_cpu_write(
-	ZXSpectrum*	object,
-	zuint16		address,
-	zuint8		value
-)
-	{if (address > 0x3FFF) object->memory[address] = value;}
 
+/* MARK: - Input */
 
-Z_PRIVATE zuint8 zx_spectrum_plus_128k_cpu_read(ZXSpectrum128K *object, zuint16 address)
-	{return object->memory_pages[address / KB(16)][address % KB(16)];}
 
+Z_PRIVATE void update_input(ZXSpectrum *object, zuint64 cycle)
+	{
+	ZXSpectrumInput *input;
+
+	while (	object->input.count &&
+		(input = &object->input.array[object->input.head])->cycle <= cycle
+	)
+		{
+		if (input->device == ZX_SPECTRUM_INPUT_JOYSTICK)
+			{
+			if (input->pressed) object->joystick |= input->mask;
+			else object->joystick &= ~input->mask;
+			}
+
+		else if (input->pressed) object->state.keyboard.array_uint8[input->device] &= ~input->mask;
+		else object->state.keyboard.array_uint8[input->device] |= input->mask;
+
+		object->input.head = (object->input.head + 1) % ZX_SPECTRUM_MAXIMUM_INPUTS;
+		object->input.count--;
+		}
+	}
+
+
+/*-----------------------------------------------------------------.
+| Events are kept in the order they are received; one with a cycle |
+| before that of the previous event is delayed to it. When the     |
+| queue is full, the oldest event is applied early to make room.   |
+'-----------------------------------------------------------------*/
+void zx_spectrum_input(ZXSpectrum *object, zuint64 cycle, zuint8 device, zuint8 mask, zboolean pressed)
+	{
+	ZXSpectrumInput *input;
+
+	if (object->input.count == ZX_SPECTRUM_MAXIMUM_INPUTS)
+		update_input(object, object->input.array[object->input.head].cycle);
+
+	if (object->input.count)
+		{
+		input = &object->input.array
+			[(object->input.head + object->input.count - 1) % ZX_SPECTRUM_MAXIMUM_INPUTS];
+
+		if (cycle < input->cycle) cycle = input->cycle;
+		}
+
+	input = &object->input.array
+		[(object->input.head + object->input.count++) % ZX_SPECTRUM_MAXIMUM_INPUTS];
+
+	input->cycle   = cycle;
+	input->device  = device;
+	input->mask    = mask;
+	input->pressed = pressed;
+	}
 
-Z_PRIVATE void zx_spectrum_plus_128k_cpu_write(
-	ZXSpectrum128K*	object,
+
+/*-----------------------------------------------------------------.
+| Value read from the port of a joystick interface. The interfaces |
+| not attached to the machine leave their port unassigned.         |
+'-----------------------------------------------------------------*/
+Z_PRIVATE zuint8 joystick_in(ZXSpectrum *object, zuint8 interface)
+	{
+	zuint8 joystick;
+
+	if (object->joystick_interface != interface) return 0xFF;
+	if (object->input.count) update_input(object, zx_spectrum_now(object));
+	joystick = object->joystick;
+
+	switch (interface)
+		{
+		/*--------------------------------------------.
+		| Kempston: active high; fire, up, down, left |
+		| and right in bits 4 to 0.                   |
+		'--------------------------------------------*/
+		case ZX_SPECTRUM_JOYSTICK_INTERFACE_KEMPSTON:
+		return joystick;
+
+		/*-----------------------------------------------------.
+		| Fuller: active low, fire in bit 7, right, left, down |
+		| and up in bits 3 to 0.                               |
+		'-----------------------------------------------------*/
+		case ZX_SPECTRUM_JOYSTICK_INTERFACE_FULLER:
+		return (zuint8)~(
+			(joystick & ZX_SPECTRUM_JOYSTICK_UP    ? 1   : 0) |
+			(joystick & ZX_SPECTRUM_JOYSTICK_DOWN  ? 2   : 0) |
+			(joystick & ZX_SPECTRUM_JOYSTICK_LEFT  ? 4   : 0) |
+			(joystick & ZX_SPECTRUM_JOYSTICK_RIGHT ? 8   : 0) |
+			(joystick & ZX_SPECTRUM_JOYSTICK_FIRE  ? 128 : 0));
+
+		/*--------------------------------------------.
+		| Mikrogen: the bits of Kempston, active low. |
+		'--------------------------------------------*/
+		default: return (zuint8)~joystick;
+		}
+	}
+
+
+/* MARK: - CPU Callbacks: Memory Access */
+
+
+Z_PRIVATE zuint8 zx_spectrum_16k_cpu_read(ZXSpectrum *object, zuint16 address)
+	{return address < 0x8000 ? object->memory[address] : 0;}
+
+
+Z_PRIVATE void zx_spectrum_16k_cpu_write(
+	ZXSpectrum*	object,
 	zuint16		address,
 	zuint8		value
 )
 	{
-	if (address > 0x3FFF)
-		object->memory_pages[address / KB(16)][address % KB(16)] = value;
+	if (address > 0x3FFF && address < 0x8000)
+		{
+		if (address < Z_ZX_SPECTRUM_ADDRESS_VIDEO_CHARACTER_RAM + ZX_SPECTRUM_VRAM_SIZE)
+			zx_spectrum_synchronize_screen(object);
+
+		object->memory[address] = value;
+		}
 	}
 
 
@@ -272,21 +468,21 @@ Z_PRIVATE zuint8 zx_spectrum_cpu_in(ZXSpectrum *object, zuint16 port)
 		| Kempston Joystick |
 		'------------------*/
 		case Z_ZX_SPECTRUM_IO_PORT_KEMPSTON_JOYSTICK:
-		/* treat this as attached but unused
-		 (for the benefit of Manic Miner) */
-		return 0xFF;
+		/* without a joystick, treat this as attached but
+		 unused (for the benefit of Manic Miner) */
+		return joystick_in(object, ZX_SPECTRUM_JOYSTICK_INTERFACE_KEMPSTON);
 
 		/*----------------.
 		| Fuller Joystick |
 		'----------------*/
 		case Z_ZX_SPECTRUM_IO_PORT_FULLER_JOYSTICK:
-		return 0xFF;
+		return joystick_in(object, ZX_SPECTRUM_JOYSTICK_INTERFACE_FULLER);
 
 		/*------------------.
 		| Mikrogen Joystick |
 		'------------------*/
 		case Z_ZX_SPECTRUM_IO_PORT_MIKROGEN_JOYSTICK:
-		return 0xFF;
+		return joystick_in(object, ZX_SPECTRUM_JOYSTICK_INTERFACE_MIKROGEN);
 
 		/*--------------------.
 		| Unassigned I/O port |
@@ -301,6 +497,7 @@ Z_PRIVATE zuint8 zx_spectrum_cpu_in(ZXSpectrum *object, zuint16 port)
 		/*---------.
 		| Keyboard |
 		'---------*/
+		if (object->input.count) update_input(object, zx_spectrum_now(object));
 		value = 0xBF;
 		if (!(port & (1 <<  8))) value &= object->state.keyboard.array_uint8[0];
 		if (!(port & (1 <<  9))) value &= object->state.keyboard.array_uint8[1];
@@ -311,11 +508,32 @@ Z_PRIVATE zuint8 zx_spectrum_cpu_in(ZXSpectrum *object, zuint16 port)
 		if (!(port & (1 << 14))) value &= object->state.keyboard.array_uint8[6];
 		if (!(port & (1 << 15))) value &= object->state.keyboard.array_uint8[7];
 
-		if (object->audio_input_buffer)
+		/*-----------.
+		| Tape (EAR) |
+		'-----------*/
+		if (object->tape.next_pulse != NULL)
 			{
-			zsize index = ((*object->cpu_cycles + object->frame_cycles) * 882) / object->cycles->per_frame;
+			zuint64 now = zx_spectrum_now(object);
+			zuint32 pulse;
+
+			while (now >= object->tape.next_edge_cycle)
+				{
+				if (!(pulse = object->tape.next_pulse(object->tape.context)))
+					{
+					object->tape.next_pulse = NULL;
+					break;
+					}
+
+				object->tape.ear = !object->tape.ear;
+				object->tape.next_edge_cycle += pulse;
+				}
+
+			if (object->tape.ear) value |= 0x40;
+			}
 
-			if (object->audio_input_buffer[object->audio_input_base_index + index] == 0x90)
+		else if (object->audio_input_buffer)
+			{
+			if (object->audio_input_buffer[object->audio_input_base_index + audio_index(object)] == 0x90)
 				value |= 0x40;
 
 			//else printf("0\n");
@@ -344,20 +562,23 @@ Z_PRIVATE void zx_spectrum_cpu_out(ZXSpectrum *object, zuint16 port, zuint8 valu
 		/*-------------.
 		| Border Color |
 		'-------------*/
-		object->border_color = ((zuint32 *)palette)[value & 0x07];
+		if (((zuint32 *)palette)[value & 0x07] != object->border_color)
+			{
+			zx_spectrum_synchronize_screen(object);
+			object->border_color = ((zuint32 *)palette)[value & 0x07];
+			}
 
 		/*----------.
 		| MIC - EAR |
 		'----------*/
 		if ((object->port_fe ^ value) & 24)
 			{
-			zsize new_index = ((*object->cpu_cycles + object->frame_cycles) * 882) / object->cycles->per_frame;
-			update_audio_output(object, new_index);
+			update_audio_output(object, audio_index(object));
 			object->current_audio_sample = (value & 0x10) ? WAVE_HIGH : WAVE_LOW;
 			}
 
 		object->port_fe = value;
-		object->port_fe_update_cycle = ((Z80 *)object->cpu)->cycles;
+		object->port_fe_update_cycle = zx_spectrum_now(object);
 	//	printf("sending something to ULA => %hhX\n", value);
 		}
 	}
@@ -369,11 +590,15 @@ Z_PRIVATE void zx_spectrum_plus_128k_cpu_out(ZXSpectrum128K *object, zuint16 por
 		{
 		if (!object->disable_bank_switching)
 			{
+			zx_spectrum_synchronize_screen((ZXSpectrum *)object);
 			object->memory_pages[0] = ROM_BANK(!!(value & 16));
 			object->memory_pages[1] = object->vram = RAM_BANK(value &  8 ? 5 : 7);
 			object->memory_pages[3] = RAM_BANK(value &  7);
 			object->disable_bank_switching = !!(value & 32);
 			object->memory_pages[1][0x5B5C - 0x4000] = value;
+			MAP_CPU_BANK(0, object->memory_pages[0]);
+			MAP_CPU_BANK(1, object->memory_pages[1]);
+			MAP_CPU_BANK(3, object->memory_pages[3]);
 			}
 		}
 
@@ -399,19 +624,92 @@ Z_PRIVATE void cpu_halt(ZXSpectrum *object)
 	{
 	}
 
-#include "Z80.h"
-#define CPU(object) ((Z80 *)(object))
+
+/* MARK: - CPU Callbacks: Traps */
+
+#define ROM_SA_BYTES   0x04C2
+#define ROM_SA_LD_RET  0x053F
+#define SAVE_CHUNK_SIZE 256
+
+Z_PRIVATE zuint8 cpu_trap(ZXSpectrum *object, zuint16 address)
+	{
+	Z80 *cpu = &object->cpu;
+	zuint8 chunk[SAVE_CHUNK_SIZE];
+	zsize block_size, offset, fill;
+	zuint16 ix, size;
+	zuint8 checksum;
+	zboolean saved;
+
+	/*-----------------------------------------------------------------.
+	| SA-BYTES; the entry is checked against the code of the 48K BASIC |
+	| ROM, so nothing is trapped while other ROMs are paged in.        |
+	'-----------------------------------------------------------------*/
+	if (	address != ROM_SA_BYTES			 ||
+		object->tape_output.save_block == NULL	 ||
+		cpu->cb.read(object, ROM_SA_BYTES    ) != 0x21 ||
+		cpu->cb.read(object, ROM_SA_BYTES + 1) != 0x3F ||
+		cpu->cb.read(object, ROM_SA_BYTES + 2) != 0x05
+	)
+		return FALSE;
+
+	/*------------------------------------------------------------.
+	| A = flag; IX = address of the data; DE = size of the data.  |
+	| The block is passed on in chunks, so that the stack does    |
+	| not have to hold up to 64 KiB.                              |
+	'------------------------------------------------------------*/
+	checksum   = chunk[0] = cpu->state.Z_Z80_STATE_MEMBER_A;
+	ix	   = cpu->state.Z_Z80_STATE_MEMBER_IX;
+	size	   = cpu->state.Z_Z80_STATE_MEMBER_DE;
+	block_size = (zsize)size + 2;
+	saved	   = TRUE;
+
+	for (offset = 0, fill = 1; saved && offset < block_size; offset += fill, fill = 0)
+		{
+		while (fill < SAVE_CHUNK_SIZE && offset + fill < block_size - 1)
+			checksum ^= chunk[fill++] = cpu->cb.read(object, ix++);
+
+		if (fill < SAVE_CHUNK_SIZE && offset + fill == block_size - 1)
+			chunk[fill++] = checksum;
+
+		saved = object->tape_output.save_block
+			(object->tape_output.context, block_size, offset, chunk, fill);
+		}
+
+	/*-----------------------------------------------------------------.
+	| Leave the registers as the last RET of SA-BYTES does: DE = FFFFh |
+	| and IX one past the checksum, as both were also stepped for it;  |
+	| A = B = 0 after the end-of-block test and the last delay loop;   |
+	| Z, H and, on success, carry set. That RET returns to SA/LD-RET,  |
+	| which SA-BYTES pushed on entry, so the ROM itself restores the   |
+	| border, checks BREAK and enables the interrupts.                 |
+	'-----------------------------------------------------------------*/
+	cpu->state.Z_Z80_STATE_MEMBER_IX = (zuint16)(cpu->state.Z_Z80_STATE_MEMBER_IX + size + 1);
+	cpu->state.Z_Z80_STATE_MEMBER_DE = 0xFFFF;
+	cpu->state.Z_Z80_STATE_MEMBER_A	 = 0;
+	cpu->state.Z_Z80_STATE_MEMBER_B	 = 0;
+	cpu->state.Z_Z80_STATE_MEMBER_F	 = saved ? 0x51 : 0x50;
+	cpu->state.Z_Z80_STATE_MEMBER_PC = ROM_SA_LD_RET;
+	return TRUE;
+	}
+
 
 Z_PRIVATE void zx_spectrum_initialize(ZXSpectrum *object)
 	{
 	object->frames_since_flash = 0;
-	CPU(object->cpu)->cb.read	= (void *)zx_spectrum_48k_cpu_read;
-	CPU(object->cpu)->cb.write	= (void *)zx_spectrum_48k_cpu_write;
-	CPU(object->cpu)->cb.in		= (void *)zx_spectrum_cpu_in;
-	CPU(object->cpu)->cb.out	= (void *)zx_spectrum_cpu_out;
-	CPU(object->cpu)->cb.int_data	= (void *)cpu_int_data;
-	CPU(object->cpu)->cb.halt	= (void *)cpu_halt;
-	CPU(object->cpu)->cb_context	= object;
+	object->cpu.cb.read	= (void *)zx_spectrum_48k_cpu_read;
+	object->cpu.cb.write	= (void *)zx_spectrum_48k_cpu_write;
+	object->cpu.cb.in	= (void *)zx_spectrum_cpu_in;
+	object->cpu.cb.out	= (void *)zx_spectrum_cpu_out;
+	object->cpu.cb.int_data	= (void *)cpu_int_data;
+	object->cpu.cb.halt	= (void *)cpu_halt;
+	object->cpu.cb.trap	= NULL;
+	object->cpu.cb_context	= object;
+
+#	ifdef ZX_SPECTRUM_USE_SPECIALIZED_CPU
+		object->cpu_abi.run = (ZEmulatorRun)zx_spectrum_48k_cpu_run;
+#	else
+		object->cpu_abi.run = (ZEmulatorRun)z80_run;
+#	endif
 
 	object->screen_border = &zx_spectrum_screen_border;
 	object->cycles = &zx_spectrum_cycles;
@@ -420,23 +718,50 @@ Z_PRIVATE void zx_spectrum_initialize(ZXSpectrum *object)
 	object->state.flash = FALSE;
 	object->current_audio_sample = WAVE_LOW;
 	object->border_color = palette[0][0];
-	object->frame_cycles = 0;
+	object->clock = 0;
+	object->frame_start = 0;
+	object->audio_sample_step = audio_sample_step(object->cycles);
 	object->audio_input_buffer = NULL;
 	object->audio_input_base_index = 0;
+	object->tape.next_pulse = NULL;
+	object->tape.context = NULL;
+	object->tape.next_edge_cycle = 0;
+	object->tape.ear = 0;
+	object->tape_output.save_block = NULL;
+	object->tape_output.context = NULL;
 	object->vram = object->memory + Z_ZX_SPECTRUM_ADDRESS_VIDEO_CHARACTER_RAM;
+	object->events.count = 0;
+	object->input.head = 0;
+	object->input.count = 0;
+	object->joystick = 0;
+	object->joystick_interface = ZX_SPECTRUM_JOYSTICK_INTERFACE_NONE;
+	object->screen.line = 0;
+	object->screen.next_line_cycle = line_end_cycle(object, 0);
+
+	MAP_CPU_BANK(0, object->memory);
+	MAP_CPU_BANK(1, object->memory + KB(16));
+	MAP_CPU_BANK(2, object->memory + KB(32));
+	MAP_CPU_BANK(3, object->memory + KB(48));
 	}
 
 
 Z_PRIVATE void zx_spectrum_plus_128k_initialize(ZXSpectrum128K *object)
 	{
 	object->frames_since_flash = 0;
-	CPU(object->cpu)->cb.read	= (void *)zx_spectrum_plus_128k_cpu_read;
-	CPU(object->cpu)->cb.write	= (void *)zx_spectrum_plus_128k_cpu_write;
-	CPU(object->cpu)->cb.in		= (void *)zx_spectrum_plus_128k_cpu_in;
-	CPU(object->cpu)->cb.out	= (void *)zx_spectrum_plus_128k_cpu_out;
-	CPU(object->cpu)->cb.int_data	= (void *)cpu_int_data;
-	CPU(object->cpu)->cb.halt	= (void *)cpu_halt;
-	CPU(object->cpu)->cb_context	= object;
+	object->cpu.cb.read	= (void *)zx_spectrum_plus_128k_cpu_read;
+	object->cpu.cb.write	= (void *)zx_spectrum_plus_128k_cpu_write;
+	object->cpu.cb.in	= (void *)zx_spectrum_plus_128k_cpu_in;
+	object->cpu.cb.out	= (void *)zx_spectrum_plus_128k_cpu_out;
+	object->cpu.cb.int_data	= (void *)cpu_int_data;
+	object->cpu.cb.halt	= (void *)cpu_halt;
+	object->cpu.cb.trap	= NULL;
+	object->cpu.cb_context	= object;
+
+#	ifdef ZX_SPECTRUM_USE_SPECIALIZED_CPU
+		object->cpu_abi.run = (ZEmulatorRun)zx_spectrum_plus_128k_cpu_run;
+#	else
+		object->cpu_abi.run = (ZEmulatorRun)z80_run;
+#	endif
 
 	object->screen_border = &zx_spectrum_screen_border;
 	object->cycles = &zx_spectrum_plus_128k_cycles;
@@ -445,16 +770,36 @@ Z_PRIVATE void zx_spectrum_plus_128k_initialize(ZXSpectrum128K *object)
 	object->state.flash = FALSE;
 	object->current_audio_sample = WAVE_LOW;
 	object->border_color = palette[0][0];
-	object->frame_cycles = 0;
+	object->clock = 0;
+	object->frame_start = 0;
+	object->audio_sample_step = audio_sample_step(object->cycles);
 	object->audio_input_buffer = NULL;
 	object->audio_input_base_index = 0;
+	object->tape.next_pulse = NULL;
+	object->tape.context = NULL;
+	object->tape.next_edge_cycle = 0;
+	object->tape.ear = 0;
+	object->tape_output.save_block = NULL;
+	object->tape_output.context = NULL;
 	object->disable_bank_switching = FALSE;
+	object->events.count = 0;
+	object->input.head = 0;
+	object->input.count = 0;
+	object->joystick = 0;
+	object->joystick_interface = ZX_SPECTRUM_JOYSTICK_INTERFACE_NONE;
+	object->screen.line = 0;
+	object->screen.next_line_cycle = line_end_cycle((ZXSpectrum *)object, 0);
 
 	object->port_7ffd = 0;
 	object->memory_pages[0] = object->memory;
 	object->memory_pages[1] = object->vram = RAM_BANK(5);
 	object->memory_pages[2] = RAM_BANK(2);
 	object->memory_pages[3] = RAM_BANK(0);
+
+	MAP_CPU_BANK(0, object->memory_pages[0]);
+	MAP_CPU_BANK(1, object->memory_pages[1]);
+	MAP_CPU_BANK(2, object->memory_pages[2]);
+	MAP_CPU_BANK(3, object->memory_pages[3]);
 	}
 
 
@@ -466,19 +811,14 @@ Z_PRIVATE void zx_spectrum_reset(ZXSpectrum *object)
 	{CPU_RESET;}
 
 
-#define CYCLES_AT_LINE(region, scanline_index) \
-	(cycles.at_##region + cycles.per_scanline * (scanline_index))
-
 Z_PRIVATE void zx_spectrum_run_1_frame(ZXSpectrum *object)
 	{
-	zsize i;
-	zsize cx, cy, row;
-	zuint32 *p = object->video_output_buffer, *e;
-	zuint32 border_color;
-	Cycles cycles = *object->cycles;
-	ScreenBorder screen_border = *object->screen_border;
+	Cycles const *cycles = object->cycles;
+	zuint64 frame_end = object->frame_start + cycles->per_frame;
+	ZXSpectrumEvent event;
 
 	object->audio_sample_index = 0;
+	object->cpu.cb.trap = object->tape_output.save_block != NULL ? (void *)cpu_trap : NULL;
 
 	if (object->frames_since_flash == 16)
 		{
@@ -486,74 +826,38 @@ Z_PRIVATE void zx_spectrum_run_1_frame(ZXSpectrum *object)
 		object->state.flash = !object->state.flash;
 		}
 
-	/*------------------.
-	| VBLANK before INT |
-	'------------------*/
-	object->frame_cycles += CPU_RUN(cycles.at_int - object->frame_cycles);
+	zx_spectrum_schedule(object, object->frame_start + cycles->at_int, (ZContextDo)int_on);
 
-	/*------------------.
-	| VBLANK during INT |
-	'------------------*/
-	CPU_INT(ON);
-	object->frame_cycles += CPU_RUN(cycles.per_int);
-	CPU_INT(OFF);
-
-	/*---------------------------------------------------.
-	| VBLANK after INT and invisble top border scanlines |
-	'---------------------------------------------------*/
-	object->frame_cycles += CPU_RUN(cycles.at_visible_top_border - object->frame_cycles);
-
-	/*-----------------------------.
-	| Visible top border scanlines |
-	'-----------------------------*/
-	for (i = 0; i < screen_border.top; i++)
+	/*----------------------------------------------------------.
+	| Run the CPU from event to event. An event that is already |
+	| due (the CPU overshoots the previous one by the length of |
+	| the last instruction) is handled without running the CPU. |
+	'----------------------------------------------------------*/
+	while (object->events.count && object->events.array[0].cycle < frame_end)
 		{
-		object->frame_cycles += CPU_RUN
-			(cycles.per_scanline - (object->frame_cycles - CYCLES_AT_LINE(visible_top_border, i)));
+		event = next_event(object);
 
-		border_color = object->border_color;
+		if (object->clock < event.cycle)
+			object->clock += CPU_RUN((zsize)(event.cycle - object->clock));
 
-		for (e = p + Z_ZX_SPECTRUM_SCREEN_WIDTH; p != e; p++)
-			*p = border_color;
+		event.action(object);
 		}
 
-	/*----------------.
-	| Video scanlines |
-	'----------------*/
-	for (i = 0; i < Z_ZX_SPECTRUM_SCREEN_PAPER_HEIGHT; i++)
-		{
-		object->frame_cycles += CPU_RUN
-			(cycles.per_scanline - (object->frame_cycles - CYCLES_AT_LINE(paper_region, i)));
-
-		border_color = object->border_color;
+	if (object->clock < frame_end)
+		object->clock += CPU_RUN((zsize)(frame_end - object->clock));
 
-		for (e = p + Z_ZX_SPECTRUM_SCREEN_LEFT_BORDER_WIDTH; p != e; p++)
-			*p = border_color;
+	update_input(object, frame_end);
 
-		for (cx = 0, cy = i / 8, row = i % 8; cx < Z_ZX_SPECTRUM_SCREEN_PAPER_WIDTH / 8; cx++, p += 8)
-			draw_character_row(object->vram, cx, cy, row, object->state.flash, p);
-
-		for (e = p + Z_ZX_SPECTRUM_SCREEN_RIGHT_BORDER_WIDTH; p != e; p++)
-			*p = border_color;
-		}
-
-	/*------------------------.
-	| Bottom border scanlines |
-	'------------------------*/
-	for (i = 0; i < screen_border.bottom; i++)
-		{
-		object->frame_cycles += CPU_RUN
-			(cycles.per_scanline - (object->frame_cycles - CYCLES_AT_LINE(bottom_border, i)));
-
-		border_color = object->border_color;
-
-		for (e = p + Z_ZX_SPECTRUM_SCREEN_WIDTH; p != e; p++)
-			*p = border_color;
-		}
+	/*----------------------------------------------.
+	| Draw the scanlines not drawn during the frame |
+	'----------------------------------------------*/
+	draw_lines(object, frame_end);
+	object->frame_start = frame_end;
+	object->screen.line = 0;
+	object->screen.next_line_cycle = frame_end + line_end_cycle(object, 0);
 
 	update_audio_output(object, 882);
 	object->frames_since_flash++;
-	object->frame_cycles -= cycles.per_frame;
 
 	if (object->audio_input_buffer != NULL)
 		{
@@ -564,8 +868,6 @@ Z_PRIVATE void zx_spectrum_run_1_frame(ZXSpectrum *object)
 			? WAVE_HIGH
 			: WAVE_LOW;
 		}
-
-	i = 0;
 	}
 
 
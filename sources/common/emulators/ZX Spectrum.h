@@ -7,48 +7,265 @@
 Copyright © 2011 RedCode Software.
 Released under the terms of the GNU General Public License v2. */
 
+#ifndef __mZX_emulators_ZX_Spectrum_H
+#define __mZX_emulators_ZX_Spectrum_H
+
 #define USE_STATIC_EMULATION_CPU_Z80
 #include "Z80.h"
 #include <Z/hardware/machine/platform/computer/ZX Spectrum.h>
 #include <Z/ABIs/generic/emulation.h>
 
 typedef struct {
-	zsize cycles_per_frame;
-	zsize cycles_per_scanline;
-	zsize cycles_per_int;
-} Timmings;
-
-#define ZX_SPECTRUM_VALUES				  \
-	zuint8*			memory;			  \
-	Z80*			cpu;			  \
-	zsize*			cpu_cycles;		  \
-	void*			video_output_buffer;  \
-	zuint8*			audio_input_buffer;   \
-	zint16*			audio_output_buffer; \
-							  \
-	struct {ZEmulatorRun	run;			  \
-		ZEmulatorPower	power;			\
-		ZContextDo	reset;			\
-		ZContextSwitch	irq;			\
-	} cpu_abi;					\
+	zsize top;
+	zsize bottom;
+} ScreenBorder;
+
+typedef struct {
+	zsize per_int;
+	zsize per_scanline;
+	zsize per_frame;
+	zsize at_int;
+	zsize at_visible_top_border;
+	zsize at_paper_region;
+	zsize at_bottom_border;
+} Cycles;
+
+typedef struct {
+} Contention;
+
+/*------------------------------------------------------------------.
+| Receives a tape block (flag, data and checksum) saved by the ROM, |
+| in consecutive chunks: offset is where the chunk goes within the  |
+| block, whose full size is given with every chunk.                 |
+'------------------------------------------------------------------*/
+typedef zboolean (* ZXSpectrumSaveBlock)(void*	       context,
+					 zsize	       block_size,
+					 zsize	       offset,
+					 zuint8 const* data,
+					 zsize	       data_size);
+
+/*-----------------------------------------------------------------.
+| Events are actions timed on the clock of the machine. The CPU    |
+| runs straight from one event to the next; those that are due     |
+| after the end of the frame are kept for the next one.            |
+'-----------------------------------------------------------------*/
+typedef struct {
+	zuint64	   cycle;
+	ZContextDo action;
+} ZXSpectrumEvent;
+
+#define ZX_SPECTRUM_MAXIMUM_EVENTS 16
+
+/*------------------------------------------------------------------.
+| Input events press or release keys of one half-row of the         |
+| keyboard, or directions of the joystick, at a given cycle. They   |
+| are applied when the CPU reads an input port, so every read sees  |
+| the state the devices had at its cycle, and at the end of the     |
+| frame. The joystick is read through the interface attached to the |
+| machine, if any.                                                  |
+'------------------------------------------------------------------*/
+typedef struct {
+	zuint64	 cycle;
+	zuint8	 device; /* half-row of the keyboard (0 to 7) or joystick */
+	zuint8	 mask;
+	zboolean pressed;
+} ZXSpectrumInput;
+
+#define ZX_SPECTRUM_MAXIMUM_INPUTS 64
+#define ZX_SPECTRUM_INPUT_JOYSTICK 8
+
+#define ZX_SPECTRUM_JOYSTICK_RIGHT 1
+#define ZX_SPECTRUM_JOYSTICK_LEFT  2
+#define ZX_SPECTRUM_JOYSTICK_DOWN  4
+#define ZX_SPECTRUM_JOYSTICK_UP	   8
+#define ZX_SPECTRUM_JOYSTICK_FIRE  16
+
+#define ZX_SPECTRUM_JOYSTICK_INTERFACE_NONE	0
+#define ZX_SPECTRUM_JOYSTICK_INTERFACE_KEMPSTON 1
+#define ZX_SPECTRUM_JOYSTICK_INTERFACE_FULLER	2
+#define ZX_SPECTRUM_JOYSTICK_INTERFACE_MIKROGEN 3
+
+#define ZX_SPECTRUM_VRAM_SIZE	   (Z_ZX_SPECTRUM_VIDEO_CHARACTER_RAM_SIZE + 32 * 24)
+
+/*-----------------------------------------------------------------.
+| The CPU is embedded at the start of the machine, followed by the |
+| fields used on every memory or I/O access, so that running the   |
+| machine touches as few cache lines as possible. The fields used  |
+| once per frame or less come last, from a cache line of their     |
+| own. The machine is aligned to a cache line, so the CPU and the  |
+| hot fields start at the beginning of one.                        |
+'-----------------------------------------------------------------*/
+#define ZX_SPECTRUM_ALIGNMENT 64 /* cache line */
+#define ZX_SPECTRUM_ALIGNED   __attribute__((aligned(ZX_SPECTRUM_ALIGNMENT)))
+
+#define ZX_SPECTRUM_VALUES				\
+	Z80			cpu;			\
+							\
+	/* Hot: memory and I/O accesses */		\
+	zuint8*			memory;			\
+	zuint8*			memory_pages[4];	\
+	zuint8*			vram;			\
+	zuint64			clock;			\
+	zuint64			frame_start;		\
+	zuint64			audio_sample_step;	\
+							\
+	struct {zuint	line;				\
+		zuint64	next_line_cycle;		\
+	} screen;					\
 							\
-	zuint8			keyboard[8];		\
 	zuint32			border_color;		\
-	zsize			frame_cycles;		\
-	zsize			frames_since_flash;	\
+	zuint8			port_fe;		\
 	zint16			current_audio_sample;	\
 	zsize			audio_sample_index;	\
+	zint16*			audio_output_buffer;	\
+	zuint8*			audio_input_buffer;	\
 	zsize			audio_input_base_index;	\
-	zboolean		accurate;		\
 	ZZXSpectrumState	state;			\
-	const void*		screen_border;		\
-	const void*		cycles;			\
-	const void*		contention;		\
-	zuint8			port_fe;		\
-	zuint8			port_fe_update_cycle;	\
-	zuint8*			vram;			\
+							\
+	struct {ZContextRead32Bit next_pulse;		\
+		void*		context;		\
+		zuint64		next_edge_cycle;	\
+		zuint8		ear;			\
+	} tape;						\
+							\
+	/* Cold: once per frame or less */		\
+	struct {ZEmulatorRun run;			\
+	} ZX_SPECTRUM_ALIGNED cpu_abi;			\
+							\
+	void*			video_output_buffer;	\
+	zsize			frames_since_flash;	\
+	const ScreenBorder*	screen_border;		\
+	const Cycles*		cycles;			\
+	const Contention*	contention;		\
+	zuint64			port_fe_update_cycle;	\
+	zboolean		accurate;		\
+	zuint8			keyboard[8];		\
+							\
+	struct {ZXSpectrumEvent	array[ZX_SPECTRUM_MAXIMUM_EVENTS];	\
+		zuint		count;			\
+	} events;					\
+							\
+	struct {ZXSpectrumInput	array[ZX_SPECTRUM_MAXIMUM_INPUTS];	\
+		zuint		head;			\
+		zuint		count;			\
+	} input;					\
+							\
+	zuint8			joystick;		\
+	zuint8			joystick_interface;	\
+							\
+	struct {ZXSpectrumSaveBlock save_block;		\
+		void*		    context;		\
+	} tape_output;					\
 
-typedef struct {
+typedef struct ZX_SPECTRUM_ALIGNED {
 	ZX_SPECTRUM_VALUES
 } ZXSpectrum;
 
+typedef struct ZX_SPECTRUM_ALIGNED {
+	ZX_SPECTRUM_VALUES
+	zuint8		port_7ffd;
+	zboolean	disable_bank_switching;
+	void*		psg;
+
+	struct {
+	} psg_abi;
+} ZXSpectrum128K;
+
+Z_C_SYMBOLS_BEGIN
+
+zsize	 zx_spectrum_48k_cpu_run	(Z80*	     cpu,
+					 zsize	     cycles);
+
+zsize	 zx_spectrum_plus_128k_cpu_run	(Z80*	     cpu,
+					 zsize	     cycles);
+
+zboolean zx_spectrum_schedule		(ZXSpectrum* object,
+					 zuint64     cycle,
+					 ZContextDo  action);
+
+void	 zx_spectrum_update_screen	(ZXSpectrum* object);
+
+void	 zx_spectrum_input		(ZXSpectrum* object,
+					 zuint64     cycle,
+					 zuint8	     device,
+					 zuint8	     mask,
+					 zboolean    pressed);
+
+Z_C_SYMBOLS_END
+
+
+/*------------------------------------------------------------------.
+| The clock of the machine counts the cycles elapsed since it was   |
+| initialized, up to the start of the current CPU run; while the    |
+| CPU runs, the current time is that plus the cycles of the run. It |
+| is shared by all the devices, so their timings can be compared    |
+| directly.                                                         |
+'------------------------------------------------------------------*/
+Z_INLINE zuint64 zx_spectrum_now(ZXSpectrum *object)
+	{return object->clock + object->cpu.cycles;}
+
+
+/*-----------------------------------------------------------------.
+| The screen is drawn lazily: the scanlines are only drawn when    |
+| something they show is about to change (the border color, the    |
+| video RAM or its bank) or when the frame ends. Every scanline    |
+| due by then is drawn with the state it had at its time.          |
+'-----------------------------------------------------------------*/
+Z_INLINE void zx_spectrum_synchronize_screen(ZXSpectrum *object)
+	{
+	if (zx_spectrum_now(object) >= object->screen.next_line_cycle)
+		zx_spectrum_update_screen(object);
+	}
+
+
+/*-----------------------------------------------------------------.
+| Memory accesses are defined here so that both the callbacks and  |
+| the copies of the CPU core compiled for each machine inline the  |
+| same code.                                                       |
+'-----------------------------------------------------------------*/
+
+Z_INLINE zuint8 zx_spectrum_48k_cpu_read(ZXSpectrum *object, zuint16 address)
+	{return object->memory[address];}
+
+
+Z_INLINE void zx_spectrum_48k_cpu_write(
+	ZXSpectrum*	object,
+	zuint16		address,
+	zuint8		value
+)
+	{
+	if (address > 0x3FFF)
+		{
+		if (address < Z_ZX_SPECTRUM_ADDRESS_VIDEO_CHARACTER_RAM + ZX_SPECTRUM_VRAM_SIZE)
+			zx_spectrum_synchronize_screen(object);
+
+		object->memory[address] = value;
+		}
+	}
+
+
+Z_INLINE zuint8 zx_spectrum_plus_128k_cpu_read(ZXSpectrum128K *object, zuint16 address)
+	{return object->memory_pages[address >> 14][address & 0x3FFF];}
+
+
+Z_INLINE void zx_spectrum_plus_128k_cpu_write(
+	ZXSpectrum128K*	object,
+	zuint16		address,
+	zuint8		value
+)
+	{
+	zuint8 *target;
+
+	if (address > 0x3FFF)
+		{
+		target = object->memory_pages[address >> 14] + (address & 0x3FFF);
+
+		if (target >= object->vram && target < object->vram + ZX_SPECTRUM_VRAM_SIZE)
+			zx_spectrum_synchronize_screen((ZXSpectrum *)object);
+
+		*target = value;
+		}
+	}
+
+
+#endif /* __mZX_emulators_ZX_Spectrum_H */
@@ -1,6 +1,8 @@
 SOURCES += \
 	$$P_SOURCES/common/emulators/Z80.c \
 	"$$P_SOURCES/common/emulators/ZX Spectrum.c" \
+	"$$P_SOURCES/common/emulators/ZX Spectrum 48K CPU.c" \
+	"$$P_SOURCES/common/emulators/ZX Spectrum 128K CPU.c" \
 
 HEADERS += \
 	$$P_SOURCES/common/emulators/Z80.h \
@@ -28,9 +28,6 @@
 	//-------------'
 	//QTripleBuffer*	_videoOutputBuffer;
 	//QRingBuffer*		_audioOutputBuffer;
-	Zeta::TripleBuffer*	_keyboardBuffer;
-	Z64Bit*			_keyboard;
-	Z64Bit			_keyboardState;
 
 	BOOL			_smooth;
 	IBOutlet GLVideoView*	_videoOutputView;
@@ -54,11 +54,7 @@ using namespace Zeta;
 			//_audioOutput = [[ALOutputPlayer alloc] init];
 
 
-			_keyboardBuffer = new TripleBuffer(malloc(Z_UINT64_SIZE * 3), Z_UINT64_SIZE);
-			_keyboard = (Z64Bit *)_keyboardBuffer->production_buffer();
-			memset(_keyboardBuffer->buffers[0], 0xFF, Z_UINT64_SIZE * 3);
-
-			_machine = new Machine(_abi, _videoOutputView.buffer, _audioOutputPlayer->buffer(), _keyboardBuffer);
+			_machine = new Machine(_abi, _videoOutputView.buffer, _audioOutputPlayer->buffer());
 
 			/*-----------------.
 			| Load needed ROMs |
@@ -79,7 +75,6 @@ using namespace Zeta;
 				_machine->write_memory(rom->base_address, (void *)[ROM bytes], rom->size);
 				}
 
-			_keyboardState.value_uint64 = Type<Zeta::UInt64>::maximum;
 			_attachInputBuffer = NO;
 
 		[_videoOutputView start];